@@ -0,0 +1,122 @@
+#include <cassert>
+
+#include "aet.h"
+
+aet::aet()
+    : last{}, clock{}, requests{}, open_requests{}, open_bytes{},
+      total_bytes{}, reused_requests(BINS), reused_bytes(BINS), hits(BINS)
+{
+}
+
+size_t aet::bin_of(uint64_t time)
+{
+  assert(time > 0);
+  if (time < (1u << SUB_BITS))
+    return time;
+  const unsigned shift = 63 - __builtin_clzll(time) - SUB_BITS;
+  return ((shift + 1) << SUB_BITS) + (time >> shift) - (1u << SUB_BITS);
+}
+
+uint64_t aet::bin_start(size_t b)
+{
+  const size_t octave = b >> SUB_BITS;
+  if (octave == 0)
+    return b;
+  const uint64_t mantissa = (1u << SUB_BITS) + (b & ((1u << SUB_BITS) - 1));
+  return mantissa << (octave - 1);
+}
+
+bool aet::access(uint32_t kid, int32_t size, size_t weight, bool warmup)
+{
+  ++clock;
+  requests += weight;
+
+  last_access *previous = last.find(kid);
+  const bool reused = previous != nullptr;
+  if (reused)
+  {
+    const size_t b = bin_of(clock - previous->time);
+    const double bytes = double(previous->size) * previous->weight;
+    reused_requests[b] += previous->weight;
+    reused_bytes[b] += bytes;
+    open_requests -= previous->weight;
+    open_bytes -= bytes;
+    total_bytes -= previous->size;
+    if (!warmup)
+      hits[b] += weight;
+  }
+  else
+  {
+    previous = &last[kid];
+  }
+
+  previous->time = clock;
+  previous->size = size;
+  previous->weight = weight;
+  open_requests += weight;
+  open_bytes += double(size) * weight;
+  total_bytes += size;
+  return reused;
+}
+
+void aet::remove(uint32_t kid)
+{
+  const last_access *a = last.find(kid);
+  if (!a)
+    return;
+  open_requests -= a->weight;
+  open_bytes -= double(a->size) * a->weight;
+  requests -= a->weight;
+  total_bytes -= a->size;
+  last.erase(kid);
+}
+
+void aet::fill(hit_rate_curve &bytes_curve,
+               hit_rate_curve &objects_curve) const
+{
+  if (requests <= 0)
+    return;
+
+  size_t end = BINS;
+  while (end > 0 && hits[end - 1] == 0)
+    --end;
+
+  // Weighted Requests and bytes of the Requests whose key is next requested
+  // more than k Requests later, for k at the start of the bin; every reuse
+  // time is at least 1.
+  double later_requests = open_requests;
+  for (double r : reused_requests)
+    later_requests += r;
+  double later_bytes = open_bytes;
+  for (double bytes : reused_bytes)
+    later_bytes += bytes;
+
+  // c(t) in objects and in bytes at the start of the bin.
+  double objects = 0;
+  double footprint = 0;
+  for (size_t b = 0; b < end; ++b)
+  {
+    const double width = double(bin_start(b + 1) - bin_start(b));
+    // Reuse times are taken to be spread evenly over the bin, so for k in
+    // the bin a share of its own Requests is still to be reused.
+    const double share = (width - 1) / (2 * width);
+    const double after_requests = later_requests - reused_requests[b];
+    const double after_bytes = later_bytes - reused_bytes[b];
+    const double mean_objects =
+        (after_requests + reused_requests[b] * share) / requests;
+    const double mean_bytes = (after_bytes + reused_bytes[b] * share) / requests;
+
+    if (hits[b])
+    {
+      const double o = objects + (width - 1) / 2 * mean_objects;
+      const double d = footprint + (width - 1) / 2 * mean_bytes;
+      objects_curve.hit(o >= 1 ? size_t(o) - 1 : 0, hits[b]);
+      bytes_curve.hit(d >= 1 ? size_t(d) - 1 : 0, hits[b]);
+    }
+
+    objects += width * mean_objects;
+    footprint += width * mean_bytes;
+    later_requests = after_requests;
+    later_bytes = after_bytes;
+  }
+}
@@ -0,0 +1,86 @@
+#ifndef AET_H
+#define AET_H
+
+#include <cinttypes>
+#include <cstddef>
+
+#include "hit_rate_curve.h"
+#include "key_map.h"
+#include "mem_usage.h"
+
+// Byte-weighted Average Eviction Time model of an LRU cache (Hu et al.,
+// USENIX ATC '16), for approximate miss ratio curves without a stack.
+//
+// Only the reuse time of each Request, the Requests since the last one for
+// the same key, is recorded, in a histogram of log-linear bins. A Request
+// k Requests back is still the last one for its key if its key was not
+// reused within k Requests, so with S(k) the mean bytes of Requests whose
+// next reuse is more than k Requests later, the bytes of the keys requested
+// in the last t Requests are about c(t) = S(0) + ... + S(t - 1). A reuse
+// after t Requests is then a hit at a distance of c(t) bytes. Counting
+// Requests instead of their bytes gives the distance in objects.
+//
+// The clock counts every Request, so reuse times are those of the full
+// trace even if only the Requests of sampled keys are recorded, and c(t)
+// needs no scaling. Memory is the per-key clocks of the keys recorded and a
+// fixed number of bins.
+class aet
+{
+public:
+  aet();
+
+  // Counts a Request that is not recorded.
+  void skip() { ++clock; }
+
+  // Records a Request for \a kid of \a size bytes counted with \a weight;
+  // its hit is only counted outside warmup.
+  //
+  // @return - true if \a kid was requested before.
+  bool access(uint32_t kid, int32_t size, size_t weight, bool warmup);
+
+  // Forgets \a kid, which is no longer recorded.
+  void remove(uint32_t kid);
+
+  // @return - the bytes and the number of the keys recorded.
+  size_t bytes() const { return total_bytes; }
+  size_t keys() const { return last.size(); }
+
+  // Adds the modeled hits to \a bytes_curve and \a objects_curve, at
+  // distances counted like those of shadowlru: one less than the bytes or
+  // objects through the key.
+  void fill(hit_rate_curve &bytes_curve, hit_rate_curve &objects_curve) const;
+
+private:
+  // Reuse times below 2^SUB_BITS have a bin each; above, every power of two
+  // is split into 2^SUB_BITS bins.
+  static const unsigned SUB_BITS = 4;
+  static const size_t BINS = (64 - SUB_BITS + 1) << SUB_BITS;
+
+  static size_t bin_of(uint64_t time);
+  // @return - the lowest reuse time in bin \a b.
+  static uint64_t bin_start(size_t b);
+
+  struct last_access
+  {
+    uint64_t time = 0;
+    int32_t size = 0;
+    uint64_t weight = 0;
+  };
+
+  key_map<last_access> last;
+  uint64_t clock;
+  // Weighted Requests recorded, and weighted Requests and bytes of those
+  // still the last for their key.
+  double requests;
+  double open_requests;
+  double open_bytes;
+  size_t total_bytes;
+  // Per bin: weighted Requests and bytes of the Requests whose key was next
+  // requested that many Requests later, and weighted hits counted outside
+  // warmup.
+  counted_vector<double, mem_tag::distances> reused_requests;
+  counted_vector<double, mem_tag::distances> reused_bytes;
+  counted_vector<size_t, mem_tag::distances> hits;
+};
+
+#endif
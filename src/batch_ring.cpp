@@ -0,0 +1,96 @@
+#include <algorithm>
+#include <cassert>
+#include <limits>
+
+#include "batch_ring.h"
+
+namespace {
+
+// Position of a consumer that has left; never holds up the producer.
+const uint64_t LEFT = std::numeric_limits<uint64_t>::max();
+
+} // namespace
+
+batch_ring::batch_ring(size_t consumers, size_t slots, size_t batch_size)
+    : slots(slots), positions(consumers), published{}, closed{false},
+      mutex{}, batch_published{}, batch_released{}
+{
+  assert(slots > 0);
+  for (slot &s : this->slots)
+    s.requests.resize(batch_size);
+}
+
+uint64_t batch_ring::oldest_unreleased() const
+{
+  uint64_t oldest = published;
+  for (uint64_t pos : positions)
+    oldest = std::min(oldest, pos);
+  return oldest;
+}
+
+std::vector<Request> &batch_ring::begin_fill()
+{
+  std::unique_lock<std::mutex> lock{mutex};
+  batch_released.wait(lock, [this] {
+    return published - oldest_unreleased() < slots.size();
+  });
+  return slots[published % slots.size()].requests;
+}
+
+void batch_ring::publish(size_t n)
+{
+  {
+    std::lock_guard<std::mutex> lock{mutex};
+    slots[published % slots.size()].n = n;
+    ++published;
+  }
+  batch_published.notify_all();
+}
+
+void batch_ring::close()
+{
+  {
+    std::lock_guard<std::mutex> lock{mutex};
+    closed = true;
+  }
+  batch_published.notify_all();
+}
+
+bool batch_ring::has_consumers()
+{
+  std::lock_guard<std::mutex> lock{mutex};
+  return std::any_of(positions.begin(), positions.end(),
+                     [](uint64_t pos) { return pos != LEFT; });
+}
+
+const Request *batch_ring::acquire(size_t consumer, size_t *n)
+{
+  std::unique_lock<std::mutex> lock{mutex};
+  uint64_t &pos = positions[consumer];
+  assert(pos != LEFT);
+  batch_published.wait(lock, [&] { return pos < published || closed; });
+  if (pos == published)
+    return nullptr;
+
+  const slot &s = slots[pos % slots.size()];
+  *n = s.n;
+  return s.requests.data();
+}
+
+void batch_ring::release(size_t consumer)
+{
+  {
+    std::lock_guard<std::mutex> lock{mutex};
+    ++positions[consumer];
+  }
+  batch_released.notify_one();
+}
+
+void batch_ring::leave(size_t consumer)
+{
+  {
+    std::lock_guard<std::mutex> lock{mutex};
+    positions[consumer] = LEFT;
+  }
+  batch_released.notify_one();
+}
@@ -0,0 +1,75 @@
+#ifndef BATCH_RING_H
+#define BATCH_RING_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "request.h"
+
+// Broadcasts batches of Requests from one producer to a fixed set of
+// consumers. Every consumer sees every batch, in order, through a read-only
+// pointer into the ring; a slot is only refilled once all consumers have
+// released it, so the trace is parsed once however many consumers there are
+// and the fastest consumer can run at most #slots batches ahead of the
+// slowest one.
+class batch_ring
+{
+public:
+  batch_ring(size_t consumers, size_t slots, size_t batch_size);
+
+  // Producer side.
+
+  // Waits until the next slot is free and returns it to be filled.
+  std::vector<Request> &begin_fill();
+
+  // Hands the first \a n Requests of the slot from begin_fill() to the
+  // consumers.
+  void publish(size_t n);
+
+  // No more batches will be published.
+  void close();
+
+  // @return - false once every consumer has left.
+  bool has_consumers();
+
+  // Consumer side.
+
+  // Waits for the next batch of \a consumer.
+  //
+  // @return - the batch, with its length in \a n, or nullptr once the ring
+  //   is closed and the consumer has seen every batch.
+  const Request *acquire(size_t consumer, size_t *n);
+
+  // Gives back the batch from the last acquire().
+  void release(size_t consumer);
+
+  // \a consumer won't read any more batches; the producer stops waiting
+  // for it.
+  void leave(size_t consumer);
+
+private:
+  struct slot
+  {
+    slot() : requests{}, n{} {}
+
+    std::vector<Request> requests;
+    size_t n;
+  };
+
+  // @return - the oldest batch some consumer has not released yet.
+  uint64_t oldest_unreleased() const;
+
+  std::vector<slot> slots;
+  std::vector<uint64_t> positions; // next batch of each consumer
+  uint64_t published;
+  bool closed;
+
+  std::mutex mutex;
+  std::condition_variable batch_published;
+  std::condition_variable batch_released;
+};
+
+#endif
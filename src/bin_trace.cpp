@@ -0,0 +1,168 @@
+#include <iostream>
+#include <cstring>
+#include <cstdlib>
+#include <cassert>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "bin_trace.h"
+
+bool is_bin_trace(const std::string &path)
+{
+  std::ifstream in{path, std::ios::binary};
+  char magic[sizeof(BIN_TRACE_MAGIC)] = {};
+  if (!in.read(magic, sizeof(magic)))
+    return false;
+  return memcmp(magic, BIN_TRACE_MAGIC, sizeof(magic)) == 0;
+}
+
+bin_trace_writer::bin_trace_writer(const std::string &path,
+                                   uint64_t block_records)
+    : out{path, std::ios::binary | std::ios::trunc}, header{}, blocks{},
+      finished{false}
+{
+  if (!out.is_open())
+  {
+    std::cerr << "Couldn't open " << path << " for writing" << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  assert(block_records > 0);
+
+  memcpy(header.magic, BIN_TRACE_MAGIC, sizeof(header.magic));
+  header.version = BIN_TRACE_VERSION;
+  header.record_size = sizeof(bin_trace_record);
+  header.block_records = block_records;
+
+  // Placeholder; rewritten with the real counts by finish().
+  write_header();
+}
+
+bin_trace_writer::~bin_trace_writer()
+{
+  if (!finished)
+    finish();
+}
+
+void bin_trace_writer::append(const Request &r)
+{
+  if (header.num_records % header.block_records == 0)
+    blocks.push_back(bin_trace_block{header.num_records, 0, r.time, r.time});
+
+  bin_trace_block &blk = blocks.back();
+  ++blk.num_records;
+  if (r.time < blk.min_time)
+    blk.min_time = r.time;
+  if (r.time > blk.max_time)
+    blk.max_time = r.time;
+
+  bin_trace_record rec{};
+  rec.time = r.time;
+  rec.kid = r.kid;
+  rec.appid = r.appid;
+  rec.key_sz = r.key_sz;
+  rec.val_sz = r.val_sz;
+  rec.type = uint8_t(r.type);
+  rec.hit = r.hit;
+  out.write(reinterpret_cast<const char *>(&rec), sizeof(rec));
+
+  ++header.num_records;
+}
+
+void bin_trace_writer::finish()
+{
+  header.num_blocks = blocks.size();
+  header.index_offset = sizeof(bin_trace_header) +
+                        header.num_records * sizeof(bin_trace_record);
+  out.write(reinterpret_cast<const char *>(blocks.data()),
+            blocks.size() * sizeof(bin_trace_block));
+
+  out.seekp(0);
+  write_header();
+  out.close();
+  finished = true;
+}
+
+void bin_trace_writer::write_header()
+{
+  out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+}
+
+bin_trace_file::bin_trace_file(const std::string &path)
+    : base{nullptr}, length{}, header{nullptr}, records{nullptr},
+      blocks{nullptr}
+{
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+  {
+    std::cerr << "Couldn't open binary trace " << path << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) != 0 || size_t(st.st_size) < sizeof(bin_trace_header))
+  {
+    std::cerr << "Binary trace " << path << " is truncated" << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  length = st.st_size;
+
+  base = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (base == MAP_FAILED)
+  {
+    std::cerr << "Couldn't mmap binary trace " << path << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  const char *bytes = static_cast<const char *>(base);
+  header = reinterpret_cast<const bin_trace_header *>(bytes);
+  if (memcmp(header->magic, BIN_TRACE_MAGIC, sizeof(header->magic)) == 0 &&
+      header->version < BIN_TRACE_VERSION)
+  {
+    std::cerr << "Binary trace " << path << " is from an older version; "
+              << "convert the CSV again with csv2bin" << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  if (memcmp(header->magic, BIN_TRACE_MAGIC, sizeof(header->magic)) != 0 ||
+      header->version != BIN_TRACE_VERSION ||
+      header->record_size != sizeof(bin_trace_record))
+  {
+    std::cerr << "Binary trace " << path << " has an unsupported format "
+              << "(version " << header->version << ")" << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  if (header->index_offset + header->num_blocks * sizeof(bin_trace_block) >
+          length ||
+      header->index_offset <
+          sizeof(bin_trace_header) +
+              header->num_records * sizeof(bin_trace_record))
+  {
+    std::cerr << "Binary trace " << path << " is truncated" << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  records = reinterpret_cast<const bin_trace_record *>(
+      bytes + sizeof(bin_trace_header));
+  blocks = reinterpret_cast<const bin_trace_block *>(
+      bytes + header->index_offset);
+
+  madvise(base, length, MADV_SEQUENTIAL);
+}
+
+bin_trace_file::~bin_trace_file()
+{
+  if (base)
+    munmap(base, length);
+}
+
+void bin_trace_file::will_need(uint64_t first, uint64_t count) const
+{
+  const long page = sysconf(_SC_PAGESIZE);
+  uintptr_t start = reinterpret_cast<uintptr_t>(records + first);
+  uintptr_t end = reinterpret_cast<uintptr_t>(records + first + count);
+  start &= ~uintptr_t(page - 1);
+  madvise(reinterpret_cast<void *>(start), end - start, MADV_WILLNEED);
+}
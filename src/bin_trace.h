@@ -0,0 +1,150 @@
+#ifndef BIN_TRACE_H
+#define BIN_TRACE_H
+
+#include <cinttypes>
+#include <cstddef>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "request.h"
+
+// Compact binary trace format. A converted trace is a header, followed by
+// fixed-width records in trace order, followed by a block index. Records are
+// grouped into blocks of #block_records consecutive records; the index holds
+// one entry per block with its position and time range so readers can skip
+// around without touching the records themselves.
+//
+// If the converter was asked to (csv2bin -d) kids are replaced by dense ids
+// 0..num_keys-1 in order of first appearance, so policies can keep per-key
+// state in flat tables instead of hash maps. num_keys is 0 otherwise.
+//
+// All fields are stored in host (little-endian) byte order; converted traces
+// are not meant to be moved between machines of different endianness.
+//
+//   +--------------------+ 0
+//   | bin_trace_header   |
+//   +--------------------+ sizeof(bin_trace_header)
+//   | bin_trace_record   |
+//   | ...  num_records   |
+//   +--------------------+ index_offset
+//   | bin_trace_block    |
+//   | ...  num_blocks    |
+//   +--------------------+
+
+static const char BIN_TRACE_MAGIC[8] = {'L', 'S', 'M', 'T', 'R', 'A', 'C', 'E'};
+static const uint32_t BIN_TRACE_VERSION = 2;
+static const uint64_t BIN_TRACE_BLOCK_RECORDS = 64 * 1024;
+
+struct bin_trace_header
+{
+  char magic[8];
+  uint32_t version;
+  uint32_t record_size;   // sizeof(bin_trace_record) of the writer
+  uint64_t num_records;
+  uint64_t block_records; // records per block (the last may be short)
+  uint64_t num_blocks;
+  uint64_t index_offset;  // byte offset of the first bin_trace_block
+  uint64_t num_keys;      // kids are dense in [0, num_keys); 0 if not
+};
+
+// One trace line. Same fields as the CSV, see README for their meaning.
+struct bin_trace_record
+{
+  double time;
+  uint32_t kid;
+  uint32_t appid;
+  int32_t key_sz;
+  int32_t val_sz;
+  uint8_t type;
+  uint8_t hit;
+  uint8_t pad[6];
+};
+
+struct bin_trace_block
+{
+  uint64_t first_record;
+  uint64_t num_records;
+  double min_time;
+  double max_time;
+};
+
+static_assert(sizeof(bin_trace_header) == 56, "bin_trace_header layout");
+static_assert(sizeof(bin_trace_record) == 32, "bin_trace_record layout");
+static_assert(sizeof(bin_trace_block) == 32, "bin_trace_block layout");
+
+// Returns true if the file at \a path starts with the binary trace magic.
+bool is_bin_trace(const std::string &path);
+
+// Streams records into a binary trace file. Records must be appended in
+// trace order; finish() writes the block index and the final header.
+class bin_trace_writer
+{
+public:
+  bin_trace_writer(const std::string &path,
+                   uint64_t block_records = BIN_TRACE_BLOCK_RECORDS);
+  ~bin_trace_writer();
+
+  void append(const Request &r);
+  void finish();
+
+  // Records that every kid appended is below \a num_keys.
+  void set_num_keys(uint64_t num_keys) { header.num_keys = num_keys; }
+
+  uint64_t get_num_records() const { return header.num_records; }
+
+private:
+  void write_header();
+
+  std::ofstream out;
+  bin_trace_header header;
+  std::vector<bin_trace_block> blocks;
+  bool finished;
+
+  bin_trace_writer(const bin_trace_writer &) = delete;
+  bin_trace_writer &operator=(const bin_trace_writer &) = delete;
+};
+
+// Read-only view of a binary trace mapped into memory. Records are handed
+// out in place; nothing is allocated per record.
+class bin_trace_file
+{
+public:
+  explicit bin_trace_file(const std::string &path);
+  ~bin_trace_file();
+
+  uint64_t get_num_records() const { return header->num_records; }
+  uint64_t get_num_blocks() const { return header->num_blocks; }
+  uint64_t get_num_keys() const { return header->num_keys; }
+
+  const bin_trace_record &record(uint64_t i) const { return records[i]; }
+  const bin_trace_block &block(uint64_t i) const { return blocks[i]; }
+
+  // Advises the kernel that records [first, first + count) will be read
+  // sequentially soon.
+  void will_need(uint64_t first, uint64_t count) const;
+
+  static void to_request(const bin_trace_record &rec, Request *r)
+  {
+    r->time = rec.time;
+    r->appid = rec.appid;
+    r->type = Request::req_type(rec.type);
+    r->key_sz = rec.key_sz;
+    r->val_sz = rec.val_sz;
+    r->frag_sz = 0;
+    r->kid = rec.kid;
+    r->hit = rec.hit;
+  }
+
+private:
+  void *base;
+  size_t length;
+  const bin_trace_header *header;
+  const bin_trace_record *records;
+  const bin_trace_block *blocks;
+
+  bin_trace_file(const bin_trace_file &) = delete;
+  bin_trace_file &operator=(const bin_trace_file &) = delete;
+};
+
+#endif
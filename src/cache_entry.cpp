@@ -0,0 +1,13 @@
+#include <iostream>
+
+#include "cache_entry.h"
+
+void cache_entry::dump() const
+{
+  std::cerr << "*** cache entry ***" << std::endl
+            << "time: " << get_time() << std::endl
+            << "app id: " << appid << std::endl
+            << "size: " << bytes << std::endl
+            << "frag size: " << frag_sz << std::endl
+            << "kid: " << kid << std::endl;
+}
@@ -0,0 +1,50 @@
+#ifndef CACHE_ENTRY_H
+#define CACHE_ENTRY_H
+
+#include <cinttypes>
+
+#include "request.h"
+
+// What the queue based policies (LRU, shadowlru, Partitioned_LRU, lsm and
+// lsc_multi) keep per resident object instead of a full Request: 20 bytes
+// instead of 40, which makes a std::list node 36 bytes instead of 56.
+//
+// Access times are stored as 32-bit ticks of 1/TICKS_PER_SEC seconds since
+// trace time 0, i.e. millisecond resolution over ~49 days of trace; times
+// outside that range saturate. Only lsm and lsc_multi look at them.
+struct cache_entry
+{
+  static constexpr double TICKS_PER_SEC = 1000.;
+
+  explicit cache_entry(const Request &r)
+      : kid{r.kid}, appid{r.appid}, bytes{r.size()}, frag_sz{r.frag_sz},
+        timestamp{to_ticks(r.time)}
+  {
+  }
+
+  int32_t size() const { return bytes; }
+  int32_t get_frag() const { return frag_sz; }
+  double get_time() const { return timestamp / TICKS_PER_SEC; }
+
+  static uint32_t to_ticks(double time)
+  {
+    const double ticks = time * TICKS_PER_SEC;
+    if (ticks <= 0.)
+      return 0;
+    if (ticks >= double(UINT32_MAX))
+      return UINT32_MAX;
+    return uint32_t(ticks);
+  }
+
+  void dump() const;
+
+  uint32_t kid;
+  uint32_t appid;
+  int32_t bytes;    // key_sz + val_sz
+  int32_t frag_sz;
+  uint32_t timestamp;
+};
+
+static_assert(sizeof(cache_entry) == 20, "cache_entry layout");
+
+#endif
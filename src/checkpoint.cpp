@@ -0,0 +1,100 @@
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#include "checkpoint.h"
+
+checkpoint_writer::checkpoint_writer(const std::string &path)
+    : path{path}, out{path, std::ios::binary | std::ios::trunc}
+{
+  if (!out.is_open())
+  {
+    std::cerr << "Couldn't open " << path << " for writing" << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  checkpoint_header header{};
+  memcpy(header.magic, CHECKPOINT_MAGIC, sizeof(header.magic));
+  header.version = CHECKPOINT_VERSION;
+  put(header);
+}
+
+void checkpoint_writer::put_string(const std::string &s)
+{
+  put(uint64_t(s.size()));
+  out.write(s.data(), s.size());
+}
+
+void checkpoint_writer::finish()
+{
+  out.flush();
+  if (!out)
+  {
+    std::cerr << "Couldn't write checkpoint " << path << std::endl;
+    exit(EXIT_FAILURE);
+  }
+}
+
+checkpoint_reader::checkpoint_reader(const std::string &path)
+    : path{path}, in{path, std::ios::binary}
+{
+  if (!in.is_open())
+  {
+    std::cerr << "Couldn't open checkpoint " << path << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  checkpoint_header header = get<checkpoint_header>();
+  if (memcmp(header.magic, CHECKPOINT_MAGIC, sizeof(header.magic)) != 0)
+  {
+    std::cerr << path << " is not a checkpoint" << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  if (header.version != CHECKPOINT_VERSION)
+  {
+    std::cerr << "Checkpoint " << path << " has an unsupported format "
+              << "version " << header.version << "; take it again"
+              << std::endl;
+    exit(EXIT_FAILURE);
+  }
+}
+
+std::string checkpoint_reader::get_string()
+{
+  std::string s(get<uint64_t>(), '\0');
+  if (!s.empty())
+    read(&s[0], s.size());
+  return s;
+}
+
+void checkpoint_reader::mismatch(const std::string &what) const
+{
+  std::cerr << "Checkpoint " << path << " was taken with a different "
+            << what << std::endl;
+  exit(EXIT_FAILURE);
+}
+
+void checkpoint_reader::damaged() const
+{
+  std::cerr << "Checkpoint " << path << " is damaged" << std::endl;
+  exit(EXIT_FAILURE);
+}
+
+void checkpoint_reader::finish()
+{
+  if (in.peek() != std::ifstream::traits_type::eof())
+  {
+    std::cerr << "Checkpoint " << path << " has trailing data" << std::endl;
+    exit(EXIT_FAILURE);
+  }
+}
+
+void checkpoint_reader::read(void *dst, size_t n)
+{
+  in.read(static_cast<char *>(dst), n);
+  if (size_t(in.gcount()) != n)
+  {
+    std::cerr << "Checkpoint " << path << " is truncated" << std::endl;
+    exit(EXIT_FAILURE);
+  }
+}
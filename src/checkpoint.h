@@ -0,0 +1,107 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <cinttypes>
+#include <cstddef>
+#include <fstream>
+#include <string>
+#include <type_traits>
+
+// Binary snapshot of a simulation, written at the end of warmup (lsm-sim
+// -o) so later runs can start from it instead of warming up again (-i).
+//
+// A checkpoint is a short header followed by whatever the driver and the
+// Policy write, read back in the same order. Values are stored as their
+// in-memory bytes in host byte order, so like binary traces checkpoints are
+// not meant to be moved between machines or builds.
+//
+//   +--------------------+ 0
+//   | checkpoint_header  |
+//   +--------------------+
+//   | run parameters     |  trace, options the warmed state depends on
+//   | driver state       |  trace position, apps seen, Request count
+//   | Policy::save()     |  stats, queues, maps, segments, ...
+//   +--------------------+
+
+static const char CHECKPOINT_MAGIC[8] = {'L', 'S', 'M', 'C', 'K', 'P', 'N', 'T'};
+static const uint32_t CHECKPOINT_VERSION = 3;
+
+struct checkpoint_header
+{
+  char magic[8];
+  uint32_t version;
+  uint32_t pad;
+};
+
+class checkpoint_writer
+{
+public:
+  explicit checkpoint_writer(const std::string &path);
+
+  template <typename T>
+  void put(const T &value)
+  {
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "only plain values can be written as they are");
+    out.write(reinterpret_cast<const char *>(&value), sizeof(T));
+  }
+
+  void put_string(const std::string &s);
+
+  // Flushes the checkpoint; exits if anything could not be written.
+  void finish();
+
+private:
+  std::string path;
+  std::ofstream out;
+
+  checkpoint_writer(const checkpoint_writer &) = delete;
+  checkpoint_writer &operator=(const checkpoint_writer &) = delete;
+};
+
+class checkpoint_reader
+{
+public:
+  explicit checkpoint_reader(const std::string &path);
+
+  template <typename T>
+  T get()
+  {
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "only plain values can be read as they are");
+    typename std::aligned_storage<sizeof(T), alignof(T)>::type value;
+    read(&value, sizeof(T));
+    return *reinterpret_cast<T *>(&value);
+  }
+
+  std::string get_string();
+
+  // Reports that the checkpoint doesn't fit the run restoring it, e.g.
+  // because it was taken with other options, and exits.
+  [[noreturn]] void mismatch(const std::string &what) const;
+
+  // Reports that the checkpoint contradicts itself and exits.
+  [[noreturn]] void damaged() const;
+
+  // Reads a value and exits through mismatch() unless it equals \a expected.
+  template <typename T>
+  void expect(const T &expected, const std::string &what)
+  {
+    if (!(get<T>() == expected))
+      mismatch(what);
+  }
+
+  // Exits unless everything in the checkpoint has been read.
+  void finish();
+
+private:
+  void read(void *dst, size_t n);
+
+  std::string path;
+  std::ifstream in;
+
+  checkpoint_reader(const checkpoint_reader &) = delete;
+  checkpoint_reader &operator=(const checkpoint_reader &) = delete;
+};
+
+#endif
@@ -1,11 +1,9 @@
 #include <iostream>
 #include "clock.h"
 
-size_t CLOCK_MAX_VALUE = 15;
-
 Clock::Clock(stats stat) : Policy(stat),
 						   clockLru(),
-						   allObjects(),
+						   allObjects(stat.key_space),
 						   lruSize(0),
 						   noZeros(0),
 						   firstEviction(false),
@@ -24,10 +22,12 @@ size_t Clock::process_request(const Request *r, bool warmup)
 		stat.accesses++;
 	}
 
+	phase_timer lookup{profile.get(), phase::lookup};
 	auto searchRKId = allObjects.find(r->kid);
-	if (searchRKId != allObjects.end()) // 请求对象存在
+	lookup.stop();
+	if (searchRKId) // 请求对象存在
 	{
-		Clock::ClockItem &item = searchRKId->second;
+		Clock::ClockItem &item = *searchRKId;
 		ClockLru::iterator &clockItemIt = item.clockLruIt;
 
 		if (r->size() == item.size) // 请求大小与对象大小相同
@@ -36,7 +36,7 @@ size_t Clock::process_request(const Request *r, bool warmup)
 			{
 				stat.hits++;
 			}
-			clockItemIt->second = CLOCK_MAX_VALUE; // 重置对象的clock值
+			clockItemIt->second = stat.config.clock_max_value; // 重置对象的clock值
 			return 1;
 		}
 		else // 对象大小有变化，更新
@@ -64,6 +64,7 @@ size_t Clock::process_request(const Request *r, bool warmup)
 	assert((size_t)newItem.size <= stat.global_mem);
 
 	// 缓存空间不足，驱逐直到空间足够
+	phase_timer evict{profile.get(), phase::evict};
 	while (lruSize + newItem.size > stat.global_mem)
 	{
 		// 标记为已经进行了至少一次驱逐
@@ -77,7 +78,7 @@ size_t Clock::process_request(const Request *r, bool warmup)
 		// 移动clock指针进行遍历
 		while (clockIt != clockLru.end())
 		{
-			assert(clockIt->second <= CLOCK_MAX_VALUE);
+			assert(clockIt->second <= stat.config.clock_max_value);
 			// 若当前对象的clock值为0，则删除
 			if (clockIt->second == 0)
 			{
@@ -100,7 +101,7 @@ size_t Clock::process_request(const Request *r, bool warmup)
 		{
 			// 从头开始遍历到start位置
 			clockIt = clockLru.begin();
-			assert(clockIt->second <= CLOCK_MAX_VALUE);
+			assert(clockIt->second <= stat.config.clock_max_value);
 			while (clockIt != startIt)
 			{
 				if (clockIt->second == 0)
@@ -134,12 +135,13 @@ size_t Clock::process_request(const Request *r, bool warmup)
 		// 删除之后，将clock指针指向下一个对象
 		clockIt = (tmpIt == clockLru.end()) ? clockLru.begin() : tmpIt;
 	}
+	evict.stop();
 
 	// 插入新对象
 	std::pair<uint32_t, size_t> p;
 	// 若已经进行了至少一次驱逐，则将新对象的clock值设为CLOCK_MAX_VALUE
 	p = firstEviction
-			? std::make_pair(newItem.kId, CLOCK_MAX_VALUE)
+			? std::make_pair(newItem.kId, stat.config.clock_max_value)
 			: std::make_pair(newItem.kId, (size_t)0);
 	if (clockLru.size() == 0)
 	{
@@ -159,12 +161,27 @@ size_t Clock::process_request(const Request *r, bool warmup)
 	return PROC_MISS;
 }
 
+// 批量处理请求
+// Prefetches the objects and clock entries of upcoming requests (see
+// prefetch.h).
+void Clock::process_batch(const Request *begin, size_t n, bool warmup)
+{
+	pipeline_batch(n,
+		[&](size_t i) { allObjects.prefetch(begin[i].kid); },
+		[&](size_t i) {
+			const ClockItem *item = allObjects.find(begin[i].kid);
+			if (item)
+				prefetch(&*item->clockLruIt);
+		},
+		[&](size_t i) { process_request(&begin[i], warmup); });
+}
+
 // 删除一个对象
 void Clock::deleteItem(uint32_t keyId)
 {
 	auto searchRKId = allObjects.find(keyId);
-	assert(searchRKId != allObjects.end());
-	Clock::ClockItem &item = searchRKId->second;
+	assert(searchRKId);
+	Clock::ClockItem &item = *searchRKId;
 	clockLru.erase(item.clockLruIt);
 	lruSize -= item.size;
 	allObjects.erase(keyId);
@@ -178,10 +195,10 @@ void Clock::dump_stats(void)
 	{
 		appId = app;
 	}
-	std::string filename{stat.policy + "-app" + std::to_string(appId) + "-globalMemory" + std::to_string(stat.global_mem) + "-clockMaxValue" + std::to_string(CLOCK_MAX_VALUE)};
+	std::string filename{stat.policy + "-app" + std::to_string(appId) + "-globalMemory" + std::to_string(stat.global_mem) + "-clockMaxValue" + std::to_string(stat.config.clock_max_value)};
 	std::ofstream out{filename};
 	out << "global_mem " << stat.global_mem << std::endl;
-	out << "clock max value " << CLOCK_MAX_VALUE << std::endl;
+	out << "clock max value " << stat.config.clock_max_value << std::endl;
 	out << "#accesses " << stat.accesses << std::endl;
 	out << "#global hits " << stat.hits << std::endl;
 	out << "hit rate " << double(stat.hits) / stat.accesses << std::endl;
@@ -5,14 +5,13 @@
 #include <unordered_map>
 #include <cassert>
 #include "policy.h"
-
-extern size_t CLOCK_MAX_VALUE;
+#include "key_map.h"
 
 class Clock : public Policy
 {
 
 private:
-	typedef std::list<std::pair<uint32_t, size_t>> ClockLru;
+	typedef counted_list<std::pair<uint32_t, size_t>, mem_tag::queue> ClockLru;
 
 	struct ClockItem
 	{
@@ -24,7 +23,7 @@ private:
 	};
 
 	ClockLru clockLru;
-	std::unordered_map<uint32_t, ClockItem> allObjects;
+	key_map<ClockItem> allObjects;
 
 	size_t lruSize;
 	size_t noZeros;
@@ -38,6 +37,7 @@ public:
 	Clock(stats stat);
 	~Clock();
 	size_t process_request(const Request *r, bool warmup);
+	void process_batch(const Request *begin, size_t n, bool warmup);
 	size_t get_bytes_cached() const;
 	void dump_stats(void);
 };
@@ -0,0 +1,275 @@
+#include <iostream>
+#include <fstream>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <algorithm>
+
+#include <unistd.h>
+#include <zlib.h>
+#ifndef NOZSTD
+#include <zstd.h>
+#endif
+
+#include "compressed_trace_reader.h"
+
+namespace {
+
+const size_t INPUT_SIZE = 1024 * 1024;
+
+// Reads up to \a n compressed bytes; 0 at the end of the file.
+size_t read_input(int fd, char *dst, size_t n)
+{
+  ssize_t got = 0;
+  do
+  {
+    got = ::read(fd, dst, n);
+  } while (got < 0 && errno == EINTR);
+
+  if (got < 0)
+  {
+    std::cerr << "Couldn't read compressed trace: " << strerror(errno)
+              << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  return got;
+}
+
+class gzip_codec : public trace_codec
+{
+public:
+  explicit gzip_codec(int fd)
+      : fd{fd}, in(INPUT_SIZE), strm{}, in_eof{false}, done{false}
+  {
+    // 15 + 32: maximum window, accept both gzip and zlib headers.
+    if (inflateInit2(&strm, 15 + 32) != Z_OK)
+    {
+      std::cerr << "Couldn't initialize zlib" << std::endl;
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  ~gzip_codec() { inflateEnd(&strm); }
+
+  size_t decompress(char *out, size_t n)
+  {
+    strm.next_out = reinterpret_cast<Bytef *>(out);
+    strm.avail_out = n;
+    while (strm.avail_out > 0 && !done)
+    {
+      if (strm.avail_in == 0 && !in_eof)
+        refill();
+
+      int ret = inflate(&strm, Z_NO_FLUSH);
+      if (ret == Z_STREAM_END)
+      {
+        // Concatenated members (pigz, cat a.gz b.gz) continue the trace.
+        if (strm.avail_in == 0 && !in_eof)
+          refill();
+        if (strm.avail_in == 0)
+          done = true;
+        else
+          inflateReset(&strm);
+      }
+      else if (ret == Z_BUF_ERROR && in_eof && strm.avail_in == 0)
+      {
+        std::cerr << "Compressed trace is truncated" << std::endl;
+        exit(EXIT_FAILURE);
+      }
+      else if (ret != Z_OK && ret != Z_BUF_ERROR)
+      {
+        std::cerr << "Couldn't decompress trace: "
+                  << (strm.msg ? strm.msg : "zlib error") << std::endl;
+        exit(EXIT_FAILURE);
+      }
+    }
+    return n - strm.avail_out;
+  }
+
+private:
+  void refill()
+  {
+    size_t got = read_input(fd, in.data(), in.size());
+    in_eof = got == 0;
+    strm.next_in = reinterpret_cast<Bytef *>(in.data());
+    strm.avail_in = got;
+  }
+
+  int fd;
+  std::vector<char> in;
+  z_stream strm;
+  bool in_eof;
+  bool done;
+
+  gzip_codec(const gzip_codec &) = delete;
+  gzip_codec &operator=(const gzip_codec &) = delete;
+};
+
+#ifndef NOZSTD
+class zstd_codec : public trace_codec
+{
+public:
+  explicit zstd_codec(int fd)
+      : fd{fd}, in(ZSTD_DStreamInSize()), stream{ZSTD_createDStream()},
+        input{nullptr, 0, 0}, in_eof{false}, frame_left{0}
+  {
+    if (!stream || ZSTD_isError(ZSTD_initDStream(stream)))
+    {
+      std::cerr << "Couldn't initialize zstd" << std::endl;
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  ~zstd_codec() { ZSTD_freeDStream(stream); }
+
+  size_t decompress(char *out, size_t n)
+  {
+    ZSTD_outBuffer output{out, n, 0};
+    while (output.pos < output.size)
+    {
+      if (input.pos == input.size && !in_eof)
+      {
+        size_t got = read_input(fd, in.data(), in.size());
+        in_eof = got == 0;
+        input = ZSTD_inBuffer{in.data(), got, 0};
+      }
+
+      // With the input exhausted this still flushes buffered output.
+      size_t before = output.pos;
+      size_t ret = ZSTD_decompressStream(stream, &output, &input);
+      if (ZSTD_isError(ret))
+      {
+        std::cerr << "Couldn't decompress trace: " << ZSTD_getErrorName(ret)
+                  << std::endl;
+        exit(EXIT_FAILURE);
+      }
+
+      if (in_eof && input.pos == input.size && output.pos == before)
+      {
+        if (frame_left != 0)
+        {
+          std::cerr << "Compressed trace is truncated" << std::endl;
+          exit(EXIT_FAILURE);
+        }
+        break;
+      }
+      frame_left = ret;
+    }
+    return output.pos;
+  }
+
+private:
+  int fd;
+  std::vector<char> in;
+  ZSTD_DStream *stream;
+  ZSTD_inBuffer input;
+  bool in_eof;
+  size_t frame_left;  // 0 once the last frame decoded has been flushed
+
+  zstd_codec(const zstd_codec &) = delete;
+  zstd_codec &operator=(const zstd_codec &) = delete;
+};
+#endif
+
+} // namespace
+
+trace_compression detect_trace_compression(const std::string &path)
+{
+  std::ifstream in{path, std::ios::binary};
+  unsigned char magic[4] = {};
+  if (!in.read(reinterpret_cast<char *>(magic), sizeof(magic)))
+    return trace_compression::NONE;
+
+  if (magic[0] == 0x1f && magic[1] == 0x8b)
+    return trace_compression::GZIP;
+  if (magic[0] == 0x28 && magic[1] == 0xb5 && magic[2] == 0x2f &&
+      magic[3] == 0xfd)
+    return trace_compression::ZSTD;
+  return trace_compression::NONE;
+}
+
+compressed_trace_reader::compressed_trace_reader(const std::string &path,
+                                                 trace_compression kind)
+    : csv_trace_reader{path}, codec{}, buffers{}, drain{}, mutex{}, filled{},
+      drained{}, stopping{false}, decompressor{}
+{
+  if (kind == trace_compression::GZIP)
+  {
+    codec.reset(new gzip_codec{fd});
+  }
+  else
+  {
+#ifdef NOZSTD
+    std::cerr << "Trace " << path << " is zstd compressed; rebuild with "
+              << "ZSTD=yes to read it" << std::endl;
+    exit(EXIT_FAILURE);
+#else
+    codec.reset(new zstd_codec{fd});
+#endif
+  }
+
+  decompressor = std::thread{&compressed_trace_reader::decompress_loop, this};
+}
+
+compressed_trace_reader::~compressed_trace_reader()
+{
+  {
+    std::lock_guard<std::mutex> lock{mutex};
+    stopping = true;
+  }
+  drained.notify_one();
+  decompressor.join();
+}
+
+void compressed_trace_reader::decompress_loop()
+{
+  size_t next = 0;
+  for (;;)
+  {
+    buffer &b = buffers[next];
+    {
+      std::unique_lock<std::mutex> lock{mutex};
+      drained.wait(lock, [&] { return stopping || !b.full; });
+      if (stopping)
+        return;
+    }
+
+    b.len = codec->decompress(b.data.data(), b.data.size());
+    b.pos = 0;
+    {
+      std::lock_guard<std::mutex> lock{mutex};
+      b.full = true;
+    }
+    filled.notify_one();
+
+    if (b.len == 0)
+      return;
+    next ^= 1;
+  }
+}
+
+size_t compressed_trace_reader::fill(char *dst, size_t n)
+{
+  buffer &b = buffers[drain];
+  {
+    std::unique_lock<std::mutex> lock{mutex};
+    filled.wait(lock, [&] { return b.full; });
+  }
+  // The final, empty buffer is never handed back, so this keeps returning 0.
+  if (b.len == 0)
+    return 0;
+
+  size_t take = std::min(n, b.len - b.pos);
+  memcpy(dst, b.data.data() + b.pos, take);
+  b.pos += take;
+  if (b.pos == b.len)
+  {
+    {
+      std::lock_guard<std::mutex> lock{mutex};
+      b.full = false;
+    }
+    drained.notify_one();
+    drain ^= 1;
+  }
+  return take;
+}
@@ -0,0 +1,72 @@
+#ifndef COMPRESSED_TRACE_READER_H
+#define COMPRESSED_TRACE_READER_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "trace_reader.h"
+
+enum class trace_compression { NONE, GZIP, ZSTD };
+
+// Identifies a compressed trace by its magic bytes.
+trace_compression detect_trace_compression(const std::string &path);
+
+// Streaming decompressor over an open file descriptor.
+class trace_codec
+{
+public:
+  virtual ~trace_codec() {}
+
+  // Decompresses up to \a n bytes into \a out.
+  //
+  // @return - number of bytes produced; 0 at the end of the input.
+  virtual size_t decompress(char *out, size_t n) = 0;
+};
+
+// Reads a gzip or zstd compressed CSV trace without a decompressed copy on
+// disk. A dedicated thread decompresses into one of two buffers while the
+// simulation thread parses the other, so decompression overlaps with the
+// simulation instead of adding to it.
+class compressed_trace_reader : public csv_trace_reader
+{
+public:
+  compressed_trace_reader(const std::string &path, trace_compression kind);
+  ~compressed_trace_reader();
+
+protected:
+  size_t fill(char *dst, size_t n);
+
+private:
+  static constexpr size_t BUFFER_SIZE = 4 * 1024 * 1024;
+
+  struct buffer
+  {
+    buffer() : data(BUFFER_SIZE), len{}, pos{}, full{false} {}
+
+    std::vector<char> data;
+    size_t len;  // decompressed bytes in data; 0 marks the end of the trace
+    size_t pos;  // bytes already handed to fill()
+    bool full;
+  };
+
+  void decompress_loop();
+
+  std::unique_ptr<trace_codec> codec;
+  buffer buffers[2];
+  size_t drain;  // buffer fill() is reading from
+  std::mutex mutex;
+  std::condition_variable filled;
+  std::condition_variable drained;
+  bool stopping;
+  std::thread decompressor;
+
+  compressed_trace_reader(const compressed_trace_reader &) = delete;
+  compressed_trace_reader &operator=(const compressed_trace_reader &) = delete;
+};
+
+#endif
@@ -1,13 +1,15 @@
 #ifndef FIFO_H
 #define FIFO_H
 
+#include "mem_usage.h"
 #include "policy.h"
 #include <unordered_map>
 #include <list>
 
 class fifo : public Policy
 {
-  typedef std::unordered_map<uint32_t, Request *> hash_map;
+  typedef counted_unordered_map<uint32_t, Request *, mem_tag::hash_index>
+      hash_map;
 
 public:
   fifo(stats stat);
@@ -20,7 +22,7 @@ private:
   uint32_t current_size; // the current number of bytes in eviction queue
 
   hash_map hash;
-  std::list<Request> queue;
+  counted_list<Request, mem_tag::queue> queue;
 };
 
 #endif
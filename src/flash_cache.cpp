@@ -3,21 +3,19 @@
 #include <fstream>
 #include "flash_cache.h"
 
-size_t DRAM_SIZE = 51209600;
-size_t FLASH_SIZE = 51209600;
-double K = 1;
-size_t L_FC = 1;
-double P_FC = 0.3;
-
 // #define COMPARE_TIME
 // #define RELATIVE
 
-FlashCache::FlashCache(stats stat) : Policy(stat),
+FlashCache::FlashCache(stats stat) : FlashCache(stat, stat.key_space)
+{
+}
+
+FlashCache::FlashCache(stats stat, size_t key_space) : Policy(stat),
 									 dram(),
 									 dramLru(),
 									 flash(),
 									 globalLru(),
-									 allObjects(),
+									 allObjects(key_space),
 									 credits(0),
 									 lastCreditUpdate(0),
 									 dramSize(0),
@@ -42,6 +40,7 @@ size_t FlashCache::process_request(const Request *r, bool warmup)
 	counter++;
 
 	double currTime = r->time;
+	phase_timer credits_timer{profile.get(), phase::credits};
 	updateCredits(currTime);
 
 #ifdef COMPARE_TIME
@@ -49,9 +48,12 @@ size_t FlashCache::process_request(const Request *r, bool warmup)
 #else
 	updateDramFlashiness();
 #endif
+	credits_timer.stop();
 
+	phase_timer lookup{profile.get(), phase::lookup};
 	auto searchRKId = allObjects.find(r->kid);
-	if (searchRKId != allObjects.end())
+	lookup.stop();
+	if (searchRKId)
 	{
 		/*
 		 * The object exists in flashCache system. If the sizes of the
@@ -61,7 +63,7 @@ size_t FlashCache::process_request(const Request *r, bool warmup)
 		 * If it is in the cache, one needs as well to update the
 		 * 'flashiness' value and its place in the dram MFU and dram LRU
 		 */
-		FlashCache::Item &item = searchRKId->second;
+		FlashCache::Item &item = *searchRKId;
 		// 对象大小没改变
 		if (r->size() == item.size)
 		{
@@ -69,6 +71,7 @@ size_t FlashCache::process_request(const Request *r, bool warmup)
 			{
 				stat.hits++;
 			}
+			phase_timer promote{profile.get(), phase::promote};
 			// 将对象移动到全局lru列表头部
 			globalLru.erase(item.globalLruIt);
 			globalLru.emplace_front(item.kId);
@@ -104,6 +107,7 @@ size_t FlashCache::process_request(const Request *r, bool warmup)
 					stat.hits_flash++;
 				}
 			}
+			promote.stop();
 			item.lastAccessInTrace = counter;
 			item.last_accessed = currTime;
 			lastCreditUpdate = r->time;
@@ -145,16 +149,18 @@ size_t FlashCache::process_request(const Request *r, bool warmup)
 	newItem.isInDram = true;
 	newItem.last_accessed = r->time;
 	newItem.lastAccessInTrace = counter;
-	assert(((unsigned int)newItem.size) <= DRAM_SIZE);
+	assert(((unsigned int)newItem.size) <= stat.config.dram_size);
 	// 循环：
 	// dram中有空间，则直接插入;空间不足，则首先判断是否能将flashiness最大的对象插入flash
 	// 若已没有能插入flash的对象，则驱逐DRAM中的对象
 	// 将flashiness最大的对象插入flash时，若flash空间不足，则驱逐全局lru队列末尾的对象
+	phase_timer evict{profile.get(), phase::evict};
 	while (true)
 	{
 		// 若DRAM中有足够空间，直接插入
-		if (newItem.size + dramSize <= DRAM_SIZE)
+		if (newItem.size + dramSize <= stat.config.dram_size)
 		{
+			evict.stop();
 #ifdef RELATIVE
 			// 插入到flashiness队列指定头部位置
 			dramAddFirst(newItem);
@@ -189,7 +195,7 @@ size_t FlashCache::process_request(const Request *r, bool warmup)
 				stat.credit_limit++;
 			}
 			// 驱逐直到有足够空间
-			while (newItem.size + dramSize > DRAM_SIZE)
+			while (newItem.size + dramSize > stat.config.dram_size)
 			{
 				// 获取dram lru队列最后一个对象
 				uint32_t lruKid = dramLru.back();
@@ -208,7 +214,7 @@ size_t FlashCache::process_request(const Request *r, bool warmup)
 		else // credits足够，则将当前flashiness最大的对象插入flash
 		{
 			// 若flash中有足够空间，则直接插入
-			if (flashSize + mfuItem.size <= FLASH_SIZE)
+			if (flashSize + mfuItem.size <= stat.config.flash_size)
 			{
 				// 更新标记
 				mfuItem.isInDram = false;
@@ -276,10 +282,10 @@ void FlashCache::updateDramFlashiness(const double &currTime)
 	// 实际时间戳过了多久
 	double elapsed_secs = currTime - lastCreditUpdate;
 	// 时间差越大，mul越小，从1逐渐趋近于0
-	mul = exp(-elapsed_secs / K);
+	mul = exp(-elapsed_secs / stat.config.k);
 #else
 	assert(currTime == -1);
-	mul = exp(-1 / K);
+	mul = exp(-1 / stat.config.k);
 #endif
 	// 遍历flashiness队列，更新flashiness
 	for (dramIt it = dram.begin(); it != dram.end(); it++)
@@ -303,11 +309,11 @@ double FlashCache::hitCredit(const Item &item, const double &currTime) const
 #endif
 	assert(diff != 0);
 	// 距离上一次访问的时间间隔越大，mul越小
-	double mul = exp(-diff / K);
+	double mul = exp(-diff / stat.config.k);
 	// 时间间隔越大，访问频率越小，越适合插入flash
 	// flashiness增加量越大
 	// (1/diff)*e^{-diff}
-	return ((1 - mul) * (L_FC / diff));
+	return ((1 - mul) * (stat.config.l_fc / diff));
 }
 
 void FlashCache::dramAdd(const std::pair<uint32_t, double> &p,
@@ -384,10 +390,10 @@ void FlashCache::dump_stats(void)
 #else
 						 + "-place"
 #endif
-						 + "-app" + std::to_string(appId) + "-flash_mem" + std::to_string(FLASH_SIZE) + "-dram_mem" + std::to_string(DRAM_SIZE) + "-K" + std::to_string(K)};
+						 + "-app" + std::to_string(appId) + "-flash_mem" + std::to_string(stat.config.flash_size) + "-dram_mem" + std::to_string(stat.config.dram_size) + "-K" + std::to_string(stat.config.k)};
 	std::ofstream out{filename};
-	out << "dram size " << DRAM_SIZE << std::endl;
-	out << "flash size " << FLASH_SIZE << std::endl;
+	out << "dram size " << stat.config.dram_size << std::endl;
+	out << "flash size " << stat.config.flash_size << std::endl;
 	out << "initial credit " << INITIAL_CREDIT << std::endl;
 	out << "#credits per sec " << FLASH_RATE << std::endl;
 #ifdef COMPARE_TIME
@@ -399,7 +405,7 @@ void FlashCache::dump_stats(void)
 #ifdef RELATIVE
 	out << "P_FC " << P_FC << std::endl;
 #endif
-	out << "K " << K << std::endl;
+	out << "K " << stat.config.k << std::endl;
 	out << "#accesses " << stat.accesses << std::endl;
 	out << "#global hits " << stat.hits << std::endl;
 	out << "#dram hits " << stat.hits_dram << std::endl;
@@ -416,3 +422,94 @@ void FlashCache::dump_stats(void)
 		out << it->first << "," << it->second << std::endl;
 	}
 }
+
+// 保存/恢复检查点：先保存所有对象，再按顺序保存四个队列，恢复时重建对象在各队列中的位置
+void FlashCache::save(checkpoint_writer &w) const
+{
+	stat.save(w);
+	w.put(credits);
+	w.put(lastCreditUpdate);
+	w.put(dramSize);
+	w.put(flashSize);
+	w.put(counter);
+
+	w.put(uint64_t(allObjects.size()));
+	allObjects.for_each([&w](uint32_t kid, const Item &item) {
+		w.put(item.kId);
+		w.put(item.size);
+		w.put(item.last_accessed);
+		w.put(item.lastAccessInTrace);
+		w.put(item.isInDram);
+	});
+
+	w.put(uint64_t(dram.size()));
+	for (const auto &p : dram)
+	{
+		w.put(p.first);
+		w.put(p.second);
+	}
+	for (const key_list *keys : {&dramLru, &flash, &globalLru})
+	{
+		w.put(uint64_t(keys->size()));
+		for (uint32_t kid : *keys)
+			w.put(kid);
+	}
+}
+
+void FlashCache::restore(checkpoint_reader &r)
+{
+	stat.restore(r);
+	credits = r.get<double>();
+	lastCreditUpdate = r.get<double>();
+	dramSize = r.get<size_t>();
+	flashSize = r.get<size_t>();
+	counter = r.get<size_t>();
+
+	allObjects = key_map<Item>(stat.key_space);
+	const uint64_t items = r.get<uint64_t>();
+	for (uint64_t i = 0; i < items; ++i)
+	{
+		Item item{};
+		item.kId = r.get<uint32_t>();
+		item.size = r.get<int32_t>();
+		item.last_accessed = r.get<double>();
+		item.lastAccessInTrace = r.get<size_t>();
+		item.isInDram = r.get<bool>();
+		allObjects[item.kId] = item;
+	}
+
+	// Finds the Item a queue entry refers to.
+	auto lookup = [&](uint32_t kid) -> Item & {
+		Item *item = allObjects.find(kid);
+		if (!item)
+			r.damaged();
+		return *item;
+	};
+
+	dram.clear();
+	const uint64_t dram_items = r.get<uint64_t>();
+	for (uint64_t i = 0; i < dram_items; ++i)
+	{
+		const uint32_t kid = r.get<uint32_t>();
+		dram.emplace_back(kid, r.get<double>());
+		lookup(kid).dramLocation = --dram.end();
+	}
+	key_list *keys[] = {&dramLru, &flash, &globalLru};
+	for (key_list *list : keys)
+	{
+		list->clear();
+		const uint64_t n = r.get<uint64_t>();
+		for (uint64_t i = 0; i < n; ++i)
+		{
+			const uint32_t kid = r.get<uint32_t>();
+			list->emplace_back(kid);
+			Item &item = lookup(kid);
+			if (list == &dramLru)
+				item.dramLruIt = --list->end();
+			else if (list == &flash)
+				item.flashIt = --list->end();
+			else
+				item.globalLruIt = --list->end();
+		}
+	}
+}
@@ -7,18 +7,15 @@
 #include <list>
 #include <cassert>
 #include "policy.h"
+#include "key_map.h"
 
 /*
- * These parameters define how many bytes the DRAM
- * and flash can hold. These parametrs can be changed
+ * How many bytes the DRAM and flash can hold, K and L_FC come from
+ * stats::config.
  */
-extern size_t DRAM_SIZE;
-extern size_t FLASH_SIZE;
 const size_t FLASH_RATE = 1024 * 1024;
 const size_t INITIAL_CREDIT = 1;
-extern double K;
-extern size_t L_FC;
-extern double P_FC;
+const double P_FC = 0.3;
 
 // 维护一个全局lru队列，一个dram lru队列，一个dram flashiness队列，一个flash队列
 // 从dram中驱逐时，若能够将flashiness值最大的对象移动到flash中，则优先进行移动
@@ -28,8 +25,10 @@ extern double P_FC;
 class FlashCache : public Policy
 {
 protected:
-	typedef std::list<std::pair<uint32_t, double>>::iterator dramIt;
-	typedef std::list<uint32_t>::iterator keyIt;
+	typedef counted_list<std::pair<uint32_t, double>, mem_tag::queue> dram_list;
+	typedef counted_list<uint32_t, mem_tag::queue> key_list;
+	typedef dram_list::iterator dramIt;
+	typedef key_list::iterator keyIt;
 
 	struct Item
 	{
@@ -47,12 +46,12 @@ protected:
 				 isInDram(true), dramLocation(), dramLruIt(), flashIt(), globalLruIt() {}
 	};
 
-	std::list<std::pair<uint32_t, double>> dram; // dram flashiness队列
-	std::list<uint32_t> dramLru;				 // dram lru队列
-	std::list<uint32_t> flash;					 // flash队列
-	std::list<uint32_t> globalLru;				 // 全局lru队列
+	dram_list dram;		// dram flashiness队列
+	key_list dramLru;	// dram lru队列
+	key_list flash;		// flash队列
+	key_list globalLru; // 全局lru队列
 
-	std::unordered_map<uint32_t, Item> allObjects; // 全局哈希索引
+	key_map<Item> allObjects; // 全局哈希索引
 	/*
 	 * One can move objects from the DRAM to the flash only if he has enough
 	 * credits. Number of current credits should be higher then the object
@@ -79,12 +78,20 @@ protected:
 	void dramAddFirst(Item &item);
 	friend class VictimCache;
 
+	// For subclasses that keep their own index and leave allObjects empty;
+	// \a key_space sizes allObjects (see stats::key_space).
+	FlashCache(stats stat, size_t key_space);
+
 public:
 	FlashCache(stats stat);
 	~FlashCache();
 	size_t process_request(const Request *r, bool warmup);
 	size_t get_bytes_cached() const;
 	void dump_stats(void);
+
+	bool can_checkpoint() const { return true; }
+	void save(checkpoint_writer &w) const;
+	void restore(checkpoint_reader &r);
 };
 
 #endif
@@ -3,14 +3,6 @@
 #include <fstream>
 #include "flash_cache_lruk.h"
 
-size_t FC_K_LRU = 8;
-size_t DRAM_SIZE_FC_KLRU = 51209600;					  // dram总空间
-size_t FC_KLRU_QUEUE_SIZE = DRAM_SIZE_FC_KLRU / FC_K_LRU; // 每个lru队列的大小
-size_t FLASH_SIZE_FC_KLRU = 51209600;
-double K_FC_KLRU = 1;
-size_t L_FC_KLRU = 1;
-double P_FC_KLRU = 0.3;
-
 // #define COMPARE_TIME
 // #define RELATIVE
 
@@ -171,12 +163,12 @@ size_t FlashCacheLruk::process_request(const Request *r, bool warmup)
 	newItem.last_accessed = r->time;
 	newItem.lastAccessInTrace = counter;
 
-	assert(((unsigned int)newItem.size) <= DRAM_SIZE_FC_KLRU);
+	assert(((unsigned int)newItem.size) <= stat.config.dram_size);
 
 	while (true)
 	{
 		// 若dram中有足够空间，直接插入dram
-		if (newItem.size + dramSize <= DRAM_SIZE_FC_KLRU)
+		if (newItem.size + dramSize <= stat.config.dram_size)
 		{
 			// If we have place in the dram insert the new item to the beginning of the last queue.
 
@@ -235,7 +227,7 @@ size_t FlashCacheLruk::process_request(const Request *r, bool warmup)
 		// We can write items to the flash
 
 		// 若flash空间足够，将MRU对象插入到flash
-		if (flashSize + mfuItem.size <= FLASH_SIZE_FC_KLRU)
+		if (flashSize + mfuItem.size <= stat.config.flash_size)
 		{
 			// If we have enough space in the flash, we will insert the MRU item
 			// to the flash
@@ -382,7 +374,7 @@ void FlashCacheLruk::dramAddandReorder(std::vector<uint32_t> &objects,
 	}
 	else // 若为第一个队列，直接驱逐
 	{
-		while (sum + dramSize > DRAM_SIZE_FC_KLRU)
+		while (sum + dramSize > stat.config.dram_size)
 		{
 			// shouldnt get to here
 			assert(0);
@@ -446,10 +438,10 @@ void FlashCacheLruk::dump_stats(void)
 #else
 						 + "-place"
 #endif
-						 + "-app" + std::to_string(appId) + "-flash_mem" + std::to_string(FLASH_SIZE_FC_KLRU) + "-dram_mem" + std::to_string(DRAM_SIZE_FC_KLRU) + "-K" + std::to_string(K_FC_KLRU)};
+						 + "-app" + std::to_string(appId) + "-flash_mem" + std::to_string(stat.config.flash_size) + "-dram_mem" + std::to_string(stat.config.dram_size) + "-K" + std::to_string(K_FC_KLRU)};
 	std::ofstream out{filename};
-	out << "dram size " << DRAM_SIZE_FC_KLRU << std::endl;
-	out << "flash size " << FLASH_SIZE_FC_KLRU << std::endl;
+	out << "dram size " << stat.config.dram_size << std::endl;
+	out << "flash size " << stat.config.flash_size << std::endl;
 	out << "initial credit " << LRUK_INITIAL_CREDIT << std::endl;
 	out << "#credits per sec " << LRUK_FLASH_RATE << std::endl;
 #ifdef COMPARE_TIME
@@ -9,18 +9,16 @@
 #include "policy.h"
 
 /*
- * These parameters define how many bytes the DRAM
- * and flash can hold. These parametrs can be changed
+ * How many bytes the DRAM and flash can hold come from stats::config. The
+ * DRAM queues are sized for the default DRAM size.
  */
-extern size_t FC_K_LRU;
-extern size_t FC_KLRU_QUEUE_SIZE;
-extern size_t DRAM_SIZE_FC_KLRU;
-extern size_t FLASH_SIZE_FC_KLRU;
+const size_t FC_K_LRU = 8;
+const size_t FC_KLRU_QUEUE_SIZE = 51209600 / FC_K_LRU; // 每个lru队列的大小
 const size_t LRUK_FLASH_RATE = 1024 * 1024;
 const size_t LRUK_INITIAL_CREDIT = 1;
-extern double K_FC_KLRU;
-extern size_t L_FC_KLRU;
-extern double P_FC_KLRU;
+const double K_FC_KLRU = 1;
+const size_t L_FC_KLRU = 1;
+const double P_FC_KLRU = 0.3;
 
 typedef std::list<std::pair<uint32_t, double>>::iterator dramIt;
 typedef std::list<uint32_t>::iterator keyIt;
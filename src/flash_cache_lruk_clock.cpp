@@ -3,13 +3,8 @@
 #include <fstream>
 #include "flash_cache_lruk_clock.h"
 
-size_t FC_K_LRU_CLK = 8;
-size_t DRAM_SIZE_FC_KLRU_CLK = 51209600;
-size_t FC_KLRU_QUEUE_SIZE_CLK = DRAM_SIZE_FC_KLRU_CLK / FC_K_LRU_CLK;
-size_t FLASH_SIZE_FC_KLRU_CLK = 51209600;
-size_t CLOCK_MAX_VALUE_KLRU = 7;
-size_t CLOCK_JUMP = 2;
-int MIN_QUEUE_TO_MOVE_TO_FLASH = 6;
+static const size_t CLOCK_JUMP = 2;
+static const int MIN_QUEUE_TO_MOVE_TO_FLASH = 6;
 
 FlashCacheLrukClk::FlashCacheLrukClk(stats stat) : Policy(stat),
 												   dram(FC_K_LRU_CLK),
@@ -60,9 +55,9 @@ size_t FlashCacheLrukClk::process_request(const Request *r, bool warmup)
 
 			// reseting the clock
 			// 增加clock值，若超过最大值，则置为最大值
-			if (item.clockJumpStatus + CLOCK_JUMP > CLOCK_MAX_VALUE_KLRU)
+			if (item.clockJumpStatus + CLOCK_JUMP > stat.config.clock_max_value_klru)
 			{
-				item.clockJumpStatus = CLOCK_MAX_VALUE_KLRU;
+				item.clockJumpStatus = stat.config.clock_max_value_klru;
 			}
 			else
 			{
@@ -172,7 +167,7 @@ size_t FlashCacheLrukClk::process_request(const Request *r, bool warmup)
 		dramIt tmpIt, startIt = clockIt;
 
 		// 若DRAM空间足够，插入到DRAM中
-		if (newItem.size + dramSize <= DRAM_SIZE_FC_KLRU_CLK)
+		if (newItem.size + dramSize <= stat.config.dram_size)
 		{
 			// If we have place in the dram insert the new item to the beginning of the last queue.
 
@@ -212,7 +207,7 @@ size_t FlashCacheLrukClk::process_request(const Request *r, bool warmup)
 			assert(mfuItem.size > 0);
 
 			// 若flash空间足够，将MRU对象插入到flash
-			if (flashSize + mfuItem.size <= FLASH_SIZE_FC_KLRU_CLK)
+			if (flashSize + mfuItem.size <= stat.config.flash_size)
 			{
 				// If we have enough space in the flash, we will insert the MRU item
 				// to the flash
@@ -420,7 +415,7 @@ void FlashCacheLrukClk::dramAddandReorder(std::vector<uint32_t> &objects,
 	}
 	else // 若为第一个队列，直接驱逐，只是在lru-k中驱逐了，没有从dram中驱逐
 	{
-		while (sum + dramSize > DRAM_SIZE_FC_KLRU_CLK)
+		while (sum + dramSize > stat.config.dram_size)
 		{
 			// shouldnt get to here
 			assert(0);
@@ -500,11 +495,11 @@ void FlashCacheLrukClk::dump_stats(void)
 	{
 		appId = app;
 	}
-	std::string filename{stat.policy + "-app" + std::to_string(appId) + "-flash_mem" + std::to_string(FLASH_SIZE_FC_KLRU_CLK) + "-dram_mem" + std::to_string(DRAM_SIZE_FC_KLRU_CLK) + "-K" + std::to_string(FC_K_LRU_CLK)};
+	std::string filename{stat.policy + "-app" + std::to_string(appId) + "-flash_mem" + std::to_string(stat.config.flash_size) + "-dram_mem" + std::to_string(stat.config.dram_size) + "-K" + std::to_string(FC_K_LRU_CLK)};
 	std::ofstream out{filename};
 
-	out << "dram size " << DRAM_SIZE_FC_KLRU_CLK << std::endl;
-	out << "flash size " << FLASH_SIZE_FC_KLRU_CLK << std::endl;
+	out << "dram size " << stat.config.dram_size << std::endl;
+	out << "flash size " << stat.config.flash_size << std::endl;
 	out << "#accesses " << stat.accesses << std::endl;
 	out << "#global hits " << stat.hits << std::endl;
 	out << "#dram hits " << stat.hits_dram << std::endl;
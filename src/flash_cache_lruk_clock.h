@@ -9,14 +9,12 @@
 #include "policy.h"
 
 /*
- * These parameters define how many bytes the DRAM
- * and flash can hold. These parametrs can be changed
+ * How many bytes the DRAM and flash can hold and the maximum clock value
+ * come from stats::config. The DRAM queues are sized for the default DRAM
+ * size.
  */
-extern size_t FC_K_LRU_CLK;
-extern size_t FC_KLRU_QUEUE_SIZE_CLK;
-extern size_t DRAM_SIZE_FC_KLRU_CLK;
-extern size_t FLASH_SIZE_FC_KLRU_CLK;
-extern size_t CLOCK_MAX_VALUE_KLRU;
+const size_t FC_K_LRU_CLK = 8;
+const size_t FC_KLRU_QUEUE_SIZE_CLK = 51209600 / FC_K_LRU_CLK;
 const size_t LRUK_FLASH_RATE_CLK = 1024 * 1024;
 const size_t CLOCK_START_VAL = 3;
 
@@ -8,18 +8,13 @@
 #include <time.h>	/* time */
 #include <random>
 
-size_t FC_K_LRU_CLK_ML = 8;
-size_t DRAM_SIZE_FC_KLRU_CLK_ML = 51209600;
-size_t FC_KLRU_QUEUE_SIZE_CLK_ML = DRAM_SIZE_FC_KLRU_CLK_ML / FC_K_LRU_CLK_ML;
-size_t FLASH_SIZE_FC_KLRU_CLK_ML = 51209600;
-size_t CLOCK_MAX_VALUE_KLRU_ML = 7;
-int MIN_QUEUE_TO_MOVE_TO_FLASH_ML = 1;
-double ML_START_TIME = 0;
-double ML_END_TIME = 82799;
-double ML_TIME_TO_RUN_SVM = 86400;
-double ML_SVM_TH = 1;
-uint32_t APP_NUMBER = 0;
+static const int MIN_QUEUE_TO_MOVE_TO_FLASH_ML = 1;
+static const double ML_START_TIME = 0;
+static const double ML_END_TIME = 82799;
+static const double ML_TIME_TO_RUN_SVM = 86400;
 
+// The SVM module is loaded into the process-wide Python interpreter, so
+// only one instance of this policy can run at a time.
 PyObject *ML_SVMPredictFunction = NULL;
 PyObject *ML_myModuleString = NULL;
 PyObject *ML_myModule = NULL;
@@ -247,7 +242,7 @@ size_t FlashCacheLrukClkMachineLearning::process_request(const Request *r, bool
 		}
 		bool FoundMfu = false;
 
-		if (newItem.size + dramSize <= DRAM_SIZE_FC_KLRU_CLK_ML)
+		if (newItem.size + dramSize <= stat.config.dram_size)
 		{
 			// If we have place in the dram insert the new item to the beginning of the last queue.
 
@@ -318,7 +313,7 @@ size_t FlashCacheLrukClkMachineLearning::process_request(const Request *r, bool
 			size_t qN = mfuItem.queueNumber;
 			assert(mfuItem.size > 0);
 
-			if (flashSize + mfuItem.size <= FLASH_SIZE_FC_KLRU_CLK_ML)
+			if (flashSize + mfuItem.size <= stat.config.flash_size)
 			{
 				// If we have enough space in the flash, we will insert the MRU item
 				// to the flash
@@ -622,7 +617,7 @@ void FlashCacheLrukClkMachineLearning::ColectItemDataAndPredict(const Request *r
 			PyObject *args = PyTuple_Pack(6, PyFloat_FromDouble(dramitem.FirstHitTimePeriod), PyFloat_FromDouble(dramitem.AvgTimeBetweenhits),
 										  PyFloat_FromDouble(dramitem.TimeBetweenLastAction), PyFloat_FromDouble(dramitem.MaxTimeBetweenHits),
 										  //   PyFloat_FromDouble(dramitem.AmountOfHitsSinceArrivel), PyInt_FromLong((long)APP_NUMBER));
-										  PyFloat_FromDouble(dramitem.AmountOfHitsSinceArrivel), PyLong_FromLong((long)APP_NUMBER));
+										  PyFloat_FromDouble(dramitem.AmountOfHitsSinceArrivel), PyLong_FromLong((long)stat.config.app));
 			PyObject *myResult = PyObject_CallObject(ML_SVMPredictFunction, args);
 
 			// Predict the class labele for test data sample
@@ -643,7 +638,7 @@ void FlashCacheLrukClkMachineLearning::ColectItemDataAndPredict(const Request *r
 void FlashCacheLrukClkMachineLearning::SVMFunctionCalculation()
 {
 	// run the SVM calculation
-	std::string filename{"my_file" + std::to_string(APP_NUMBER) + ".csv"};
+	std::string filename{"my_file" + std::to_string(stat.config.app) + ".csv"};
 	std::ofstream out{filename};
 	PyObject *args = NULL;
 	PyObject *myResult = NULL;
@@ -657,7 +652,7 @@ void FlashCacheLrukClkMachineLearning::SVMFunctionCalculation()
 	{
 		int target = 0;
 		counter++;
-		if (SVMitem->r_AmountsOfHitsTillEviction > ML_SVM_TH)
+		if (SVMitem->r_AmountsOfHitsTillEviction > stat.config.svm_threshold)
 		{
 			target = 1;
 			ones_counter++;
@@ -671,7 +666,7 @@ void FlashCacheLrukClkMachineLearning::SVMFunctionCalculation()
 
 	// Calling the python function to calculate the SVM function
 	// args = PyTuple_Pack(1, PyInt_FromLong((long)APP_NUMBER));
-	args = PyTuple_Pack(1, PyLong_FromLong((long)APP_NUMBER));
+	args = PyTuple_Pack(1, PyLong_FromLong((long)stat.config.app));
 	PyObject_CallObject(ML_SVMFitFunction, args);
 
 	// update every item in allObjects
@@ -769,11 +764,11 @@ void FlashCacheLrukClkMachineLearning::ClockFindItemToErase(const Request *r __a
 void FlashCacheLrukClkMachineLearning::dump_stats(void)
 {
 
-	std::string filename{stat.policy + "-app" + std::to_string(APP_NUMBER)};
+	std::string filename{stat.policy + "-app" + std::to_string(stat.config.app)};
 	std::ofstream out{filename};
 
-	out << "dram size " << DRAM_SIZE_FC_KLRU_CLK_ML << std::endl;
-	out << "flash size " << FLASH_SIZE_FC_KLRU_CLK_ML << std::endl;
+	out << "dram size " << stat.config.dram_size << std::endl;
+	out << "flash size " << stat.config.flash_size << std::endl;
 	out << "#accesses " << stat.accesses << std::endl;
 	out << "#global hits " << stat.hits << std::endl;
 	out << "#dram hits " << stat.hits_dram << std::endl;
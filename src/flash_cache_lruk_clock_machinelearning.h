@@ -9,16 +9,13 @@
 #include "policy.h"
 
 /*
- * These parameters define how many bytes the DRAM
- * and flash can hold. These parametrs can be changed
+ * How many bytes the DRAM and flash can hold, the app whose model is used
+ * and the SVM threshold come from stats::config. The DRAM queues are sized
+ * for the default DRAM size.
  */
-extern size_t FC_K_LRU_CLK_ML;
-extern size_t FC_KLRU_QUEUE_SIZE_CLK_ML;
-extern size_t DRAM_SIZE_FC_KLRU_CLK_ML;
-extern size_t FLASH_SIZE_FC_KLRU_CLK_ML;
-extern size_t CLOCK_MAX_VALUE_KLRU_ML;
-extern uint32_t APP_NUMBER;
-extern double ML_SVM_TH;
+const size_t FC_K_LRU_CLK_ML = 8;
+const size_t FC_KLRU_QUEUE_SIZE_CLK_ML = 51209600 / FC_K_LRU_CLK_ML;
+const size_t CLOCK_MAX_VALUE_KLRU_ML = 7;
 
 class FlashCacheLrukClkMachineLearning : public Policy
 {
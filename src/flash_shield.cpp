@@ -8,15 +8,17 @@
 #include <time.h>   /* time */
 #include <random>
 
-size_t FLASH_SHILD_K_LRU_QUEUES = 8;
-size_t FLASH_SHILD_DRAM_SIZE = 51209600;
-size_t FLASH_SHILD_KLRU_QUEUE_SIZE = FLASH_SHILD_DRAM_SIZE / FLASH_SHILD_K_LRU_QUEUES;
-size_t FLASH_SHILD_FLASH_SIZE = 51209600;
-size_t FLASH_SHILD_CLOCK_MAX_VALUE = 7;
-int FLASH_SHILD_MIN_QUEUE_TO_MOVE_TO_FLASH = 0;
-
-uint32_t FLASH_SHILD_TH = 1;
-uint32_t FLASH_SHILD_APP_NUMBER = 0;
+// DRAM and flash sizes, the app whose model is used and the SVM threshold
+// come from stats::config. The DRAM queues are sized for the default DRAM
+// size.
+static const size_t FLASH_SHILD_K_LRU_QUEUES = 8;
+static const size_t FLASH_SHILD_KLRU_QUEUE_SIZE = 51209600 / FLASH_SHILD_K_LRU_QUEUES;
+static const size_t FLASH_SHILD_CLOCK_MAX_VALUE = 7;
+static const int FLASH_SHILD_MIN_QUEUE_TO_MOVE_TO_FLASH = 0;
+
+// The SVM module is loaded into the process-wide Python interpreter and the
+// state below is shared, so only one instance of this policy can run at a
+// time.
 bool DidntFindMFU = false;
 double NumberOfSetsOperations = 0;
 double SizeOfSetsOperations = 0;
@@ -40,7 +42,7 @@ PyObject *SVMLoadedFitFunction = NULL;
 static bool file_defined = false;
 static double lastRequest = 0;
 
-flashshield::flashshield(stats stat) : FlashCache(stat),
+flashshield::flashshield(stats stat) : FlashCache(stat, 0),
                                        flash{},
                                        allObjects{},
                                        maxBlocks{},
@@ -59,7 +61,7 @@ flashshield::flashshield(stats stat) : FlashCache(stat),
                                        svm_size(0),
                                        out{}
 {
-    maxBlocks = FLASH_SHILD_FLASH_SIZE / FLASH_SHILD_BLOCK_SIZE;
+    maxBlocks = stat.config.flash_size / FLASH_SHILD_BLOCK_SIZE;
 
     // Initialize SVM Functions
     Py_Initialize();
@@ -102,7 +104,7 @@ size_t flashshield::proc(const Request *r, bool warmup)
     bool updateWrites = true;
     // double currTime = r->time;
 
-    assert(dramSize + flashSize <= FLASH_SHILD_DRAM_SIZE + FLASH_SHILD_FLASH_SIZE * stat.threshold);
+    assert(dramSize + flashSize <= stat.config.dram_size + stat.config.flash_size * stat.threshold);
     auto searchRKId = allObjects.find(r->kid);
     if (searchRKId != allObjects.end())
     {
@@ -207,7 +209,7 @@ size_t flashshield::proc(const Request *r, bool warmup)
                         item.clockIt = Clkit;
                     }
 
-                    while (((double)(dramSize + flashSize) > (double)(FLASH_SHILD_DRAM_SIZE + (double)FLASH_SHILD_FLASH_SIZE * stat.threshold)))
+                    while (((double)(dramSize + flashSize) > (double)(stat.config.dram_size + (double)stat.config.flash_size * stat.threshold)))
                     {
                         uint32_t globalLruKid = ClockFindItemToErase(r);
                         flashshield::RItem &victimItem = allObjects[globalLruKid];
@@ -215,7 +217,7 @@ size_t flashshield::proc(const Request *r, bool warmup)
                         evict_item(victimItem, warmup, r);
                     }
 
-                    assert(dramSize + flashSize <= FLASH_SHILD_DRAM_SIZE + FLASH_SHILD_FLASH_SIZE * stat.threshold);
+                    assert(dramSize + flashSize <= stat.config.dram_size + stat.config.flash_size * stat.threshold);
                 }
             }
 
@@ -276,11 +278,11 @@ size_t flashshield::proc(const Request *r, bool warmup)
     newItem.LastAction = r->time;
 
     assert(((unsigned int)newItem.size) <= FLASH_SHILD_KLRU_QUEUE_SIZE);
-    assert(dramSize + flashSize <= FLASH_SHILD_DRAM_SIZE + FLASH_SHILD_FLASH_SIZE * stat.threshold);
+    assert(dramSize + flashSize <= stat.config.dram_size + stat.config.flash_size * stat.threshold);
 
     while (true)
     {
-        if ((newItem.size + dramSize <= FLASH_SHILD_DRAM_SIZE) && ((double)(dramSize + flashSize + newItem.size) <= (double)(FLASH_SHILD_DRAM_SIZE + (double)FLASH_SHILD_FLASH_SIZE * stat.threshold)))
+        if ((newItem.size + dramSize <= stat.config.dram_size) && ((double)(dramSize + flashSize + newItem.size) <= (double)(stat.config.dram_size + (double)stat.config.flash_size * stat.threshold)))
         {
             allObjects[newItem.kId] = newItem;
 
@@ -296,19 +298,19 @@ size_t flashshield::proc(const Request *r, bool warmup)
         assert(numBlocks <= maxBlocks);
 
         // Not enough space in DRAM, check flash
-        if ((double)(dramSize + flashSize + newItem.size) >= (double)(FLASH_SHILD_DRAM_SIZE + (double)FLASH_SHILD_FLASH_SIZE * stat.threshold))
+        if ((double)(dramSize + flashSize + newItem.size) >= (double)(stat.config.dram_size + (double)stat.config.flash_size * stat.threshold))
         {
             // If not enough space both in dram and in flash - evict item by global LRU (Clock)
             uint32_t globalLruKid = ClockFindItemToErase(r);
             flashshield::RItem &victimItem = allObjects[globalLruKid];
             assert(victimItem.size > 0);
             evict_item(victimItem, warmup, r);
-            assert(dramSize + flashSize <= FLASH_SHILD_DRAM_SIZE + FLASH_SHILD_FLASH_SIZE * stat.threshold);
+            assert(dramSize + flashSize <= stat.config.dram_size + stat.config.flash_size * stat.threshold);
         }
         else if (numBlocks == maxBlocks)
         {
             evict_block(--flash.end(), warmup, r);
-            assert(dramSize + flashSize <= FLASH_SHILD_DRAM_SIZE + FLASH_SHILD_FLASH_SIZE * stat.threshold);
+            assert(dramSize + flashSize <= stat.config.dram_size + stat.config.flash_size * stat.threshold);
         }
         else if (numBlocks < maxBlocks)
         { // If we have spce in flash for block- allocate block and move it to flash
@@ -435,7 +437,7 @@ void flashshield::evict_block(blockIt victim_block, bool warmup __attribute__((u
 
 void flashshield::allocate_flash_block(bool warmup, const Request *r)
 { // For every item in the sent list need to evict from dram and
-    assert(flashSize <= FLASH_SHILD_FLASH_SIZE);
+    assert(flashSize <= stat.config.flash_size);
 
     double SumOfMruObjects = 0;
     double AmountOfDataChecked = 0;
@@ -497,7 +499,7 @@ void flashshield::allocate_flash_block(bool warmup, const Request *r)
     {
         // If we don't find an MRU item to move to flash we will delete items from dram by LRU
         //--------dramLRU ---------------
-        while (dramSize + r->size() > FLASH_SHILD_DRAM_SIZE)
+        while (dramSize + r->size() > stat.config.dram_size)
         {
             uint32_t globalLruKid = dramLru.back();
             flashshield::RItem &victimItem = allObjects[globalLruKid];
@@ -561,7 +563,7 @@ void flashshield::allocate_flash_block(bool warmup, const Request *r)
     flashSize += curr_block.size;
 
     assert(numBlocks <= maxBlocks);
-    assert(flashSize <= FLASH_SHILD_FLASH_SIZE);
+    assert(flashSize <= stat.config.flash_size);
 
     if (!warmup)
     {
@@ -778,7 +780,7 @@ void flashshield::ColectItemDataAndPredict(const Request *r, bool warmup __attri
                                           PyFloat_FromDouble(dramitem.TimeBetweenLastAction), PyFloat_FromDouble(dramitem.MaxTimeBetweenHits),
                                           PyFloat_FromDouble(dramitem.AmountOfHitsSinceArrivel),
                                           //   PyInt_FromLong((long)FLASH_SHILD_APP_NUMBER), PyInt_FromLong((long)FLASH_SHILD_TH));
-                                          PyLong_FromLong((long)FLASH_SHILD_APP_NUMBER), PyLong_FromLong((long)FLASH_SHILD_TH));
+                                          PyLong_FromLong((long)stat.config.app), PyLong_FromLong((long)uint32_t(stat.config.svm_threshold)));
             PyObject *myResult = PyObject_CallObject(SVMPredictFunction, args);
 
             // Predict the class labele for test data sample
@@ -801,7 +803,7 @@ void flashshield::dump_stats(void)
 {
     // policy::dump_stats();
 
-    std::string filename{stat.policy + "-dramSize" + std::to_string(FLASH_SHILD_DRAM_SIZE) + "-flashSize" + std::to_string(FLASH_SHILD_FLASH_SIZE) + "-threshold" + std::to_string(FLASH_SHILD_TH)};
+    std::string filename{stat.policy + "-dramSize" + std::to_string(stat.config.dram_size) + "-flashSize" + std::to_string(stat.config.flash_size) + "-threshold" + std::to_string(uint32_t(stat.config.svm_threshold))};
 
     if (!file_defined)
     {
@@ -810,8 +812,8 @@ void flashshield::dump_stats(void)
     }
     out << "Last Request was at :" << std::setprecision(5) << lastRequest << std::endl;
 
-    out << "dram size " << FLASH_SHILD_DRAM_SIZE << std::endl;
-    out << "flash size " << FLASH_SHILD_FLASH_SIZE << std::endl;
+    out << "dram size " << stat.config.dram_size << std::endl;
+    out << "flash size " << stat.config.flash_size << std::endl;
     out << "#accesses " << stat.accesses << std::endl;
     out << "#global hits " << stat.hits << std::endl;
     out << "#dram hits " << stat.hits_dram << std::endl;
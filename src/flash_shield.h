@@ -9,11 +9,6 @@
 #include "policy.h"
 #include "flash_cache.h"
 
-extern  uint32_t FLASH_SHILD_APP_NUMBER;
-extern  size_t   FLASH_SHILD_DRAM_SIZE;
-extern  size_t   FLASH_SHILD_FLASH_SIZE;
-extern  uint32_t FLASH_SHILD_TH;
-
 class flashshield : public FlashCache {
 protected:
     struct Block;
@@ -121,6 +116,9 @@ public:
     ~flashshield();
     size_t proc(const Request *r, bool warmup);
     void dump_stats(void);
+
+    // Blocks and the SVM state aren't part of what FlashCache::save() writes.
+    bool can_checkpoint() const { return false; }
     
 };
 
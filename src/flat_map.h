@@ -0,0 +1,270 @@
+#ifndef FLAT_MAP_H
+#define FLAT_MAP_H
+
+#include <cassert>
+#include <cinttypes>
+#include <cstddef>
+#include <utility>
+
+#include "mem_usage.h"
+#include "prefetch.h"
+
+// Open addressing hash table from uint32_t kids to values of type V, for
+// key_map when kids are not dense.
+//
+// Slots hold the key, its probe distance and the value inline, so a lookup
+// usually touches a single cache line, where a std::unordered_map touches a
+// bucket and then a separately allocated node. Collisions are resolved with
+// Robin Hood probing: an insert takes the slot of any key that is closer to
+// its home slot than the inserted one, which keeps probe sequences short at
+// a high load factor and lets a lookup stop at the first key closer to home
+// than it would be. Erasing shifts the keys after it back by one slot
+// instead of leaving a tombstone.
+//
+// The table grows to twice its size at MAX_LOAD. Instead of rehashing every
+// key at once, the old table is kept, lookups check both, and every insert
+// and erase moves MIGRATE_STEP slots of the old table over, so no single
+// Request pays for a whole rehash.
+//
+// An insert or an erase may move any value: pointers returned by find() or
+// operator[] are only valid until the next insert or erase.
+template <typename V, mem_tag Tag>
+class flat_map
+{
+public:
+  flat_map() : current{}, old{}, migrated{} {}
+
+  // @return - the value for \a kid, or nullptr if it has none.
+  V *find(uint32_t kid)
+  {
+    V *value = current.find(kid);
+    if (!value && !old.empty())
+      value = old.find(kid);
+    return value;
+  }
+
+  const V *find(uint32_t kid) const
+  {
+    return const_cast<flat_map *>(this)->find(kid);
+  }
+
+  // Starts loading the slot a find() of \a kid starts at into the CPU
+  // caches.
+  void prefetch(uint32_t kid) const
+  {
+    current.prefetch(kid);
+    if (!old.empty())
+      old.prefetch(kid);
+  }
+
+  // @return - the value for \a kid, default constructing it if it has none.
+  V &operator[](uint32_t kid)
+  {
+    if (V *value = find(kid))
+      return *value;
+    if (current.full())
+    {
+      assert(old.empty());
+      old = std::move(current);
+      current = table{old.capacity() * 2};
+      migrated = 0;
+    }
+    migrate();
+    return current.insert(kid, V{});
+  }
+
+  // @return - true if \a kid had a value.
+  bool erase(uint32_t kid)
+  {
+    const bool erased = current.erase(kid) || old.erase(kid);
+    migrate();
+    return erased;
+  }
+
+  size_t size() const { return current.size() + old.size(); }
+  bool empty() const { return size() == 0; }
+
+  void clear()
+  {
+    current = table{};
+    old = table{};
+    migrated = 0;
+  }
+
+  // Calls f(kid, value) for every key with a value, in no particular order.
+  template <typename F>
+  void for_each(F f)
+  {
+    current.for_each(f);
+    old.for_each(f);
+  }
+
+private:
+  static const size_t MIN_CAPACITY = 16;
+  // Grow when this many eighths of the slots are taken.
+  static const size_t MAX_LOAD = 7;
+  // Slots of the old table moved over per insert or erase while growing;
+  // enough to finish before the new table could fill up.
+  static const size_t MIGRATE_STEP = 8;
+
+  struct slot
+  {
+    uint32_t key = 0;
+    // Probe distance from the key's home slot plus one; 0 if empty.
+    uint32_t distance = 0;
+    V value{};
+  };
+
+  class table
+  {
+  public:
+    table() : slots{}, mask{}, shift{}, count{} {}
+
+    explicit table(size_t capacity)
+        : slots(capacity < MIN_CAPACITY ? size_t(MIN_CAPACITY) : capacity),
+          mask{},
+          shift{64}, count{}
+    {
+      assert((slots.size() & (slots.size() - 1)) == 0);
+      mask = slots.size() - 1;
+      for (size_t c = slots.size(); c > 1; c >>= 1)
+        --shift;
+    }
+
+    size_t capacity() const { return slots.size(); }
+    size_t size() const { return count; }
+    bool empty() const { return slots.empty(); }
+    bool full() const
+    {
+      return slots.empty() || (count + 1) * 8 > slots.size() * MAX_LOAD;
+    }
+
+    V *find(uint32_t kid)
+    {
+      const size_t i = index(kid);
+      return i != NONE ? &slots[i].value : nullptr;
+    }
+
+    void prefetch(uint32_t kid) const
+    {
+      if (!slots.empty())
+        ::prefetch(&slots[home(kid)]);
+    }
+
+    // Inserts \a kid, which must not be in the table yet.
+    V &insert(uint32_t kid, V value)
+    {
+      assert(count < slots.size());
+      slot carried{kid, 1, std::move(value)};
+      V *inserted = nullptr;
+      for (size_t i = home(kid);; i = (i + 1) & mask, ++carried.distance)
+      {
+        slot &s = slots[i];
+        if (s.distance == 0)
+        {
+          s = std::move(carried);
+          ++count;
+          return inserted ? *inserted : s.value;
+        }
+        if (s.distance < carried.distance)
+        {
+          std::swap(s, carried);
+          if (!inserted)
+            inserted = &s.value;
+        }
+      }
+    }
+
+    bool erase(uint32_t kid)
+    {
+      const size_t i = index(kid);
+      if (i == NONE)
+        return false;
+      erase_at(i);
+      return true;
+    }
+
+    // Erases the key in slot \a i, shifting the keys after it back.
+    void erase_at(size_t i)
+    {
+      for (size_t next = (i + 1) & mask; slots[next].distance > 1;
+           i = next, next = (next + 1) & mask)
+      {
+        slots[i] = std::move(slots[next]);
+        --slots[i].distance;
+      }
+      slots[i] = slot{};
+      --count;
+    }
+
+    slot &at(size_t i) { return slots[i]; }
+
+    template <typename F>
+    void for_each(F &f)
+    {
+      for (slot &s : slots)
+        if (s.distance)
+          f(s.key, s.value);
+    }
+
+  private:
+    static const size_t NONE = SIZE_MAX;
+
+    // @return - the slot holding \a kid, or NONE.
+    size_t index(uint32_t kid) const
+    {
+      if (slots.empty())
+        return NONE;
+      size_t i = home(kid);
+      for (uint32_t distance = 1;; ++distance, i = (i + 1) & mask)
+      {
+        const slot &s = slots[i];
+        if (s.distance < distance)
+          return NONE;
+        if (s.key == kid)
+          return i;
+      }
+    }
+
+    // Fibonacci hashing: the top bits of kid times 2^64 / phi.
+    size_t home(uint32_t kid) const
+    {
+      return size_t((kid * 0x9E3779B97F4A7C15ull) >> shift);
+    }
+
+    counted_vector<slot, Tag> slots;
+    size_t mask;
+    unsigned shift;
+    size_t count;
+  };
+
+  // Moves up to MIGRATE_STEP slots of the old table into the current one.
+  // Slots below migrated are empty: erasing from the old table only shifts
+  // keys back into slots at or after the erased one.
+  void migrate()
+  {
+    if (old.empty())
+      return;
+    for (size_t step = 0; step < MIGRATE_STEP && migrated < old.capacity();
+         ++step)
+    {
+      slot &s = old.at(migrated);
+      if (s.distance == 0)
+      {
+        ++migrated;
+        continue;
+      }
+      current.insert(s.key, std::move(s.value));
+      old.erase_at(migrated);
+    }
+    if (migrated == old.capacity())
+      old = table{};
+  }
+
+  table current;
+  // The table being migrated from while growing, empty otherwise.
+  table old;
+  size_t migrated;
+};
+
+#endif
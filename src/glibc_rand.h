@@ -0,0 +1,56 @@
+#ifndef GLIBC_RAND_H
+#define GLIBC_RAND_H
+
+#include <cinttypes>
+
+// Per-instance stand-in for srand()/rand() that yields exactly the sequence
+// of glibc's default generator (an additive feedback generator over 34
+// words), so policies that draw random numbers keep their results while no
+// longer sharing the process-wide rand() state. Being a plain value, its
+// state can also be saved with the rest of a Policy (see checkpoint.h).
+class glibc_rand
+{
+public:
+  static constexpr int MAX = 2147483647;
+
+  explicit glibc_rand(uint32_t seed = 1) : r{}, next{} { srand(seed); }
+
+  void srand(uint32_t seed)
+  {
+    // glibc treats a seed of 0 like 1.
+    int32_t word = seed == 0 ? 1 : int32_t(seed);
+    r[0] = uint32_t(word);
+    for (int i = 1; i < 31; ++i)
+    {
+      // 16807 * word % MAX without overflowing, as glibc computes it.
+      const int32_t hi = word / 127773;
+      const int32_t lo = word % 127773;
+      word = 16807 * lo - 2836 * hi;
+      if (word < 0)
+        word += MAX;
+      r[i] = uint32_t(word);
+    }
+    for (int i = 31; i < 34; ++i)
+      r[i] = r[i - 31];
+    next = 0;
+    for (int i = 34; i < 344; ++i)
+      step();
+  }
+
+  int rand() { return int(step() >> 1); }
+
+private:
+  uint32_t step()
+  {
+    // r holds the last 34 words; next is the oldest of them.
+    const uint32_t word = r[(next + 3) % 34] + r[(next + 31) % 34];
+    r[next] = word;
+    next = (next + 1) % 34;
+    return word;
+  }
+
+  uint32_t r[34];
+  uint32_t next;
+};
+
+#endif
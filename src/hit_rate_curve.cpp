@@ -0,0 +1,107 @@
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+
+#include "hit_rate_curve.h"
+
+hit_rate_curve::hit_rate_curve(unsigned sub_bits)
+    : sub_bits{sub_bits}, counts{}, hit_count{}, miss_count{}
+{
+  assert(sub_bits < 32);
+}
+
+size_t hit_rate_curve::bucket_max(size_t b) const
+{
+  const size_t sub_buckets = size_t(1) << sub_bits;
+  if (b < sub_buckets)
+    return b;
+  const unsigned shift = unsigned(b >> sub_bits) - 1;
+  const size_t lowest = (sub_buckets + (b & (sub_buckets - 1))) << shift;
+  return lowest + ((size_t(1) << shift) - 1);
+}
+
+void hit_rate_curve::remove_shortest(size_t count)
+{
+  for (size_t &c : counts)
+  {
+    const size_t taken = std::min(c, count);
+    c -= taken;
+    hit_count -= taken;
+    count -= taken;
+    if (count == 0)
+      break;
+  }
+}
+
+double hit_rate_curve::hit_rate(size_t distance) const
+{
+  if (accesses() == 0)
+    return 0;
+  size_t accum = 0;
+  for (size_t b = 0; b < counts.size() && bucket_max(b) <= distance; ++b)
+    accum += counts[b];
+  return double(accum) / accesses();
+}
+
+size_t hit_rate_curve::quantile(double q) const
+{
+  if (hit_count == 0)
+    return 0;
+  const size_t rank =
+      std::max<size_t>(1, size_t(std::ceil(q * double(hit_count))));
+  size_t seen = 0;
+  for (size_t b = 0; b < counts.size(); ++b)
+  {
+    seen += counts[b];
+    if (seen >= rank)
+      return bucket_max(b);
+  }
+  return bucket_max(counts.size() - 1);
+}
+
+void hit_rate_curve::dump() const
+{
+  for (size_t i = 0; i < counts.size(); ++i)
+    std::cout << counts[i] << " ";
+}
+
+void hit_rate_curve::dump_readable() const
+{
+  for (size_t i = 0; i < counts.size(); ++i)
+    std::cout << "Distance " << bucket_max(i) << " Count " << counts[i]
+              << std::endl;
+}
+
+void hit_rate_curve::dump_cdf(const std::string &filename) const
+{
+  std::ofstream out{filename};
+
+  out << "distance cumfrac" << std::endl;
+  if (counts.size() == 0)
+    return;
+
+  const size_t total = accesses();
+
+  size_t accum = 0; // 累计数量
+  for (size_t i = 0; i < counts.size(); ++i)
+  {
+    size_t delta = counts[i];
+    accum += delta;
+    if (delta)
+      out << bucket_max(i) << " " << float(accum) / total << std::endl; // 当前累计百分比
+  }
+}
+
+void hit_rate_curve::merge(const hit_rate_curve &other)
+{
+  assert(sub_bits == other.sub_bits);
+  if (counts.size() < other.counts.size())
+    counts.resize(other.counts.size());
+
+  for (size_t i = 0; i < other.counts.size(); ++i)
+    counts[i] += other.counts[i];
+  hit_count += other.hit_count;
+  miss_count += other.miss_count;
+}
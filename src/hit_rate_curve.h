@@ -1,105 +1,97 @@
 #include <cstddef>
-#include <numeric>
-#include <vector>
 #include <cinttypes>
-#include <iostream>
-#include <exception>
-#include <fstream>
+#include <string>
+
+#include "mem_usage.h"
 
 #ifndef HIT_RATE_CURVE_H
 #define HIT_RATE_CURVE_H
 
+// Counts of hits by distance, and of misses.
+//
+// Distances go into an HDR-style histogram: exact below 2^sub_bits, then
+// 2^sub_bits buckets per power of two, so a distance is rounded up by less
+// than 1/2^sub_bits of it. The counts only grow to the bucket of the
+// highest distance seen, at most (65 - sub_bits) << sub_bits of them: 59 KB
+// at the default resolution, whatever the distances.
 class hit_rate_curve
 {
 public:
-  static constexpr size_t MAX_DISTANCE = 1lu * 1024 * 1024 * 1024;
-  hit_rate_curve()
-      : distances{}, too_big_hit{}, misses{}
-  {
-  }
+  // Distances within 1/128 of their true value.
+  static const unsigned DEFAULT_SUB_BITS = 7;
+
+  explicit hit_rate_curve(unsigned sub_bits = DEFAULT_SUB_BITS);
 
   // 记录一次访问的重用距离
-  void hit(size_t distance)
+  // \a count is more than 1 when the hit stands for several (see shards).
+  void hit(size_t distance, size_t count = 1)
   {
-    // 重用距离过大
-    if (distance >= MAX_DISTANCE)
-    {
-      ++too_big_hit;
-      return;
-    }
-
+    const size_t b = bucket(distance);
     // 容器扩容
-    if (distances.size() < distance + 1)
-      distances.resize(distance + 1, 0);
-
+    if (counts.size() <= b)
+      counts.resize(b + 1, 0);
     // 记录重用距离出现次数
-    ++(distances.at(distance));
+    counts[b] += count;
+    hit_count += count;
   }
 
-  void miss()
+  void miss(size_t count = 1)
   {
-    ++misses;
+    miss_count += count;
   }
 
+  size_t hits() const { return hit_count; }
+  size_t misses() const { return miss_count; }
+  size_t accesses() const { return hit_count + miss_count; }
+
+  // Takes \a count hits away, from the shortest distances on.
+  void remove_shortest(size_t count);
+
+  // @return - the fraction of accesses that hit at \a distance or less.
+  double hit_rate(size_t distance) const;
+
+  // @return - the largest distance of the bucket holding the hit of rank
+  //           ceil(q * hits()); 0 if there are no hits.
+  size_t quantile(double q) const;
+
   // 输出每个重用距离的出现次数
-  void dump() const
-  {
-    for (size_t i = 0; i < distances.size(); ++i)
-      std::cout << distances[i] << " ";
-  }
+  void dump() const;
 
   // 输出每个重用距离及其出现次数
-  void dump_readable() const
-  {
-    for (size_t i = 0; i < distances.size(); ++i)
-      std::cout << "Distance " << i << " Count " << distances[i] << std::endl;
-  }
+  void dump_readable() const;
 
   // 输出每个重用距离的累积分布
-  void dump_cdf(const std::string &filename) const
+  // Writes the fraction of accesses that hit at each distance or less, for
+  // the largest distance of each bucket with hits.
+  void dump_cdf(const std::string &filename) const;
+
+  // 合并两个重用距离统计
+  // Adds the hits and misses of \a other, which has the same resolution.
+  void merge(const hit_rate_curve &other);
+
+private:
+  size_t bucket(size_t distance) const
   {
-    std::ofstream out{filename};
-
-    out << "distance cumfrac" << std::endl;
-    if (distances.size() == 0)
-      return;
-
-    size_t total = std::accumulate(distances.begin(), distances.end(), 0) +
-                   too_big_hit +
-                   misses;
-
-    size_t accum = 0; // 累计数量
-    for (size_t i = 0; i < distances.size(); ++i)
-    {
-      size_t delta = distances[i];
-      accum += delta;
-      if (delta)
-        out << i << " " << float(accum) / total << std::endl; // 当前累计百分比
-    }
+    if (distance < (size_t(1) << sub_bits))
+      return distance;
+    const unsigned log = 63 - __builtin_clzll(distance);
+    return size_t(log - sub_bits + 1) << sub_bits |
+           ((distance >> (log - sub_bits)) & ((size_t(1) << sub_bits) - 1));
   }
 
-  // 合并两个重用距离统计vector
-  void merge(const hit_rate_curve &other)
-  {
-    if (distances.size() < other.distances.size())
-      distances.resize(other.distances.size());
+  // @return - the largest distance that falls into bucket \a b.
+  size_t bucket_max(size_t b) const;
 
-    for (size_t i = 0; i < other.distances.size(); ++i)
-      distances[i] += other.distances[i];
-  }
+  unsigned sub_bits;
 
-  // For each distance, a count of the hits at that distance.
+  // For each bucket, a count of the hits at its distances.
   // Units on distance depends on how the caller interprets it.
   // For example, some curves may represent hit rank while others
   // may represent number of bytes into shadow queue of the hit.
-  std::vector<size_t> distances;
-
-  // The distances vector holds a size_t for each distance. If the highest
-  // seen distance is too large, the distances vector can grow to
-  // many gigabytes. too_big_hit tracks hits that with huge distances.
-  size_t too_big_hit;
+  counted_vector<size_t, mem_tag::distances> counts;
 
-  size_t misses;
+  size_t hit_count;
+  size_t miss_count;
 };
 
 #endif
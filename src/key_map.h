@@ -0,0 +1,127 @@
+#ifndef KEY_MAP_H
+#define KEY_MAP_H
+
+#include <cassert>
+#include <cinttypes>
+#include <cstddef>
+#include <vector>
+
+#include "flat_map.h"
+#include "mem_usage.h"
+#include "prefetch.h"
+
+// Per-key table for policies, indexed by Request::kid.
+//
+// If the trace's kids are dense (a binary trace converted with csv2bin -d,
+// see stats::key_space) values live in a flat vector indexed directly by kid,
+// so a lookup is a single array access and memory is fixed up front.
+// Otherwise it falls back to a flat_map, an open addressing hash table.
+//
+// As with flat_map, a pointer returned by find() or operator[] is only valid
+// until the next insert or erase of another kid.
+template <typename T>
+class key_map
+{
+public:
+  // @param key_space - all kids are below this; 0 if kids are not dense.
+  explicit key_map(size_t key_space = 0)
+      : dense{key_space > 0}, values(key_space), present(key_space),
+        sparse{}, count{}
+  {
+  }
+
+  // @return - the value for \a kid, or nullptr if it has none.
+  T *find(uint32_t kid)
+  {
+    if (dense)
+    {
+      assert(kid < values.size());
+      return present[kid] ? &values[kid] : nullptr;
+    }
+    return sparse.find(kid);
+  }
+
+  const T *find(uint32_t kid) const
+  {
+    return const_cast<key_map *>(this)->find(kid);
+  }
+
+  // Starts loading what find(kid) will look at into the CPU caches (see
+  // prefetch.h).
+  void prefetch(uint32_t kid) const
+  {
+    if (dense)
+    {
+      assert(kid < values.size());
+      ::prefetch(&present[kid]);
+      ::prefetch(&values[kid]);
+      return;
+    }
+    sparse.prefetch(kid);
+  }
+
+  // @return - the value for \a kid, default constructing it if it has none.
+  T &operator[](uint32_t kid)
+  {
+    if (dense)
+    {
+      assert(kid < values.size());
+      if (!present[kid])
+      {
+        present[kid] = 1;
+        ++count;
+      }
+      return values[kid];
+    }
+    return sparse[kid];
+  }
+
+  // @return - true if \a kid had a value.
+  bool erase(uint32_t kid)
+  {
+    if (dense)
+    {
+      assert(kid < values.size());
+      if (!present[kid])
+        return false;
+      present[kid] = 0;
+      values[kid] = T{};
+      --count;
+      return true;
+    }
+    return sparse.erase(kid);
+  }
+
+  size_t size() const { return dense ? count : sparse.size(); }
+  bool empty() const { return size() == 0; }
+
+  // Calls f(kid, value) for every key with a value, in no particular order.
+  template <typename F>
+  void for_each(F f)
+  {
+    if (dense)
+    {
+      for (size_t kid = 0; kid < values.size(); ++kid)
+        if (present[kid])
+          f(uint32_t(kid), values[kid]);
+      return;
+    }
+    sparse.for_each(f);
+  }
+
+  template <typename F>
+  void for_each(F f) const
+  {
+    const_cast<key_map *>(this)->for_each(
+        [&f](uint32_t kid, const T &value) { f(kid, value); });
+  }
+
+private:
+  bool dense;
+  counted_vector<T, mem_tag::hash_index> values;
+  counted_vector<uint8_t, mem_tag::hash_index> present;
+  flat_map<T, mem_tag::hash_index> sparse;
+  size_t count;
+};
+
+#endif
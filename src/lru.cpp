@@ -7,13 +7,13 @@
 // LRU缓存策略
 
 LRU::LRU()
-    : Policy{stats{"", {}, 0}}, map{}, queue{}
+    : Policy{stats{"", {}, 0}}, map{}, queue{}, expanded{}
 {
   stat.apps = {};
 }
 
 LRU::LRU(stats stat)
-    : Policy{stat}, map{}, queue{}
+    : Policy{stat}, map{stat.key_space}, queue{}, expanded{}
 {
 }
 
@@ -27,7 +27,8 @@ size_t LRU::process_request(const Request *r, bool warmup)
   assert(request.size() > 0);
   size_t absolute_bytes_added = 0;
 
-  if (stat.apps->empty())
+  // LRUs inside slab policies are default constructed without an app set.
+  if (stat.apps && stat.apps->empty())
   {
     stat.apps->insert(request.appid); // 新应用id
   }
@@ -35,17 +36,20 @@ size_t LRU::process_request(const Request *r, bool warmup)
   {
     ++stat.accesses;
   }
+  phase_timer lookup{profile.get(), phase::lookup};
   auto map_iterator = map.find(request.kid); // 查找请求
-  if (map_iterator != map.end())             // 找到了
+  lookup.stop();
+  if (map_iterator)                          // 找到了
   {
-    auto queue_iterator = map_iterator->second;
-    Request &existing_request = *queue_iterator;
+    const lru_queue::handle node = *map_iterator;
+    cache_entry &existing_request = queue[node];
     if (existing_request.size() == request.size() &&
-        existing_request.frag_sz == request.frag_sz) // 请求大小相同，且碎片大小相同
+        existing_request.get_frag() == request.frag_sz) // 请求大小相同，且碎片大小相同
     {
-      queue.erase(queue_iterator);
-      queue.emplace_front(request);     // lru，移动到队列头部
-      map[request.kid] = queue.begin(); // 更新map
+      phase_timer promote{profile.get(), phase::promote};
+      existing_request = cache_entry{request};
+      queue.move_to_front(node); // lru，原地移动到队列头部
+      promote.stop();
       if (!warmup)
       {
         stat.hits++;
@@ -54,9 +58,9 @@ size_t LRU::process_request(const Request *r, bool warmup)
     else // 请求大小有改变，更新
     {
       // 移除原来的请求
-      queue.erase(queue_iterator);
-      map.erase(existing_request.kid);
       stat.bytes_cached -= existing_request.size();
+      map.erase(request.kid);
+      queue.erase(node);
       // 添加新请求
       absolute_bytes_added = add_request(request);
     }
@@ -69,6 +73,18 @@ size_t LRU::process_request(const Request *r, bool warmup)
   return absolute_bytes_added;
 }
 
+void LRU::process_batch(const Request *begin, size_t n, bool warmup)
+{
+  pipeline_batch(n,
+    [&](size_t i) { map.prefetch(begin[i].kid); },
+    [&](size_t i) {
+      auto it = map.find(begin[i].kid);
+      if (it)
+        prefetch(&queue[*it]);
+    },
+    [&](size_t i) { process_request(&begin[i], warmup); });
+}
+
 size_t LRU::get_bytes_cached() const
 {
   return stat.bytes_cached;
@@ -77,16 +93,16 @@ size_t LRU::get_bytes_cached() const
 // 添加请求，插入前进行驱逐
 size_t LRU::add_request(const Request &request)
 {
-  auto it = map.find(request.kid); // 检查是否已经存在
-  assert(it == map.end());
+  assert(!map.find(request.kid)); // 检查是否已经存在
   size_t bytes_evicted = 0;
   size_t bytes_added = 0;
+  phase_timer evict{profile.get(), phase::evict};
   // 驱逐直至空间足够
   while (stat.bytes_cached + size_t(request.size()) >
              stat.global_mem &&
          !queue.empty())
   {
-    Request *victim = &queue.back(); // lru，驱逐队尾
+    const cache_entry *victim = &queue[queue.back()]; // lru，驱逐队尾
     stat.bytes_cached -= victim->size();
     stat.evicted_bytes += victim->size();
     bytes_evicted += victim->size();
@@ -94,11 +110,11 @@ size_t LRU::add_request(const Request &request)
     map.erase(victim->kid);
     queue.pop_back();
   }
+  evict.stop();
   // 添加新请求
   if (stat.bytes_cached + size_t(request.size()) <= stat.global_mem)
   {
-    queue.emplace_front(request);
-    map[request.kid] = queue.begin();
+    map[request.kid] = queue.push_front(cache_entry{request});
     stat.bytes_cached += request.size();
     bytes_added += request.size();
   }
@@ -109,47 +125,43 @@ size_t LRU::add_request(const Request &request)
 // 检查是否会导致驱逐
 bool LRU::would_cause_eviction(const Request &request) const
 {
-  return (map.find(request.kid) == map.end()) &&
+  return !map.find(request.kid) &&
          (stat.bytes_cached + size_t(request.size()) > stat.global_mem);
 }
 
 // 检查是否会命中
 bool LRU::would_hit(const Request &request) const
 {
-  auto it = map.find(request.kid);
-  return it != map.end();
+  return map.find(request.kid) != nullptr;
 }
 
 // 扩容
 void LRU::expand(const size_t bytes)
 {
   stat.global_mem += bytes;
+  expanded += bytes;
 }
 
 // 返回每个应用在缓存中占用的字节数
 std::unordered_map<int32_t, size_t> LRU::get_per_app_bytes_in_use() const
 {
   std::unordered_map<int32_t, size_t> result{};
-  for (auto &Request : queue)
+  for (const cache_entry &entry : queue)
   {
-    result[Request.appid] += Request.size();
+    result[entry.appid] += entry.size();
   }
   return result;
 }
 
 // 尝试添加请求到队尾(不进行驱逐)
-bool LRU::try_add_tail(const Request *r)
+bool LRU::try_add_tail(const cache_entry &entry)
 {
-  auto it = map.find(r->kid);
-  assert(it == map.end());
+  assert(!map.find(entry.kid));
   bool succeeded = false;
-  if (stat.bytes_cached + size_t(r->size()) <= stat.global_mem)
+  if (stat.bytes_cached + size_t(entry.size()) <= stat.global_mem)
   {
-    queue.emplace_back(*r); // 添加到队尾
-    auto back_it = queue.end();
-    --back_it;             // 获取队尾
-    map[r->kid] = back_it; // 更新map
-    stat.bytes_cached += r->size();
+    map[entry.kid] = queue.push_back(entry); // 添加到队尾
+    stat.bytes_cached += entry.size();
     succeeded = true;
   }
   return succeeded;
@@ -160,10 +172,15 @@ bool LRU::try_add_tail(const Request *r)
 // accordingly.  Returns the 'stack distance' which is calc's by summing the
 // bytes for all Requests in the chain until 'r' is reached.
 int64_t LRU::remove(const Request *r)
+{
+  return remove(r->kid);
+}
+
+int64_t LRU::remove(uint32_t kid)
 {
   // If r is not in the map something weird has happened.
-  auto it = map.find(r->kid);
-  if (it == map.end())
+  auto it = map.find(kid);
+  if (!it)
   {
     return -1;
   }
@@ -172,17 +189,46 @@ int64_t LRU::remove(const Request *r)
   size_t stack_dist = 0;
   for (const auto &i : queue)
   {
-    if (i.kid != r->kid)
+    if (i.kid != kid)
       break;
     stack_dist += i.size();
   }
 
   // Adjust the local bytes_cached value, remove 'r'
   // from the hash table, and from the LRU chain.
-  auto &list_it = it->second;
-  stat.bytes_cached -= list_it->size();
-  queue.erase(list_it);
-  map.erase(it);
+  const lru_queue::handle node = *it;
+  stat.bytes_cached -= queue[node].size();
+  queue.erase(node);
+  map.erase(kid);
 
   return stack_dist;
 }
+
+// 保存/恢复检查点：按lru顺序保存队列，恢复时重建map
+void LRU::save(checkpoint_writer &w) const
+{
+  stats built{stat};
+  built.global_mem -= expanded;
+  built.save(w);
+  w.put(expanded);
+  w.put(uint64_t(queue.size()));
+  for (const cache_entry &entry : queue)
+    w.put(entry);
+}
+
+void LRU::restore(checkpoint_reader &r)
+{
+  // The LRU may have been expanded since it was built (see lsc_multi).
+  stat.global_mem -= expanded;
+  stat.restore(r);
+  expanded = r.get<size_t>();
+  stat.global_mem += expanded;
+  queue.clear();
+  map = decltype(map){stat.key_space};
+  const uint64_t n = r.get<uint64_t>();
+  for (uint64_t i = 0; i < n; ++i)
+  {
+    const cache_entry entry = r.get<cache_entry>();
+    map[entry.kid] = queue.push_back(entry);
+  }
+}
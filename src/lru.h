@@ -4,6 +4,9 @@
 #include <unordered_map>
 #include <list>
 #include "policy.h"
+#include "cache_entry.h"
+#include "key_map.h"
+#include "pool_lru.h"
 
 // LRU缓存策略
 class LRU : public Policy
@@ -36,6 +39,10 @@ public:
   //           bytes cached
   size_t process_request(const Request *r, bool warmup);
 
+  // Processes a batch of requests, prefetching the map slots and queue
+  // entries of upcoming ones (see prefetch.h).
+  void process_batch(const Request *begin, size_t n, bool warmup);
+
   /// Constant Accessors. ///
 
   // Reports the current number of bytes utilized by cached request requests.
@@ -62,10 +69,11 @@ public:
   /// Public Modifiers. ///
 
   // Used by policies that aggregate LRUs i.e. lsc_multi.
-  bool try_add_tail(const Request *r);
+  bool try_add_tail(const cache_entry &entry);
 
   // Used by policies that aggreagte LRUs i.e. slab_multi.
   int64_t remove(const Request *r);
+  int64_t remove(uint32_t kid);
 
   // Used by policies that aggreagte LRUs i.e. slab, slab_multi.
   // Specifically, this is used to expand the size of a particular slab class.
@@ -73,6 +81,10 @@ public:
   // @param bytes - number of bytes by which to increase the size of the slab.
   void expand(const size_t bytes);
 
+  bool can_checkpoint() const { return true; }
+  void save(checkpoint_writer &w) const;
+  void restore(checkpoint_reader &r);
+
 private:
   // Adds a request to the cache.
   //
@@ -84,8 +96,13 @@ private:
   // @param request - A request to be added to the queue.
   size_t add_request(const Request &request);
 
-  std::unordered_map<uint32_t, std::list<Request>::iterator> map;
-  std::list<Request> queue;
+  typedef pool_lru<cache_entry, mem_tag::queue> lru_queue;
+
+  key_map<lru_queue::handle> map;
+  lru_queue queue;
+  // Bytes expand() added to the size the LRU was built with, which is what a
+  // checkpoint is checked against.
+  size_t expanded;
 };
 
 #endif
@@ -1,13 +1,10 @@
 #include <cassert>
 #include "lruk.h"
 
-size_t K_LRU = 8;
-size_t KLRU_QUEUE_SIZE = 1024;
-
 Lruk::Lruk(stats stat)
-	: Policy(stat), kLruSizes(K_LRU, 0), kLru(K_LRU), allObjects(), kLruHits(K_LRU, 0), kLruNumWrites(K_LRU, 0)
+	: Policy(stat), kLruSizes(stat.config.k_lru, 0), kLru(stat.config.k_lru), allObjects(), kLruHits(stat.config.k_lru, 0), kLruNumWrites(stat.config.k_lru, 0)
 {
-	assert(K_LRU >= 1);
+	assert(stat.config.k_lru >= 1);
 }
 
 Lruk::~Lruk() {}
@@ -46,7 +43,7 @@ size_t Lruk::process_request(const Request *r, bool warmup)
 				stat.hits++;
 				kLruHits[qN]++;
 			}
-			if ((qN + 1) != K_LRU) // 若不是最后一个队列，提升到下一个队列
+			if ((qN + 1) != stat.config.k_lru) // 若不是最后一个队列，提升到下一个队列
 			{
 				qN++;
 			}
@@ -84,12 +81,12 @@ void Lruk::insert(std::vector<uint32_t> &objects,
 				  bool warmup)
 {
 
-	assert(k < K_LRU);
+	assert(k < stat.config.k_lru);
 
 	std::vector<uint32_t> newObjects;
 	size_t newSum = 0;
 	// 驱逐直到空间足够
-	while (sum + kLruSizes[k] > KLRU_QUEUE_SIZE)
+	while (sum + kLruSizes[k] > stat.config.klru_queue_size)
 	{
 		assert(kLruSizes[k] > 0);
 		assert(kLru[k].size() > 0);
@@ -126,7 +123,7 @@ void Lruk::insert(std::vector<uint32_t> &objects,
 		{
 			kLruNumWrites[k] += item.size;
 		}
-		assert(kLruSizes[k] <= KLRU_QUEUE_SIZE);
+		assert(kLruSizes[k] <= stat.config.klru_queue_size);
 	}
 
 	// 将驱逐的对象插入到前一级队列
@@ -144,14 +141,14 @@ void Lruk::dump_stats(void)
 	{
 		appId = app;
 	}
-	std::string filename{stat.policy + "-app" + std::to_string(appId) + "-K" + std::to_string(K_LRU) + "-QSize" + std::to_string(KLRU_QUEUE_SIZE)};
+	std::string filename{stat.policy + "-app" + std::to_string(appId) + "-K" + std::to_string(stat.config.k_lru) + "-QSize" + std::to_string(stat.config.klru_queue_size)};
 	std::ofstream out{filename};
-	out << "K_LRU (number of queues) " << K_LRU << std::endl;
-	out << "queue size " << KLRU_QUEUE_SIZE << std::endl;
+	out << "K_LRU (number of queues) " << stat.config.k_lru << std::endl;
+	out << "queue size " << stat.config.klru_queue_size << std::endl;
 	out << "#accesses " << stat.accesses << std::endl;
 	out << "#global hits " << stat.hits << std::endl;
 	out << "hit rate " << double(stat.hits) / stat.accesses << std::endl;
-	for (size_t i = 0; i < K_LRU; i++)
+	for (size_t i = 0; i < stat.config.k_lru; i++)
 	{
 		out << "queue " << i << " hits: " << kLruHits[i] << std::endl;
 		out << "queue " << i << " hit rate: " << double(kLruHits[i]) / stat.accesses << std::endl;
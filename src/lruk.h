@@ -7,9 +7,6 @@
 #include <unordered_map>
 #include "policy.h"
 
-extern size_t K_LRU;
-extern size_t KLRU_QUEUE_SIZE;
-
 class Lruk : public Policy
 {
 private:
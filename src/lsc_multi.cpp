@@ -38,20 +38,17 @@ lsc_multi::lsc_multi(stats stat, Subpolicy eviction_policy)
   : Policy{stat}
   , last_idle_check{0.}
   , last_dump{0.}
-  , use_tax{}
-  , tax_rate{}
   , eviction_policy{eviction_policy}
   , cleaner{eviction_policy == Subpolicy::GREEDY ? Cleaning_policy::RANDOM
                                                  : Cleaning_policy::LOW_NEED}
   //, cleaner{Cleaning_policy::LOW_NEED}
   , apps{}
-  , map{}
+  , map{stat.key_space}
   , head{nullptr}
   , segments{}
   , free_segments{}
+  , rng{0}
 {
-  srand(0);
-
   if (stat.global_mem % stat.segment_size != 0) {
     std::cerr <<
       "WARNING: global_mem not a multiple of segment_size" << std::endl;
@@ -81,10 +78,116 @@ void lsc_multi::add_app(size_t appid,
   apps.emplace(appid, application{appid, min_mem_pct, target_memory, steal_size});
 }
 
+// Segments can still hold stale versions of items that were rewritten
+// since, so each item is saved with whether the hash table refers to it.
+void lsc_multi::save(checkpoint_writer &w) const
+{
+  stat.save(w);
+  w.put(last_idle_check);
+  w.put(last_dump);
+  w.put(rng);
+
+  w.put(uint64_t(apps.size()));
+  for (const auto& p : apps) {
+    const application& app = p.second;
+    w.put(app.appid);
+    w.put(app.credit_bytes);
+    w.put(app.bytes_in_use);
+    w.put(app.accesses);
+    w.put(app.hits);
+    w.put(app.shadow_q_hits);
+    w.put(app.survivor_items);
+    w.put(app.survivor_bytes);
+    w.put(app.evicted_items);
+    w.put(app.evicted_bytes);
+    app.shadow_q.save(w);
+  }
+
+  w.put(uint64_t(segments.size()));
+  w.put(free_segments);
+  for (const auto& segment : segments) {
+    w.put(bool(segment));
+    if (!segment)
+      continue;
+    w.put(&segment.value() == head);
+    w.put(segment->filled_bytes);
+    w.put(segment->access_count);
+    w.put(segment->low_timestamp);
+    w.put(uint64_t(segment->app_bytes.size()));
+    for (const auto& ab : segment->app_bytes) {
+      w.put(ab.first);
+      w.put(ab.second);
+    }
+    w.put(uint64_t(segment->queue.size()));
+    for (const item& i : segment->queue) {
+      w.put(i.entry);
+      auto it = map.find(i.entry.kid);
+      w.put(it && &**it == &i);
+    }
+  }
+}
+
+void lsc_multi::restore(checkpoint_reader &r)
+{
+  stat.restore(r);
+  last_idle_check = r.get<double>();
+  last_dump = r.get<double>();
+  rng = r.get<glibc_rand>();
+
+  r.expect(uint64_t(apps.size()), "set of apps (-a)");
+  for (size_t i = 0; i < apps.size(); ++i) {
+    auto ait = apps.find(r.get<size_t>());
+    if (ait == apps.end())
+      r.mismatch("set of apps (-a)");
+    application& app = ait->second;
+    app.credit_bytes = r.get<ssize_t>();
+    app.bytes_in_use = r.get<size_t>();
+    app.accesses = r.get<size_t>();
+    app.hits = r.get<size_t>();
+    app.shadow_q_hits = r.get<size_t>();
+    app.survivor_items = r.get<size_t>();
+    app.survivor_bytes = r.get<size_t>();
+    app.evicted_items = r.get<size_t>();
+    app.evicted_bytes = r.get<size_t>();
+    app.shadow_q.restore(r);
+  }
+
+  r.expect(uint64_t(segments.size()), "number of segments");
+  free_segments = r.get<size_t>();
+  map = hash_map{stat.key_space};
+  head = nullptr;
+  for (auto& slot : segments) {
+    slot = nullopt;
+    if (!r.get<bool>())
+      continue;
+    slot.emplace();
+    segment* seg = &slot.value();
+    if (r.get<bool>())
+      head = seg;
+    seg->filled_bytes = r.get<size_t>();
+    seg->access_count = r.get<uint64_t>();
+    seg->low_timestamp = r.get<double>();
+    const uint64_t napps = r.get<uint64_t>();
+    for (uint64_t i = 0; i < napps; ++i) {
+      const int32_t appid = r.get<int32_t>();
+      seg->app_bytes.emplace(appid, r.get<size_t>());
+    }
+    const uint64_t n = r.get<uint64_t>();
+    for (uint64_t i = 0; i < n; ++i) {
+      seg->queue.emplace_back(seg, r.get<cache_entry>());
+      auto back_it = seg->queue.end();
+      --back_it;
+      if (r.get<bool>())
+        map[back_it->entry.kid] = back_it;
+    }
+  }
+  assert(head);
+}
+
 void lsc_multi::dump_app_stats(double time) {
   for (auto& p : apps) {
     application& app = p.second;
-    app.dump_stats(time, eviction_policy);
+    app.dump_stats(*out, time, eviction_policy);
   }
 }
 
@@ -95,9 +198,9 @@ void lsc_multi::compute_idle_mem(double time) {
     if (!segment)
       continue;
     for (item& item : segment->queue) {
-      if (time - item.req.time > idle_mem_secs)
-        per_app_idle[item.req.appid] += item.req.size();
-      per_app_in_use[item.req.appid] += item.req.size();
+      if (time - item.entry.get_time() > idle_mem_secs)
+        per_app_idle[item.entry.appid] += item.entry.size();
+      per_app_in_use[item.entry.appid] += item.entry.size();
     }
   }
 
@@ -111,7 +214,8 @@ void lsc_multi::compute_idle_mem(double time) {
     application& app = it->second;
 
     const double active_fraction = 1 - (double(idle) / app.bytes_in_use);
-    const double tax = (1 - active_fraction * tax_rate) / (1 - tax_rate);
+    const double tax = (1 - active_fraction * stat.config.tax_rate) /
+                       (1 - stat.config.tax_rate);
 
     const ssize_t new_target = app.min_mem / tax;
 
@@ -142,7 +246,7 @@ size_t lsc_multi::process_request(const Request *r, bool warmup) {
 
   assert(apps.find(r->appid) != apps.end());
 
-  if (!warmup && use_tax &&
+  if (!warmup && stat.config.use_tax &&
       ((last_idle_check == 0.) ||
       (r->time - last_idle_check > idle_mem_secs)))
   {
@@ -154,7 +258,7 @@ size_t lsc_multi::process_request(const Request *r, bool warmup) {
 
   if (!warmup && ((last_dump == 0.) || (r->time - last_dump > 3600.))) {
     if (last_dump == 0.)
-      application::dump_stats_header();
+      application::dump_stats_header(*out);
     dump_app_stats(r->time);
     if (last_dump == 0.)
       last_dump = r->time;
@@ -171,10 +275,10 @@ size_t lsc_multi::process_request(const Request *r, bool warmup) {
   }
 
   auto it = map.find(r->kid);
-  if (it != map.end()) {
-    auto list_it = it->second;
+  if (it) {
+    auto list_it = *it;
     segment* old_segment = list_it->seg;
-    int32_t old_Request_size = list_it->req.size();
+    int32_t old_Request_size = list_it->entry.size();
     if (old_Request_size  == r->size()) {
       // Promote this item to the front.
       old_segment->queue.erase(list_it);
@@ -231,10 +335,10 @@ size_t lsc_multi::process_request(const Request *r, bool warmup) {
     ++app.shadow_q_hits;
     // Hit in shadow Q! We get to steal!
     size_t steal_size = 0;
-    if (!use_tax && eviction_policy == Subpolicy::NORMAL)
+    if (!stat.config.use_tax && eviction_policy == Subpolicy::NORMAL)
         steal_size = app.steal_size ;
     for (int i = 0; i < 10; ++i) {
-      size_t victim = appids.at(rand() % appids.size());
+      size_t victim = appids.at(rng.rand() % appids.size());
       auto it = apps.find(victim);
       assert(it != apps.end());
       application& other_app = it->second;
@@ -309,7 +413,7 @@ auto lsc_multi::choose_cleaning_sources_random() -> std::vector<segment*>
 
   for (size_t i = 0; i < stat.cleaning_width; ++i) {
     for (size_t j = 0; j < 1000000; ++j) {
-      int r = rand() % segments.size();
+      int r = rng.rand() % segments.size();
       auto& segment = segments.at(r);
 
       // Don't pick free segments.
@@ -492,7 +596,7 @@ auto lsc_multi::choose_cleaning_sources_low_need() -> std::vector<segment*>
 
   for (size_t i = to_get_low_need; i < stat.cleaning_width; ++i) {
     for (size_t j = 0; j < 1000000; ++j) {
-      int rd = rand() % segments.size();
+      int rd = rng.rand() % segments.size();
       auto& segment = segments.at(rd);
 
       // Don't pick free segments.
@@ -571,7 +675,7 @@ next:
     std::unordered_map<int32_t, size_t> per_app_in_use{};
     assert(segment);
     for (item& item : segment->queue)
-      per_app_in_use[item.req.appid] += item.req.size();
+      per_app_in_use[item.entry.appid] += item.entry.size();
     for (auto& pr : per_app_in_use) {
       int32_t appid = pr.first;
       size_t bytes_in_srcs = pr.second;
@@ -614,8 +718,8 @@ auto lsc_multi::choose_survivor() -> application* {
       application& app = p.second;
       if (app.cleaning_it == app.cleaning_q.end())
         continue;
-      if (r == nullptr || (*app.cleaning_it)->req.time > newest) {
-        newest = (*app.cleaning_it)->req.time;
+      if (r == nullptr || (*app.cleaning_it)->entry.get_time() > newest) {
+        newest = (*app.cleaning_it)->entry.get_time();
         r = &app;
       }
     }
@@ -659,7 +763,7 @@ void lsc_multi::clean()
       if (!segment)
         continue;
       for (item& item : segment->queue)
-        per_app_in_use[item.req.appid] += item.req.size();
+        per_app_in_use[item.entry.appid] += item.entry.size();
     }
     for (auto& pr : per_app_in_use) {
       int32_t appid = pr.first;
@@ -679,10 +783,10 @@ void lsc_multi::clean()
     }
     assert(segment->filled_bytes == 0 || !segment->queue.empty());
     for (auto& item : segment->queue) {
-      auto appit = apps.find(item.req.appid);
+      auto appit = apps.find(item.entry.appid);
       if (appit == apps.end()) {
-        std::cerr << "Couldn't find " << item.req.appid << " in apps" << std::endl;
-        item.req.dump();
+        std::cerr << "Couldn't find " << item.entry.appid << " in apps" << std::endl;
+        item.entry.dump();
       }
       assert(appit != apps.end());
       application& app = appit->second;
@@ -690,15 +794,15 @@ void lsc_multi::clean()
       // Remove all objects in the segments to clean from the apps
       // memory budget. Will get re-added for each object that gets
       // 'salvaged'.
-      app.bytes_in_use -= item.req.size();
+      app.bytes_in_use -= item.entry.size();
 
       // Check to see if this version is still needed.
-      auto it = map.find(item.req.kid);
+      auto it = map.find(item.entry.kid);
       // If not in the hash table, just drop it.
-      if (it == map.end())
+      if (!it)
         continue;
       // If hash table pointer refers to a different version, drop this one.
-      if (&*it->second != &item)
+      if (&**it != &item)
         continue;
 
       app.add_to_cleaning_queue(&item);
@@ -739,25 +843,25 @@ void lsc_multi::clean()
 
     item* item = *selected_app->cleaning_it;
 
-    auto it = map.find(item->req.kid);
+    auto it = map.find(item->entry.kid);
 
     // Should exist else we would have thrown it out in the first
     // pass constructing the per-app lists.
-    if (it == map.end()) {
+    if (!it) {
       std::cerr << "Found dead object during cleaning" << std::endl;
-      item->req.dump();
+      item->entry.dump();
     }
-    assert(it != map.end());
+    assert(it);
     // If hash table pointer refers to a different version, drop this one.
-    if (&*it->second != item) {
+    if (&**it != item) {
       ++selected_app->cleaning_it;
       continue;
     }
 
     // Check to see if there is room for the item in the dst.
-    if (!dst || dst->filled_bytes + item->req.size() > stat.segment_size) {
+    if (!dst || dst->filled_bytes + item->entry.size() > stat.segment_size) {
       //std::cerr << "Couldn't put in item of size "
-                //<< item->req.size() << " bytes" << std::endl;
+                //<< item->entry.size() << " bytes" << std::endl;
       if (dst)
         stat.cleaned_ext_frag_bytes += (stat.segment_size - dst->filled_bytes);
       ++stat.cleaned_generated_segs;
@@ -771,32 +875,32 @@ void lsc_multi::clean()
       dst = choose_cleaning_destination();
       dst_segments.push_back(dst);
     }
-    if (dst->filled_bytes + item->req.size() > stat.segment_size) {
+    if (dst->filled_bytes + item->entry.size() > stat.segment_size) {
       std::cerr << "Weird object while cleaning!" << std::endl
                 << "filled_bytes " << dst->filled_bytes << std::endl
-                << "item size " << item->req.size() << std::endl
+                << "item size " << item->entry.size() << std::endl
                 << "segment_size " << stat.segment_size << std::endl;
-      item->req.dump();
+      item->entry.dump();
     }
-    assert(dst->filled_bytes + item->req.size() <= stat.segment_size);
+    assert(dst->filled_bytes + item->entry.size() <= stat.segment_size);
     ++selected_app->cleaning_it;
 
     // Relocate *to the back* to retain timestamp sort order.
-    dst->queue.emplace_back(dst, item->req);
-    map[item->req.kid] = (--dst->queue.end());
-    dst->filled_bytes += item->req.size();
-    auto ait = dst->app_bytes.find(item->req.appid);
+    dst->queue.emplace_back(dst, item->entry);
+    map[item->entry.kid] = (--dst->queue.end());
+    dst->filled_bytes += item->entry.size();
+    auto ait = dst->app_bytes.find(item->entry.appid);
     if (ait == dst->app_bytes.end()) {
-      dst->app_bytes.emplace(item->req.appid, item->req.size());
+      dst->app_bytes.emplace(item->entry.appid, item->entry.size());
     } else {
-      ait->second = ait->second + item->req.size();
+      ait->second = ait->second + item->entry.size();
     }
-    dst->low_timestamp = item->req.time;
+    dst->low_timestamp = item->entry.get_time();
 
     // Bill the app that hosts it for the space use for preserving this.
-    selected_app->bytes_in_use += item->req.size();
+    selected_app->bytes_in_use += item->entry.size();
     ++selected_app->survivor_items;
-    selected_app->survivor_bytes += item->req.size();
+    selected_app->survivor_bytes += item->entry.size();
   }
 
   // Clear items that are going to get thrown on the floor from the hashtable.
@@ -807,19 +911,19 @@ void lsc_multi::clean()
       // Need to do a double check here. The item we are evicting may
       // still exist in the hash table but it may point to a newer version
       // of this object. In that case, skip the erase from the hash table.
-      auto hash_it = map.find((*app.cleaning_it)->req.kid);
-      if (hash_it != map.end()) {
+      auto hash_it = map.find((*app.cleaning_it)->entry.kid);
+      if (hash_it) {
         item* from_list = *app.cleaning_it;
-        item* from_hash = &*hash_it->second;
+        item* from_hash = &**hash_it;
 
         if (from_list == from_hash) {
-          app.shadow_q.remove(&from_list->req);
-          app.shadow_q.try_add_tail(&from_list->req);
-          map.erase((*app.cleaning_it)->req.kid);
+          app.shadow_q.remove(from_list->entry.kid);
+          app.shadow_q.try_add_tail(from_list->entry);
+          map.erase((*app.cleaning_it)->entry.kid);
           ++stat.evicted_items;
-          stat.evicted_bytes += from_list->req.size();
+          stat.evicted_bytes += from_list->entry.size();
           ++app.evicted_items;
-          app.evicted_bytes += from_list->req.size();
+          app.evicted_bytes += from_list->entry.size();
         }
       }
 
@@ -832,11 +936,11 @@ void lsc_multi::clean()
   if (debug) {
     // Sanity check - none of the items left in the hash table should point
     // into a src_segment.
-    for (auto& entry : map) {
-      item& item = *entry.second;
+    map.for_each([&](uint32_t, LRU_queue::iterator& entry) {
+      item& item = *entry;
       for (segment* src : src_segments)
         assert(item.seg != src);
-    }
+    });
 
     dump_cleaning_plan(src_segments, dst_segments);
   }
@@ -862,7 +966,7 @@ void lsc_multi::clean()
       size_t bytes = 0;
       for (const auto& item : segment->queue) {
         assert(item.seg == &segment.value());
-        bytes += item.req.size();
+        bytes += item.entry.size();
       }
       assert(bytes <= stat.segment_size);
       assert(bytes == segment->filled_bytes);
@@ -874,20 +978,20 @@ void lsc_multi::clean()
     // segments.
     size_t reachable_from_map = 0;
     std::unordered_set<int32_t> seen{};
-    for (auto& entry : map) {
-      item& item = *entry.second;
+    map.for_each([&](uint32_t kid, LRU_queue::iterator& entry) {
+      item& item = *entry;
       // HT key had better only point to objects with the same kid.
-      if (entry.first != item.req.kid) {
+      if (kid != item.entry.kid) {
         std::cerr << "Mismatch! map entry "
-                  << entry.first << " != " << item.req.kid << std::endl;
-        item.req.dump();
+                  << kid << " != " << item.entry.kid << std::endl;
+        item.entry.dump();
       }
-      assert(entry.first == item.req.kid);
+      assert(kid == item.entry.kid);
       // Better not see the same kid twice among the objects in the HT.
-      assert(seen.find(item.req.kid) == seen.end());
-      reachable_from_map += item.req.size();
-      seen.insert(item.req.kid);
-    }
+      assert(seen.find(item.entry.kid) == seen.end());
+      reachable_from_map += item.entry.size();
+      seen.insert(item.entry.kid);
+    });
     if (reachable_from_map > stored_in_whole_cache) {
       std::cerr << "reachable_from_map: " << reachable_from_map << std::endl
                 << "stored_in_whole_cache: " << stored_in_whole_cache
@@ -904,7 +1008,7 @@ void lsc_multi::clean()
 
       std::unordered_map<int32_t, size_t> per_app_in_use{};
       for (item& item : segment->queue)
-        per_app_in_use[item.req.appid] += item.req.size();
+        per_app_in_use[item.entry.appid] += item.entry.size();
       for (auto& pr : per_app_in_use) {
         int32_t appid = pr.first;
         size_t bytes_in_srcs = pr.second;
@@ -6,7 +6,11 @@
 
 #include "common.h"
 #include "lru.h"
+#include "cache_entry.h"
+#include "key_map.h"
+#include "mem_usage.h"
 #include "policy.h"
+#include "glibc_rand.h"
 
 #ifndef LSC_MULTI_H
 #define LSC_MULTI_H
@@ -25,23 +29,28 @@ class lsc_multi : public Policy {
       public:
         item(segment* seg, const Request& req)
           : seg{seg}
-          , req{req}
+          , entry{req}
         {}
 
-        // Sorting by Request timestamp is ok, because we also
-        // store the Request object even when the access is a
+        item(segment* seg, const cache_entry& entry)
+          : seg{seg}
+          , entry{entry}
+        {}
+
+        // Sorting by entry timestamp is ok, because we also
+        // store a new entry even when the access is a
         // hit to an existing object. That is, timestamps
         // represent access times as a result.
         static bool rcmp(const item* left, const item* right) {
-          return left->req.time > right->req.time;
+          return left->entry.timestamp > right->entry.timestamp;
         }
 
         segment* seg;
-        Request req;
+        cache_entry entry;
     };
 
-    typedef std::list<item> LRU_queue; 
-    typedef std::unordered_map<uint32_t, LRU_queue::iterator> hash_map;
+    typedef counted_list<item, mem_tag::segments> LRU_queue;
+    typedef key_map<LRU_queue::iterator> hash_map;
 
     class segment {
       public:
@@ -106,54 +115,54 @@ class lsc_multi : public Policy {
           cleaning_it = cleaning_q.begin();
         }
 
-        static void dump_stats_header() {
-          std::cout << "time "
-                    << "app "
-                    << "Subpolicy "
-                    << "target_mem "
-                    << "credit_bytes "
-                    << "share "
-                    << "min_mem "
-                    << "min_mem_pct "
-                    << "steal_size "
-                    << "bytes_in_use "
-                    << "need "
-                    << "hits "
-                    << "accesses "
-                    << "shadow_q_hits "
-                    << "survivor_items "
-                    << "survivor_bytes "
-                    << "evicted_items "
-                    << "evicted_bytes "
-                    << "hit_rate "
-                    << std::endl;
+        static void dump_stats_header(std::ostream &out) {
+          out << "time "
+              << "app "
+              << "Subpolicy "
+              << "target_mem "
+              << "credit_bytes "
+              << "share "
+              << "min_mem "
+              << "min_mem_pct "
+              << "steal_size "
+              << "bytes_in_use "
+              << "need "
+              << "hits "
+              << "accesses "
+              << "shadow_q_hits "
+              << "survivor_items "
+              << "survivor_bytes "
+              << "evicted_items "
+              << "evicted_bytes "
+              << "hit_rate "
+              << std::endl;
         }
 
-        void dump_stats(double time, Subpolicy Policy) {
+        void dump_stats(std::ostream &out, double time, Subpolicy Policy) {
           const char* Policy_name[3] = { "normal"
                                        , "greedy"
                                        , "static"
                                        };
-          std::cout << int64_t(time) << " "
-                    << appid << " "
-                    << Policy_name[uint32_t(Policy)] << " "
-                    << target_mem << " "
-                    << credit_bytes << " "
-                    << target_mem + credit_bytes << " "
-                    << min_mem << " "
-                    << min_mem_pct << " "
-                    << steal_size << " "
-                    << bytes_in_use << " "
-                    << need() << " "
-                    << hits << " "
-                    << accesses << " "
-                    << shadow_q_hits << " "
-                    << survivor_items << " "
-                    << survivor_bytes << " "
-                    << evicted_items << " "
-                    << evicted_bytes << " "
-                    << double(hits) / accesses << " "
-                    << std::endl;
+          out << int64_t(time) << " "
+              << appid << " "
+              << Policy_name[uint32_t(Policy)] << " "
+              << target_mem << " "
+              << credit_bytes << " "
+              << target_mem + credit_bytes << " "
+              << min_mem << " "
+              << min_mem_pct << " "
+              << steal_size << " "
+              << bytes_in_use << " "
+              << need() << " "
+              << hits << " "
+              << accesses << " "
+              << shadow_q_hits << " "
+              << survivor_items << " "
+              << survivor_bytes << " "
+              << evicted_items << " "
+              << evicted_bytes << " "
+              << double(hits) / accesses << " "
+              << std::endl;
         }
 
         double need() {
@@ -193,12 +202,6 @@ class lsc_multi : public Policy {
                  size_t target_memory,
                  size_t steal_size);
 
-    void set_tax(double tax_rate)
-    {
-      use_tax = true;
-      this->tax_rate = tax_rate;
-    }
-
     size_t process_request(const Request *r, bool warmup);
     size_t get_bytes_cached() const;
    
@@ -210,6 +213,10 @@ class lsc_multi : public Policy {
 
     virtual void dump_stats(void) {}
 
+    bool can_checkpoint() const { return true; }
+    void save(checkpoint_writer &w) const;
+    void restore(checkpoint_reader &r);
+
   private:
 
     void rollover(double timestamp);
@@ -235,9 +242,6 @@ class lsc_multi : public Policy {
     double last_idle_check;
     double last_dump;
 
-    bool use_tax;
-    double tax_rate;
-
     Subpolicy eviction_policy;
     Cleaning_policy cleaner;
 
@@ -249,6 +253,9 @@ class lsc_multi : public Policy {
     std::vector<optional<segment>> segments;
     size_t free_segments;
 
+    // Picks victims to steal from and segments for the random cleaner.
+    glibc_rand rng;
+
     lsc_multi(const lsc_multi&) = delete;
     lsc_multi& operator=(const lsc_multi&) = delete;
     lsc_multi(lsc_multi&&) = delete;
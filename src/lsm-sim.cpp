@@ -8,16 +8,39 @@
 #include <cmath>
 #include <boost/version.hpp>
 #include <cstdio>
+#include <cstring>
+#include <cerrno>
 #include <iomanip>
 #include <ctime>
 #include <chrono>
 #include <memory>
+#include <limits>
 #include <cassert>
+#include <sstream>
+#include <thread>
+#include <mutex>
+#include <map>
+#include <functional>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <fcntl.h>
+#include <unistd.h>
 
+#include "lsm-sim.h"
 #include "common.h"
 #include "request.h"
+#include "trace_reader.h"
+#include "trace_index.h"
+#include "batch_ring.h"
+#include "sweep_pool.h"
+#include "checkpoint.h"
+#include "metrics.h"
+#include "mem_usage.h"
 #include "fifo.h"
 #include "shadowlru.h"
+#include "shadowlru_apps.h"
+#include "shadowlru_parallel.h"
 #include "shadowslab.h"
 #include "partslab.h"
 #include "lsm.h"
@@ -46,33 +69,6 @@
 using namespace std::chrono;
 typedef high_resolution_clock hrc;
 
-const char* Policy_names[25] = { "shadowlru"
-                               , "fifo"
-                               , "lru"
-                               , "slab"
-                               , "shadowslab"
-                               , "partslab"
-                               , "lsm"
-                               , "multi"
-                               , "multislab"
-                               , "flashcache"
-                               , "victimcache"
-                               , "lruk"
-                               , "ripq"
-                               , "ripq_shield"
-                               , "clock"
-                               , "flashcachelruk"
-                               , "flashcachelrukclk"
-                               , "segment_util"
-                               , "ramshield"
-                               , "ramshield_fifo"
-                               , "ramshield_sel"
-                               , "replay"
-                               , "flashshield"
-							                 , "flashcachelrukclkmachinelearning"
-                               , "partitioned_LRU"
-                              };
-
 std::unordered_map<size_t, size_t> memcachier_app_size = { {1, 701423104}
                                                           , {2, 118577408}
                                                           , {3, 19450368}
@@ -97,6 +93,18 @@ std::unordered_map<size_t, size_t> memcachier_app_size = { {1, 701423104}
 /// String of arguments.
 const std::string usage =
 "-f    specify file path\n"
+"-j    number of background threads parsing a CSV trace (0: parse inline)\n"
+"-X    file of configurations to simulate in one pass over the trace\n"
+"-x    file describing a grid of configurations to sweep\n"
+"-J    number of sweep or shadowlru_parallel threads (default: one per core)\n"
+"-o    write a checkpoint at the end of warmup\n"
+"-i    start from a checkpoint instead of warming up\n"
+"-V    file of tunables to fork the run into after warmup\n"
+"-I    metrics window: trace seconds, or Requests with a trailing r\n"
+"-Q    file to write metrics to (CSV, or binary if it ends in .bin)\n"
+"-y    profile the latency of process_request and its phases\n"
+"-b    skip requests before this time\n"
+"-e    skip requests at or after this time\n"
 "-a    specify app to eval\n"
 "-r    enable rounding\n"
 "-u    specify utilization\n"
@@ -108,6 +116,9 @@ const std::string usage =
 "-g    specify slab growth factor\n"
 "-M    use memcachier slab classes\n"
 "-P    number of partitions for partslab\n"
+"-U    fraction of keys to sample for shadowlru, shadowslab and partslab\n"
+"-z    most keys to sample at once; lowers the -U rate as needed\n"
+"-q    model shadowlru curves from reuse times (AET) instead of a stack\n"
 "-S    segment size in bytes for lsm\n"
 "-B    block size in bytes for ripq and ram_shield\n"
 "-E    eviction Subpolicy (for multi)\n"
@@ -126,140 +137,205 @@ const std::string usage =
 "-Y    number of partitions\n"
 "-O    maximum size of object that can be cached\n";
 
+/// getopt() string of the arguments above.
+const char* options = "p:s:l:f:j:b:e:X:x:J:o:i:V:I:Q:ya:ru:w:vhg:MP:U:z:qS:B:E:N:W:"
+                      "T:t:m:d:F:n:D:L:K:k:H:C:c:A:C:Y:Z:R:G:";
+
 /// Memcachier slab allocations at t=86400 (24 hours)
 const int orig_alloc[15] = {
   1664, 2304, 512, 17408, 266240, 16384, 73728, 188416, 442368,
   3932160, 11665408, 34340864, 262144, 0 , 0
 };
 
-/// Possible Policy types.
-enum Pol_type 
-{ 
-    SHADOWLRU = 0
-  , FIFO
-  , LEAST_RECENTLY_USED 
-  , SLAB
-  , SHADOWSLAB
-  , PARTSLAB
-  , LSM
-  , MULTI
-  , MULTISLAB
-  , FLASHCACHE
-  , VICTIMCACHE 
-  , LRUK
-  , RIPQ 
-  , RIPQ_SHIELD
-  , CLOCK
-  , FLASHCACHELRUK
-  , FLASHCACHELRUKCLK
-  , SEGMENT_UTIL
-  , RAMSHIELD
-  , RAMSHIELD_FIFO
-  , RAMSHIELD_SEL
-  , FLASHSHIELD
-  , REPLAY
-  , FLASHCACHELRUKCLKMACHINELEARNING
-  , PARTITIONED_LRU
-  , NONE
+/// Options setting parameters policies read from globals (the slab class
+/// table of mc.cpp, for -g and -M), shared by every Policy in the process.
+const std::string process_wide_options = "gM";
+
+/// Options a -V variant may set: tunables read as Requests arrive (see
+/// Policy::retune()) and the Request limit.
+const std::string variant_options = "kHtTl";
+
+const policy_entry* find_policy(const std::string& name)
+{
+  for (const policy_entry& entry : policy_registry)
+  {
+    if (name == entry.name)
+      return &entry;
+  }
+  return nullptr;
+}
+
+/// What a -V variant hands back to the run that forked it, through memory
+/// shared with it.
+struct variant_result {
+  bool          done;
+  double        hit_rate;
+  double        utilization;
+  size_t        accesses;
+  size_t        hits;
+  size_t        evicted_items;
+  size_t        evicted_bytes;
+  size_t        hits_flash;
+  size_t        flash_bytes_written;
+  double        seconds;
 };
 
-struct Args {
-  
-  std::unordered_map<uint32_t, uint32_t> app_steal_sizes{};
-  std::set<uint32_t> apps{};
+/// Progress of one configuration through the trace.
+struct sim_state {
+  int           i                    = 0;  //< Requests simulated so far
+  size_t        time_hour            = 1;
+  hrc::time_point last_progress      = hrc::now();
+  size_t        last_bytes           = 0;
+  uint64_t      records              = 0;  //< trace Requests looked at
+  bool          checkpointed         = false;
+  bool          indexed              = false;  //< reading through an index
 
-  bool          all_apps             = true;             //< run all by default 
-  bool          roundup              = false;            //< no rounding default
-  float         lsm_util             = 1.0;              //< default util factor
-  std::string   trace                = "data/m.cap.out"; //< default filepath
-  double        hit_start_time       = 86400;            //< default warmup time
-  size_t        global_mem           = 0;
-  bool          verbose              = false;
-  double        gfactor              = 1.25;             //< Slab growth factor.
-  bool          memcachier_classes   = false;
-  size_t        partslab_partitions  = 2;
-  size_t        segment_size         = 1 * 1024 * 1024;
-  size_t        block_size           = 1 * 1024 * 1024;
-  size_t        num_dsections        = 4;
-  size_t        min_mem_pct          = 75;
-  const size_t  default_steal_size   = 65536;
-  bool          use_tax              = false;
-  double        tax_rate             = 0.05;
-  double        priv_mem_percentage  = 0.25;
-  bool          use_percentage       = false;            // specify priv mem %
-  size_t        flash_size           = 0;
-  size_t        num_sections         = 0;
-  double        USER_SVM_TH          = 1;
-  bool          debug                = false;
-  size_t        max_overall_request_size      = 1048576; // key + value
-
-  // Only parse this many Requests from the CSV file before breaking.
-  // Helpful for limiting runtime when playing around.
-  int           Request_limit        = 0;
-
-  /// Amount of dram memory allocated for ripq_shield active_blocks.
-  size_t        dram_size            = 0;
-  double        threshold            = 0.7;
-  size_t        cleaning_width       = 100;
-
-  std::string           app_str      = "";              //< for logging apps
-  Pol_type              policy_type  = NONE;
-  lsc_multi::Subpolicy  Subpolicy    = lsc_multi::Subpolicy(0);
-  std::string           app_steal_sizes_str = "";
-
-  // The number of partitions in which to globally partition the cache.
-  uint16_t num_partitions = 1;
+  // -V: options of each variant, whether the run forked into them yet,
+  // which one this process simulates (0 in the parent) and where the
+  // variants report their results.
+  std::vector<std::string> variants{};
+  bool          forked               = false;
+  size_t        variant              = 0;
+  hrc::time_point forked_at{};
+  std::vector<pid_t> children{};
+  variant_result* results            = nullptr;
+
+  // Requests accepted but not yet handed to the Policy, all in warmup or
+  // all not (see flush_batch()).
+  std::vector<Request> pending{};
+  bool          pending_warmup       = false;
+
+  // Metrics of the windows after warmup (-Q); started by the first Request
+  // after warmup.
+  std::unique_ptr<metrics> window_metrics{};
 };
 
 /// Forward declare some utility functions.
-std::unique_ptr<Policy> create_Policy(Args& args);
-void calculate_global_memory(Args& args);
-void parse_stdin(Args& args, int argc, char** argv);
-void list_input_parameters(const Args& args);
+void flush_batch(Policy& policy, sim_state& state);
+bool simulate(Args& args, Policy& policy, const Request* batch, size_t n,
+              sim_state& state, const trace_reader* progress,
+              std::ostream& out);
+void finish_simulation(const Args& args, Policy& policy, sim_state& state);
+std::string numbered_path(const std::string& path, size_t n);
+std::string absolute_path(const std::string& path);
+void write_checkpoint(const Args& args, const Policy& policy,
+                      const sim_state& state);
+void restore_checkpoint(Args& args, Policy& policy, trace_reader& reader,
+                        sim_state& state);
+std::vector<std::string> read_variants(const Args& args);
+bool fork_variants(Args& args, Policy& policy, sim_state& state);
+int report_variants(const sim_state& state);
 
-int main(int argc, char *argv[]) 
+/// Opens the trace of a run.
+///
+/// A sidecar index (see trace-index) lets us read only the selected apps
+/// and time window. Otherwise binary traces (see csv2bin) are mapped and
+/// anything else is parsed as CSV.
+///
+/// @param apps apps the run will simulate; empty for all of them.
+std::unique_ptr<trace_reader> open_reader(const Args& args,
+                                          const std::set<uint32_t>& apps)
 {
-  Args args;
-  calculate_global_memory(args);
-  parse_stdin(args, argc, argv);
-  std::unique_ptr<Policy> Policy = create_Policy(args);
-  list_input_parameters(args);
-
-  // proc file line by line
-  std::ifstream t_stream(args.trace);
-  assert(t_stream.is_open());
-  std::string line;
-
-  int i = 0;
-  auto start = hrc::now();
-  auto last_progress = start;
-  size_t bytes = 0;
-  size_t time_hour = 1; 
+  std::unique_ptr<trace_reader> reader =
+    open_indexed_trace(args.trace, apps, args.begin_time, args.end_time);
+  if (!reader)
+    reader = open_trace(args.trace, args.parser_threads);
+  return reader;
+}
 
-  Policy->write_statistics_header();
+/// Hands the Requests simulate() has gathered to the Policy in one batch.
+void flush_batch(Policy& policy, sim_state& state)
+{
+  if (state.pending.empty())
+    return;
+  metrics* window_metrics =
+    state.pending_warmup ? nullptr : state.window_metrics.get();
+  profiler* profile = policy.get_profiler();
+  if (window_metrics || profile)
+  {
+    // Attributing hits to apps and timing Requests take them one at a time.
+    stats& stat = *policy.get_stats();
+    for (const Request& r : state.pending)
+    {
+      if (window_metrics)
+        window_metrics->advance(r, stat);
+      const size_t hits = stat.hits;
+      phase_timer timer{profile, phase::request};
+      policy.process_batch(&r, 1, state.pending_warmup);
+      timer.stop();
+      if (window_metrics)
+        window_metrics->add(r, stat.hits != hits);
+    }
+  }
+  else
+  {
+    policy.process_batch(state.pending.data(), state.pending.size(),
+                         state.pending_warmup);
+  }
+  state.pending.clear();
+}
 
-  while (std::getline(t_stream, line) &&
-        (args.Request_limit == 0 || i < args.Request_limit))
+/// Feeds a batch of trace Requests to a Policy, skipping the ones the
+/// configuration in \a args doesn't simulate.
+///
+/// Requests are handed to Policy::process_batch() in runs of up to
+/// policy_batch_size. A run ends early wherever the driver looks at the
+/// Policy (sample points, dumps, checkpoints, forks) or changes what it
+/// sees (warmup ending, a new app), so results are those of processing
+/// Requests one by one.
+///
+/// @param progress reader to report progress of with -v; nullptr for none.
+/// @param out where per-interval dumps go.
+///
+/// @return false once the configuration's Request limit (-l) is reached.
+bool simulate(Args& args, Policy& policy, const Request* batch, size_t n,
+              sim_state& state, const trace_reader* progress,
+              std::ostream& out)
+{
+  for (size_t j = 0; j < n; ++j)
   {
-    Request r{line};
-    bytes += line.size();
-    if (args.verbose && ((i & ((1 << 18) - 1)) == 0)) 
+    if (args.Request_limit != 0 && state.i >= args.Request_limit)
+    {
+      flush_batch(policy, state);
+      return false;
+    }
+    const Request &r = batch[j];
+    if (!args.checkpoint_out.empty() && !state.checkpointed &&
+        r.time >= args.hit_start_time)
+    {
+      flush_batch(policy, state);
+      write_checkpoint(args, policy, state);
+      state.checkpointed = true;
+    }
+    if (!state.variants.empty() && !state.forked &&
+        r.time >= args.hit_start_time)
+    {
+      flush_batch(policy, state);
+      // The parent leaves the rest of the trace to its variants.
+      if (!fork_variants(args, policy, state))
+        return false;
+    }
+    ++state.records;
+    if (args.verbose && progress && ((state.i & ((1 << 18) - 1)) == 0)) 
     {
       auto now  = hrc::now();
       double seconds 
-        = duration_cast<nanoseconds>(now - last_progress).count() / 1e9;
+        = duration_cast<nanoseconds>(now - state.last_progress).count() / 1e9;
       if (seconds > 1.0) 
       {
-        stats* stats = Policy->get_stats();
+        stats* stats = policy.get_stats();
+        size_t bytes = progress->get_bytes_read() - state.last_bytes;
         std::cerr << "Progress: " << std::setprecision(10) << r.time << " "
                   << "Rate: " << bytes / (1 << 20) / seconds << " MB/s "
                   << "Hit Rate: " << stats->get_hit_rate() * 100 << "% "
                   << "Evicted Items: " << stats->evicted_items << " "
                   << "Evicted Bytes: " << stats->evicted_bytes << " "
-                  << "Utilization: " << stats->get_utilization()
-                  << std::endl;
-        bytes = 0;
-        last_progress = now;
+                  << "Utilization: " << stats->get_utilization() << " "
+                  << "Memory (MB live/peak): ";
+        write_mem_usage(std::cerr);
+        std::cerr << std::endl;
+        state.last_bytes += bytes;
+        state.last_progress = now;
       }
     }
 
@@ -271,11 +347,17 @@ int main(int argc, char *argv[])
     {
       continue;
     }
+    if (r.time < args.begin_time || r.time >= args.end_time)
+    {
+      continue;
+    }
     const bool in_apps =
       std::find(std::begin(args.apps), std::end(args.apps), r.appid) 
       != std::end(args.apps);
     if (args.all_apps && !in_apps) 
     {
+      // Policies may look at the apps seen so far.
+      flush_batch(policy, state);
       args.apps.insert(r.appid);
     } 
     else if (!in_apps) 
@@ -284,7 +366,18 @@ int main(int argc, char *argv[])
     }
 
     bool warmup_period_active = r.time < args.hit_start_time;
-    Policy->process_request(&r, warmup_period_active);
+    if (warmup_period_active != state.pending_warmup)
+      flush_batch(policy, state);
+    if (!warmup_period_active && !state.window_metrics &&
+        !args.metrics_path.empty())
+    {
+      state.window_metrics.reset(new metrics{args.metrics_path,
+        args.metrics_interval, args.metrics_requests});
+    }
+    state.pending_warmup = warmup_period_active;
+    state.pending.push_back(r);
+    if (state.pending.size() == policy_batch_size)
+      flush_batch(policy, state);
     //assert(r.key_sz + r.val_sz < 3200);
 
     /// This is used to measure the number of requests with overall size greater
@@ -295,38 +388,926 @@ int main(int argc, char *argv[])
     /*   std::cout << r.time << std::endl; */
     /* } */
 
-    if (!warmup_period_active && static_cast<size_t>(r.time*1000000) % 1000 == 0)
+    // Metrics (-Q) replace these irregular samples.
+    if (!warmup_period_active && args.metrics_path.empty() &&
+        static_cast<size_t>(r.time*1000000) % 1000 == 0)
     {
-      Policy->log_statistics_sample_point(r.time);
+      flush_batch(policy, state);
+      policy.log_statistics_sample_point(r.time);
     }
 
-    if (args.verbose && ( args.policy_type == FLASHSHIELD || args.policy_type == VICTIMCACHE || 
-          args.policy_type == RIPQ ) && time_hour * 3600 < r.time) 
+    if (args.verbose && args.policy->hourly_dumps &&
+        state.time_hour * 3600 < r.time)
     {
-      printf ("Dumping stats for FLASHSHIELD\n");
-	    Policy->dump_stats();
-	    time_hour++;
+      flush_batch(policy, state);
+      out << "Dumping stats for FLASHSHIELD" << std::endl;
+      policy.dump_stats();
+      state.time_hour++;
     }
-    ++i;
+    ++state.i;
   }
+  flush_batch(policy, state);
+  return true;
+}
 
-  auto stop = hrc::now();
+/// Writes the results of a Policy once the trace has been simulated.
+void finish_simulation(const Args& args, Policy& policy, sim_state& state)
+{
+  if (state.window_metrics)
+  {
+    state.window_metrics->finish(*policy.get_stats());
+    state.window_metrics.reset();
+  }
 
   // Log curves for shadowlru, shadowslab, and partslab.
-  if (args.policy_type == 0 || args.policy_type == 4 || args.policy_type == 5)
+  if (args.policy->curves)
   {
-    Policy->log_curves();
+    policy.log_curves();
   }
  
   // Dump stats for all policies. 
-  Policy->dump_stats();
-  double seconds = duration_cast<milliseconds>(stop - start).count() / 1000.;
-  (void)seconds;
-  // std::cerr << "total execution time: " << seconds << std::endl;
+  policy.dump_stats();
+  policy.write_profile();
+  if (args.verbose)
+    write_mem_table(std::cerr);
+}
+
+/// @return \a path with \a n inserted before its extension, so each of
+/// several runs writes its own file, e.g. "metrics.3.csv" for "metrics.csv".
+std::string numbered_path(const std::string& path, size_t n)
+{
+  const size_t slash = path.rfind('/');
+  size_t dot = path.rfind('.');
+  if (dot == std::string::npos ||
+      (slash != std::string::npos && dot < slash))
+    dot = path.size();
+  return path.substr(0, dot) + "." + std::to_string(n) + path.substr(dot);
+}
+
+/// @return \a path relative to the working directory as an absolute one, so
+/// it still names the same file after a chdir().
+std::string absolute_path(const std::string& path)
+{
+  if (path.empty() || path[0] == '/')
+    return path;
+  std::vector<char> cwd(4096);
+  if (!getcwd(cwd.data(), cwd.size()))
+  {
+    std::cerr << "Couldn't get the working directory: " << strerror(errno)
+              << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  return std::string{cwd.data()} + "/" + path;
+}
+
+/// Size and modification time of a trace, so a checkpoint is only restored
+/// against the trace it was taken on.
+std::pair<uint64_t, int64_t> trace_identity(const std::string& trace)
+{
+  struct stat st{};
+  if (stat(trace.c_str(), &st) != 0)
+  {
+    std::cerr << "Couldn't stat " << trace << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  return {uint64_t(st.st_size),
+          int64_t(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec};
+}
+
+/// Writes the state of a run at the end of its warmup to the checkpoint
+/// named by -o: what the warmed up state depends on (to check when it is
+/// restored), how far into the trace the run is, and the Policy itself.
+void write_checkpoint(const Args& args, const Policy& policy,
+                      const sim_state& state)
+{
+  auto start = hrc::now();
+  checkpoint_writer w{args.checkpoint_out};
+
+  const std::pair<uint64_t, int64_t> trace = trace_identity(args.trace);
+  w.put(trace.first);
+  w.put(trace.second);
+  w.put(state.indexed);
+  w.put_string(args.policy->name);
+  w.put(args.hit_start_time);
+  w.put(args.begin_time);
+  w.put(args.max_overall_request_size);
+  w.put(args.all_apps);
+  w.put(uint64_t(args.apps.size()));
+  for (uint32_t appid : args.apps)
+    w.put(appid);
+
+  w.put(state.records);
+  w.put(state.i);
+  w.put(state.time_hour);
+
+  policy.save(w);
+  w.finish();
+
+  double seconds =
+    duration_cast<milliseconds>(hrc::now() - start).count() / 1000.;
+  std::cerr << "checkpoint " << args.checkpoint_out << " written after "
+            << state.records << " trace Requests in " << seconds << " s"
+            << std::endl;
+}
+
+/// Restores the run in the checkpoint named by -i into \a policy, which
+/// was built from the same options, and moves \a reader past the Requests
+/// the checkpoint has simulated.
+void restore_checkpoint(Args& args, Policy& policy, trace_reader& reader,
+                        sim_state& state)
+{
+  checkpoint_reader r{args.checkpoint_in};
+
+  const std::pair<uint64_t, int64_t> trace = trace_identity(args.trace);
+  r.expect(trace.first, "trace (-f)");
+  r.expect(trace.second, "trace (-f)");
+  r.expect(state.indexed, "trace index");
+  if (r.get_string() != args.policy->name)
+    r.mismatch("policy (-p)");
+  r.expect(args.hit_start_time, "warmup period (-w)");
+  r.expect(args.begin_time, "begin time (-b)");
+  r.expect(args.max_overall_request_size, "maximum request size (-R)");
+  r.expect(args.all_apps, "set of apps (-a)");
+  std::set<uint32_t> apps{};
+  const uint64_t napps = r.get<uint64_t>();
+  for (uint64_t i = 0; i < napps; ++i)
+    apps.insert(r.get<uint32_t>());
+  if (!args.all_apps && apps != args.apps)
+    r.mismatch("set of apps (-a)");
+  // Apps met during warmup; the Policy's stats point at this set.
+  args.apps = apps;
+
+  state.records = r.get<uint64_t>();
+  state.i = r.get<int>();
+  state.time_hour = r.get<size_t>();
+
+  policy.restore(r);
+  r.finish();
+
+  if (reader.skip(state.records) != state.records)
+    r.mismatch("trace (-f)");
+}
+
+/// Reads the variants of a run from the file named by -V: one line of
+/// options (see variant_options) per variant, applied on top of the rest
+/// of the run's options once warmup ends. Blank lines and lines starting
+/// with '#' are skipped.
+std::vector<std::string> read_variants(const Args& args)
+{
+  std::ifstream in{args.variant_list};
+  if (!in.is_open())
+  {
+    std::cerr << "Couldn't open variant list " << args.variant_list
+              << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  std::vector<std::string> variants{};
+  std::string line{};
+  while (std::getline(in, line))
+  {
+    size_t first = line.find_first_not_of(" \t\r");
+    if (first == std::string::npos || line[first] == '#')
+      continue;
+
+    std::vector<std::string> tokens{};
+    std::istringstream ss{line};
+    std::string token{};
+    while (ss >> token)
+    {
+      if (token.size() != 2 || token[0] != '-' ||
+          variant_options.find(token[1]) == std::string::npos)
+      {
+        std::cerr << "Option " << token << " in variant \"" << line
+                  << "\" can't change after warmup" << std::endl;
+        exit(EXIT_FAILURE);
+      }
+      tokens.push_back(token);
+      if (!(ss >> token))
+      {
+        std::cerr << "Option " << tokens.back() << " in variant \"" << line
+                  << "\" needs a value" << std::endl;
+        exit(EXIT_FAILURE);
+      }
+      tokens.push_back(token);
+    }
+    variants.push_back(line);
+  }
+  if (variants.empty())
+  {
+    std::cerr << "No variants in " << args.variant_list << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  return variants;
+}
+
+/// Forks the run into its -V variants at the end of warmup. Each child
+/// applies the options of one variant to its copy-on-write copy of the
+/// warmed up Policy and simulates the rest of the trace, printing what the
+/// run would have printed to <list>.<n>.out. Its data files go to the
+/// directory <list>.<n>, which it runs in, so variants don't overwrite
+/// each other's; the parent only waits for them (see report_variants()).
+///
+/// @return true in a child, false in the parent.
+bool fork_variants(Args& args, Policy& policy, sim_state& state)
+{
+  const size_t bytes = state.variants.size() * sizeof(variant_result);
+  void* shared = mmap(nullptr, bytes, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  if (shared == MAP_FAILED)
+  {
+    std::cerr << "Couldn't map memory for the results of the variants"
+              << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  state.results = static_cast<variant_result*>(shared);
+  state.forked = true;
+  state.forked_at = hrc::now();
+
+  // Children would print whatever is still buffered again.
+  std::cout.flush();
+  for (size_t v = 0; v < state.variants.size(); ++v)
+  {
+    const std::string dir = args.variant_list + "." + std::to_string(v + 1);
+    const std::string out_path = dir + ".out";
+    std::cerr << "variant " << v + 1 << ": " << state.variants[v]
+              << " (output " << out_path << ", data files in " << dir << ")"
+              << std::endl;
+
+    pid_t pid = fork();
+    if (pid < 0)
+    {
+      std::cerr << "Couldn't fork variant " << v + 1 << std::endl;
+      exit(EXIT_FAILURE);
+    }
+    if (pid > 0)
+    {
+      state.children.push_back(pid);
+      continue;
+    }
+
+    state.variant = v + 1;
+    state.children.clear();
+    int fd = open(out_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0 || dup2(fd, STDOUT_FILENO) < 0)
+    {
+      std::cerr << "Couldn't open " << out_path << " for writing" << std::endl;
+      exit(EXIT_FAILURE);
+    }
+    close(fd);
+
+    std::vector<std::string> tokens{};
+    std::istringstream ss{state.variants[v]};
+    std::string token{};
+    while (ss >> token)
+      tokens.push_back(token);
+    parse_tokens(args, tokens);
+    if (!args.metrics_path.empty())
+      args.metrics_path =
+        absolute_path(numbered_path(args.metrics_path, v + 1));
+    // The trace is opened again below, from the variant's directory.
+    args.trace = absolute_path(args.trace);
+    if ((mkdir(dir.c_str(), 0755) < 0 && errno != EEXIST) ||
+        chdir(dir.c_str()) < 0)
+    {
+      std::cerr << "Couldn't run variant " << v + 1 << " in " << dir << ": "
+                << strerror(errno) << std::endl;
+      exit(EXIT_FAILURE);
+    }
+    policy.retune(args.config, args.threshold);
+    policy.write_statistics_header();
+    return true;
+  }
+  return false;
+}
+
+/// Waits for the variants a run forked into and prints one line of results
+/// for each of them.
+///
+/// @return exit status of the run; EXIT_FAILURE if any variant failed.
+int report_variants(const sim_state& state)
+{
+  std::vector<bool> exited{};
+  for (pid_t pid : state.children)
+  {
+    int status = 0;
+    while (waitpid(pid, &status, 0) < 0 && errno == EINTR) {}
+    exited.push_back(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+  }
+
+  int status = EXIT_SUCCESS;
+  std::cout << "variant hit_rate utilization accesses hits evicted_items "
+            << "evicted_bytes hits_flash flash_bytes_written seconds options"
+            << std::endl;
+  for (size_t v = 0; v < state.variants.size(); ++v)
+  {
+    const variant_result& result = state.results[v];
+    std::cout << v + 1 << " ";
+    if (!exited[v] || !result.done)
+    {
+      std::cout << "failed " << state.variants[v] << std::endl;
+      status = EXIT_FAILURE;
+      continue;
+    }
+    std::cout << std::setprecision(10) << result.hit_rate << " "
+              << result.utilization << " "
+              << result.accesses << " "
+              << result.hits << " "
+              << result.evicted_items << " "
+              << result.evicted_bytes << " "
+              << result.hits_flash << " "
+              << result.flash_bytes_written << " "
+              << result.seconds << " "
+              << state.variants[v] << std::endl;
+  }
+  munmap(state.results, state.variants.size() * sizeof(variant_result));
+  return status;
+}
+
+/// Simulates all of \a reader's trace with one Policy.
+void simulate_trace(Args& args, Policy& policy, trace_reader& reader,
+                    std::ostream& out)
+{
+  std::vector<Request> batch(4096);
+  sim_state state{};
+  state.indexed = dynamic_cast<indexed_trace_reader*>(&reader) != nullptr;
+
+  if (!(args.checkpoint_out.empty() && args.checkpoint_in.empty()) &&
+      !policy.can_checkpoint())
+  {
+    std::cerr << "Policy " << args.policy->name << " can't be checkpointed"
+              << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  if (!args.variant_list.empty())
+    state.variants = read_variants(args);
+  if (!args.checkpoint_in.empty())
+    restore_checkpoint(args, policy, reader, state);
+
+  // Variants print their own header once they have forked.
+  if (state.variants.empty())
+    policy.write_statistics_header();
+
+  trace_reader* source = &reader;
+  std::unique_ptr<trace_reader> reopened{};
+  uint64_t records_read = state.records;
+  size_t n = 0;
+  while ((n = source->read(batch.data(), batch.size())) > 0)
+  {
+    records_read += n;
+    if (!simulate(args, policy, batch.data(), n, state, source, out))
+      break;
+    if (state.variant > 0 && !reopened)
+    {
+      // The parent's reader may share its file offset with us or depend on
+      // threads that didn't survive fork(); read on through our own.
+      reopened = open_reader(args,
+        args.all_apps ? std::set<uint32_t>{} : args.apps);
+      if (reopened->skip(records_read) != records_read)
+      {
+        std::cerr << "Variant " << state.variant << " couldn't find its "
+                  << "place in " << args.trace << std::endl;
+        exit(EXIT_FAILURE);
+      }
+      source = reopened.get();
+    }
+  }
+  if (!args.checkpoint_out.empty() && !state.checkpointed)
+  {
+    std::cerr << "Warmup didn't end before the simulation did; no "
+              << "checkpoint written" << std::endl;
+  }
+  if (state.forked && state.variant == 0)
+    exit(report_variants(state));
+  if (!state.variants.empty() && !state.forked)
+  {
+    std::cerr << "Warmup didn't end before the simulation did; no "
+              << "variants forked" << std::endl;
+    policy.write_statistics_header();
+  }
+
+  finish_simulation(args, policy, state);
+
+  if (state.variant > 0)
+  {
+    stats& stat = *policy.get_stats();
+    variant_result& result = state.results[state.variant - 1];
+    result.hit_rate = stat.get_hit_rate();
+    result.utilization = stat.get_utilization();
+    result.accesses = stat.accesses;
+    result.hits = stat.hits;
+    result.evicted_items = stat.evicted_items;
+    result.evicted_bytes = stat.evicted_bytes;
+    result.hits_flash = stat.hits_flash;
+    result.flash_bytes_written = stat.flash_bytes_written;
+    result.seconds =
+      duration_cast<milliseconds>(hrc::now() - state.forked_at).count() / 1000.;
+    result.done = true;
+
+    // The parent's reader (and its threads) aren't ours to tear down.
+    std::cout.flush();
+    exit(EXIT_SUCCESS);
+  }
+}
+
+/// Simulates every configuration listed in \a list (see -X) in one pass
+/// over the trace.
+///
+/// Each non-empty line not starting with '#' holds options that are applied
+/// on top of the command line, e.g. "-p lru -s 1048576". The trace is read
+/// once into a batch_ring that every configuration's Policy consumes on its
+/// own thread. What a configuration would print to stdout goes to
+/// <list>.<n>.out, n counting configurations from 1; files written by
+/// dump_stats and log_curves are named after the configuration as usual.
+///
+/// @return exit status of the run.
+int run_configurations(const Args& base, const std::string& list)
+{
+  std::ifstream in{list};
+  if (!in.is_open())
+  {
+    std::cerr << "Couldn't open configuration list " << list << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  std::vector<std::string> lines{};
+  std::string line{};
+  while (std::getline(in, line))
+  {
+    size_t first = line.find_first_not_of(" \t\r");
+    if (first == std::string::npos || line[first] == '#')
+      continue;
+    lines.push_back(line);
+  }
+  if (lines.empty())
+  {
+    std::cerr << "No configurations in " << list << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  // Options that set up the trace or process-wide policy parameters apply
+  // to every configuration and can only be given on the command line.
+  const std::string run_wide_options = "fjbevXxJhoiVQ" + process_wide_options;
+
+  // Policies keep pointers into their Args, so they must not move.
+  std::vector<Args> configs{};
+  configs.reserve(lines.size());
+  std::set<const policy_entry*> seen{};
+  for (const std::string& config : lines)
+  {
+    std::vector<std::string> tokens{};
+    std::istringstream ss{config};
+    std::string token{};
+    while (ss >> token)
+    {
+      if (token.size() >= 2 && token[0] == '-' &&
+          run_wide_options.find(token[1]) != std::string::npos)
+      {
+        std::cerr << "Option " << token << " in configuration \"" << config
+                  << "\" can only be given on the command line" << std::endl;
+        exit(EXIT_FAILURE);
+      }
+      tokens.push_back(token);
+    }
+    configs.push_back(base);
+    Args& args = configs.back();
+    parse_tokens(args, tokens);
+    if (!args.metrics_path.empty())
+      args.metrics_path = numbered_path(args.metrics_path, configs.size());
+
+    if (args.policy && args.policy->single_instance &&
+        !seen.insert(args.policy).second)
+    {
+      std::cerr << "Policy " << args.policy->name
+                << " can only appear in one configuration" << std::endl;
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  std::set<uint32_t> apps{};
+  for (const Args& args : configs)
+  {
+    if (args.all_apps)
+    {
+      apps.clear();
+      break;
+    }
+    apps.insert(args.apps.begin(), args.apps.end());
+  }
+  std::unique_ptr<trace_reader> reader = open_reader(base, apps);
+
+  std::vector<std::unique_ptr<std::ofstream>> outputs{};
+  std::vector<std::unique_ptr<Policy>> policies{};
+  for (size_t c = 0; c < configs.size(); ++c)
+  {
+    Args& args = configs[c];
+    args.key_space = reader->get_key_space();
+
+    const std::string out_path = list + "." + std::to_string(c + 1) + ".out";
+    outputs.emplace_back(new std::ofstream{out_path});
+    if (!outputs.back()->is_open())
+    {
+      std::cerr << "Couldn't open " << out_path << " for writing" << std::endl;
+      exit(EXIT_FAILURE);
+    }
+
+    policies.push_back(create_Policy(args, *outputs.back()));
+
+    std::cerr << "configuration " << c + 1 << ": " << lines[c]
+              << " (output " << out_path << ")" << std::endl;
+    list_input_parameters(args);
+  }
+
+  // Large batches let each thread stay on its own Policy's working set for
+  // a while; with four of them fast configurations can run a little ahead.
+  batch_ring ring{configs.size(), 4, 65536};
+  std::vector<std::thread> workers{};
+  for (size_t c = 0; c < configs.size(); ++c)
+  {
+    workers.emplace_back([&, c] {
+      Args& args = configs[c];
+      Policy& policy = *policies[c];
+      std::ostream& out = *outputs[c];
+      sim_state state{};
+
+      policy.write_statistics_header();
+      const Request* batch = nullptr;
+      size_t n = 0;
+      while ((batch = ring.acquire(c, &n)) != nullptr)
+      {
+        const bool more = simulate(args, policy, batch, n, state, nullptr, out);
+        ring.release(c);
+        if (!more)
+        {
+          ring.leave(c);
+          break;
+        }
+      }
+      finish_simulation(args, policy, state);
+    });
+  }
+
+  while (ring.has_consumers())
+  {
+    std::vector<Request>& batch = ring.begin_fill();
+    size_t n = reader->read(batch.data(), batch.size());
+    if (n == 0)
+      break;
+    ring.publish(n);
+  }
+  ring.close();
+
+  for (std::thread& worker : workers)
+    worker.join();
+
+  return 0;
+}
+
+/// One option of a sweep spec and the values it takes.
+struct sweep_axis {
+  std::string               option;
+  std::vector<std::string>  values;  //< empty for options without argument
+};
+
+/// A configuration of a sweep, with its options on top of the command line.
+struct sweep_job {
+  std::vector<std::string>  tokens;
+  Args                      args;
+  std::string               phase;
+};
+
+/// Expands a value of a sweep spec. "a..b*f" stands for a, a*f, a*f^2, ...
+/// and "a..b+d" for a, a+d, a+2d, ... up to and including b; any other
+/// value stands for itself.
+std::vector<std::string> expand_sweep_value(const std::string& value)
+{
+  const size_t dots = value.find("..");
+  if (dots == std::string::npos)
+    return {value};
+
+  // Parses all of \a s as a number.
+  auto number = [](const std::string& s, double* out) {
+    char* end = nullptr;
+    *out = strtod(s.c_str(), &end);
+    return !s.empty() && *end == '\0';
+  };
+
+  double first = 0;
+  if (!number(value.substr(0, dots), &first))
+    return {value};
+
+  const size_t step_pos = value.find_first_of("*+", dots + 2);
+  const bool geometric = step_pos != std::string::npos &&
+                         value[step_pos] == '*';
+  double last = 0;
+  double step = 0;
+  if (step_pos == std::string::npos ||
+      !number(value.substr(dots + 2, step_pos - dots - 2), &last) ||
+      !number(value.substr(step_pos + 1), &step) ||
+      first > last || (geometric ? first <= 0 || step <= 1 : step <= 0))
+  {
+    std::cerr << "Invalid range " << value
+              << " (expected a..b*factor or a..b+increment)" << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  std::vector<std::string> values{};
+  const double slack = 1e-9 * std::max(std::fabs(last), 1.0);
+  for (size_t k = 0; ; ++k)
+  {
+    const double v = geometric ? first * std::pow(step, k) : first + k * step;
+    if (v > last + slack)
+      break;
+    std::ostringstream ss{};
+    if (std::fabs(v - std::round(v)) <= slack)
+      ss << std::llround(v);
+    else
+      ss << std::setprecision(10) << v;
+    values.push_back(ss.str());
+  }
+  return values;
+}
+
+/// Reads the axes of a sweep spec (see -x): each non-empty line not
+/// starting with '#' holds an option followed by the values to sweep it
+/// over, e.g. "-s 1048576..67108864*2" or "-p lru fifo". A '#' starts a
+/// comment.
+std::vector<sweep_axis> read_sweep_spec(const std::string& spec)
+{
+  std::ifstream in{spec};
+  if (!in.is_open())
+  {
+    std::cerr << "Couldn't open sweep spec " << spec << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  std::vector<sweep_axis> axes{};
+  std::string line{};
+  while (std::getline(in, line))
+  {
+    std::istringstream ss{line};
+    std::string option{};
+    if (!(ss >> option) || option[0] == '#')
+      continue;
+
+    const char* spec_char = option.size() == 2 && option[0] == '-' &&
+                            option[1] != ':'
+                          ? strchr(options, option[1]) : nullptr;
+    if (!spec_char || strchr("xXJhoVQ", option[1]))
+    {
+      std::cerr << "Can't sweep over " << option << std::endl;
+      exit(EXIT_FAILURE);
+    }
+
+    sweep_axis axis{option, {}};
+    std::string value{};
+    while (ss >> value && value[0] != '#')
+    {
+      for (std::string& v : expand_sweep_value(value))
+        axis.values.push_back(std::move(v));
+    }
+    const bool takes_value = spec_char[1] == ':';
+    if (takes_value == axis.values.empty())
+    {
+      std::cerr << "Option " << option
+                << (takes_value ? " needs values" : " takes no value")
+                << " in sweep spec " << spec << std::endl;
+      exit(EXIT_FAILURE);
+    }
+    axes.push_back(axis);
+  }
+  if (axes.empty())
+  {
+    std::cerr << "Nothing to sweep in " << spec << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  return axes;
+}
+
+/// Estimates how many lines of its trace a run reads. A sidecar index (see
+/// trace-index) counts the lines of the selected apps and time window;
+/// otherwise the length of the whole trace is extrapolated from its first
+/// lines.
+///
+/// @param trace_lines extrapolated lengths of the traces seen so far.
+double predict_lines(const Args& args,
+                     std::map<std::string, double>& trace_lines)
+{
+  const std::string index_path = args.trace + ".idx";
+  if (access(index_path.c_str(), R_OK) == 0)
+  {
+    trace_index index{index_path};
+    if (index.matches(args.trace))
+    {
+      const trace_index_header& header = index.get_header();
+      double lines = header.num_lines;
+      if (!args.all_apps)
+      {
+        lines = 0;
+        for (uint32_t appid : args.apps)
+        {
+          const trace_index_app* app = index.find_app(appid);
+          if (app)
+            lines += app->num_lines;
+        }
+      }
+      size_t in_window = 0;
+      for (const trace_index_chunk* chunk = index.chunks_begin();
+           chunk != index.chunks_end(); ++chunk)
+      {
+        if (chunk->max_time >= args.begin_time &&
+            chunk->min_time < args.end_time)
+          ++in_window;
+      }
+      if (header.num_chunks > 0)
+        lines *= double(in_window) / header.num_chunks;
+      return lines;
+    }
+  }
+
+  auto it = trace_lines.find(args.trace);
+  if (it != trace_lines.end())
+    return it->second;
+
+  std::unique_ptr<trace_reader> reader = open_trace(args.trace, 0);
+  std::vector<Request> sample(65536);
+  const size_t n = reader->read(sample.data(), sample.size());
+  double lines = n;
+  struct stat st{};
+  if (n == sample.size() && reader->get_bytes_read() > 0 &&
+      stat(args.trace.c_str(), &st) == 0)
+  {
+    lines = double(st.st_size) * n / reader->get_bytes_read();
+  }
+  trace_lines[args.trace] = lines;
+  return lines;
+}
+
+/// Predicts the cost of a sweep job relative to the others: the Requests it
+/// simulates times the log of its cache size, as bigger caches mean bigger
+/// maps and queues and more CPU cache misses per Request.
+double predict_cost(const Args& args,
+                    std::map<std::string, double>& trace_lines)
+{
+  double requests = predict_lines(args, trace_lines);
+  if (args.Request_limit > 0)
+    requests = std::min(requests, double(args.Request_limit));
+  return requests * std::log2(std::max(double(args.global_mem), 2.));
+}
+
+/// Runs every configuration of the grid described by \a spec (see -x) on a
+/// sweep_pool, predicted longest first.
+///
+/// Each job reads the trace on its own. What job n would print to stdout
+/// goes to <spec>.<n>.out, n counting jobs from 1 in the order the grid
+/// lists them (the last axis varying fastest); files written by dump_stats
+/// and log_curves are named after the configuration as usual.
+///
+/// Slab policies still read the slab class table from globals
+/// (process_wide_options) and some policies keep state in them
+/// (policy_entry::single_instance). Jobs that disagree on the
+/// former, or use one of the latter, run in separate phases, one phase
+/// after the other.
+///
+/// @return exit status of the run.
+int run_sweep(const Args& base, const std::string& spec)
+{
+  std::vector<sweep_axis> axes = read_sweep_spec(spec);
+  // Global parameters first, then the flash sizes, so every job sets them
+  // before other options (such as -p flashcache) read them.
+  auto is_global = [](const sweep_axis& a) {
+    return process_wide_options.find(a.option[1]) != std::string::npos;
+  };
+  std::stable_partition(axes.begin(), axes.end(), [](const sweep_axis& a) {
+    return a.option == "-D" || a.option == "-F";
+  });
+  std::stable_partition(axes.begin(), axes.end(), is_global);
+  size_t global_tokens = 0;
+  for (const sweep_axis& axis : axes)
+  {
+    if (is_global(axis))
+      global_tokens += axis.values.empty() ? 1 : 2;
+  }
+
+  std::vector<std::vector<std::string>> grid{{}};
+  for (const sweep_axis& axis : axes)
+  {
+    std::vector<std::vector<std::string>> next{};
+    for (const std::vector<std::string>& tokens : grid)
+    {
+      if (axis.values.empty())
+      {
+        next.push_back(tokens);
+        next.back().push_back(axis.option);
+      }
+      for (const std::string& value : axis.values)
+      {
+        next.push_back(tokens);
+        next.back().push_back(axis.option);
+        next.back().push_back(value);
+      }
+    }
+    grid.swap(next);
+  }
+
+  // Policies keep pointers into their Args, so they must not move.
+  std::vector<sweep_job> jobs{};
+  jobs.reserve(grid.size());
+  std::vector<std::pair<std::string, std::vector<size_t>>> phases{};
+  std::map<std::string, double> trace_lines{};
+  std::vector<double> costs{};
+  for (const std::vector<std::string>& tokens : grid)
+  {
+    jobs.push_back(sweep_job{tokens, base, ""});
+    sweep_job& job = jobs.back();
+    parse_tokens(job.args, tokens);
+    if (!job.args.metrics_path.empty())
+      job.args.metrics_path = numbered_path(job.args.metrics_path, jobs.size());
+
+    if (job.args.policy && job.args.policy->single_instance)
+    {
+      job.phase = "job " + std::to_string(jobs.size());
+    }
+    else
+    {
+      for (size_t t = 0; t < global_tokens; ++t)
+        job.phase += " " + tokens[t];
+    }
+    auto phase = std::find_if(phases.begin(), phases.end(),
+      [&](const std::pair<std::string, std::vector<size_t>>& p) {
+        return p.first == job.phase;
+      });
+    if (phase == phases.end())
+      phase = phases.insert(phases.end(), {job.phase, {}});
+    phase->second.push_back(jobs.size() - 1);
+
+    costs.push_back(predict_cost(job.args, trace_lines));
+  }
+
+  size_t threads = base.sweep_threads;
+  if (threads == 0)
+    threads = std::max(1u, std::thread::hardware_concurrency());
+  std::cerr << "sweeping " << jobs.size() << " configurations in "
+            << phases.size() << " phase(s) on " << threads << " threads"
+            << std::endl;
+
+  std::mutex log_mutex{};
+  sweep_pool pool{threads};
+  for (const auto& phase : phases)
+  {
+    std::vector<sweep_pool::job> work{};
+    for (size_t j : phase.second)
+    {
+      work.push_back({costs[j], [&, j] {
+        sweep_job& job = jobs[j];
+        const std::string out_path = spec + "." + std::to_string(j + 1) +
+                                     ".out";
+        std::string config{};
+        for (const std::string& token : job.tokens)
+          config += (config.empty() ? "" : " ") + token;
+
+        std::ofstream out{out_path};
+        if (!out.is_open())
+        {
+          std::cerr << "Couldn't open " << out_path << " for writing"
+                    << std::endl;
+          exit(EXIT_FAILURE);
+        }
+
+        auto start = hrc::now();
+        std::unique_ptr<trace_reader> reader = open_reader(job.args,
+          job.args.all_apps ? std::set<uint32_t>{} : job.args.apps);
+        job.args.key_space = reader->get_key_space();
+        std::unique_ptr<Policy> policy = create_Policy(job.args, out);
+        simulate_trace(job.args, *policy, *reader, out);
+        double seconds =
+          duration_cast<milliseconds>(hrc::now() - start).count() / 1000.;
+
+        std::lock_guard<std::mutex> lock{log_mutex};
+        std::cerr << "job " << j + 1 << ": " << config << " (output "
+                  << out_path << ") took " << seconds << " s" << std::endl;
+      }});
+    }
+    pool.run(std::move(work));
+  }
 
   return 0;
 }
 
+/// Parses options of a configuration, e.g. {"-p", "lru"}, on top of the
+/// ones already in \a args.
+void parse_tokens(Args& args, std::vector<std::string> tokens)
+{
+  tokens.insert(tokens.begin(), "lsm-sim");
+  std::vector<char*> argv{};
+  for (std::string& t : tokens)
+    argv.push_back(&t[0]);
+  argv.push_back(nullptr);
+
+  optind = 0;
+  parse_stdin(args, int(tokens.size()), argv.data());
+}
+
 /// Calculates global memory from the Memcachier data points.
 ///
 /// @param Args struct to populate with the global memory value.
@@ -350,8 +1331,7 @@ void parse_stdin(Args& args, int argc, char** argv)
   // parse cmd args
   int c;
   std::vector<int32_t> ordered_apps{};
-  while ((c = getopt(argc, argv, "p:s:l:f:a:ru:w:vhg:MP:S:B:E:N:W:T:t:m:d:F:n:"
-                                 "D:L:K:k:C:c:A:C:Y:Z:R:G:")) != -1)
+  while ((c = getopt(argc, argv, options)) != -1)
   {
     switch (c)
     {
@@ -359,84 +1339,13 @@ void parse_stdin(Args& args, int argc, char** argv)
         args.trace = optarg;
         break;
       case 'p':
-        if (std::string(optarg) == "shadowlru")
-          args.policy_type = Pol_type(Pol_type::SHADOWLRU); 
-        else if (std::string(optarg) == "fifo")
-          args.policy_type = Pol_type(Pol_type::FIFO); 
-        else if (std::string(optarg) == "lru")
-          args.policy_type = Pol_type(Pol_type::LEAST_RECENTLY_USED); 
-        else if (std::string(optarg) == "slab")
-          args.policy_type = Pol_type(Pol_type::SLAB);
-        else if (std::string(optarg) == "shadowslab")
-          args.policy_type = Pol_type(Pol_type::SHADOWSLAB);
-        else if (std::string(optarg) == "partslab")
-          args.policy_type = Pol_type(Pol_type::PARTSLAB);
-        else if (std::string(optarg) == "lsm")
-          args.policy_type = Pol_type(Pol_type::LSM);
-        else if (std::string(optarg) == "multi")
-          args.policy_type = Pol_type(Pol_type::MULTI);
-        else if (std::string(optarg) == "multislab")
-          args.policy_type = Pol_type(Pol_type::MULTISLAB);
-        else if (std::string(optarg) == "flashcache")
-        {
-          args.policy_type = Pol_type(Pol_type::FLASHCACHE);
-          args.global_mem = DRAM_SIZE + FLASH_SIZE;
-        }
-        else if (std::string(optarg) == "victimcache")
-        {
-          args.policy_type = Pol_type(Pol_type::VICTIMCACHE);
-          args.global_mem = DRAM_SIZE + FLASH_SIZE;
-        }
-        else if (std::string(optarg) == "lruk")
-          args.policy_type = Pol_type(Pol_type::LRUK);
-        else if (std::string(optarg) == "ripq")
-        {
-          args.policy_type = Pol_type(Pol_type::RIPQ);
-          args.global_mem = DRAM_SIZE + FLASH_SIZE;
-        }
-        else if (std::string(optarg) == "ripq_shield")
-        {
-          args.policy_type = Pol_type(Pol_type::RIPQ_SHIELD);
-          args.global_mem = DRAM_SIZE + FLASH_SIZE;
-        }
-        else if (std::string(optarg) == "clock")
-          args.policy_type = Pol_type(Pol_type::CLOCK);
-        else if (std::string(optarg) == "flashcachelruk")
-        {
-          args.policy_type = Pol_type(Pol_type::FLASHCACHELRUK);
-          args.global_mem = DRAM_SIZE + FLASH_SIZE;
-        }
-        else if (std::string(optarg) == "flashcachelrukclk")
-        {
-          args.policy_type = Pol_type(Pol_type::FLASHCACHELRUKCLK);
-          args.global_mem = DRAM_SIZE + FLASH_SIZE;
-        }
-        else if (std::string(optarg) == "segment_util")
-          args.policy_type = Pol_type(Pol_type::SEGMENT_UTIL);
-        else if (std::string(optarg) == "ramshield")
-          args.policy_type = Pol_type(Pol_type::RAMSHIELD);  
-        else if (std::string(optarg) == "ramshield_fifo")
-          args.policy_type = Pol_type(Pol_type::RAMSHIELD_FIFO);
-        else if (std::string(optarg) == "ramshield_sel")
-          args.policy_type = Pol_type(Pol_type::RAMSHIELD_SEL);
-        else if (std::string(optarg) == "replay")
-          args.policy_type = Pol_type(Pol_type::REPLAY);
-        else if (std::string(optarg) == "flashshield") 
-        {
-          args.policy_type = Pol_type(Pol_type::FLASHSHIELD);
-          args.global_mem = DRAM_SIZE + FLASH_SIZE;
-        }
-		    else if (std::string(optarg) == "flashcachelrukclkmachinelearning")
-        {
-          args.policy_type = Pol_type(Pol_type::FLASHCACHELRUKCLKMACHINELEARNING);
-          args.global_mem = DRAM_SIZE + FLASH_SIZE;
-        }
-        else if (std::string(optarg) == "partitioned_LRU")
-          args.policy_type = Pol_type(Pol_type::PARTITIONED_LRU);
-        else {
+        args.policy = find_policy(optarg);
+        if (!args.policy) {
           std::cerr << "Invalid Policy specified" << std::endl;
           exit(EXIT_FAILURE);
         }
+        if (args.policy->flash)
+          args.global_mem = args.config.dram_size + args.config.flash_size;
         break;
       case 'E':
         if (std::string(optarg) == "normal")
@@ -465,6 +1374,53 @@ void parse_stdin(Args& args, int argc, char** argv)
       case 'l':
         args.Request_limit = atoi(optarg); 
         break;
+      case 'j':
+        args.parser_threads = atol(optarg);
+        break;
+      case 'b':
+        args.begin_time = atof(optarg);
+        break;
+      case 'e':
+        args.end_time = atof(optarg);
+        break;
+      case 'X':
+        args.config_list = optarg;
+        break;
+      case 'x':
+        args.sweep_spec = optarg;
+        break;
+      case 'J':
+        args.sweep_threads = atol(optarg);
+        break;
+      case 'o':
+        args.checkpoint_out = optarg;
+        break;
+      case 'i':
+        args.checkpoint_in = optarg;
+        break;
+      case 'V':
+        args.variant_list = optarg;
+        break;
+      case 'I':
+      {
+        char* end = nullptr;
+        const double window = strtod(optarg, &end);
+        const bool by_requests = *end == 'r';
+        if (window <= 0 || *(by_requests ? end + 1 : end) != '\0')
+        {
+          std::cerr << "Invalid metrics window " << optarg << std::endl;
+          exit(EXIT_FAILURE);
+        }
+        args.metrics_interval = by_requests ? 0 : window;
+        args.metrics_requests = by_requests ? uint64_t(window) : 0;
+        break;
+      }
+      case 'Q':
+        args.metrics_path = optarg;
+        break;
+      case 'y':
+        args.profile = true;
+        break;
       case 'a':
         {
           string_vec v;
@@ -503,6 +1459,20 @@ void parse_stdin(Args& args, int argc, char** argv)
       case 'P':
         args.partslab_partitions = atoi(optarg); 
         break;
+      case 'U':
+        args.sample_rate = atof(optarg);
+        if (!(args.sample_rate > 0 && args.sample_rate <= 1))
+        {
+          std::cerr << "Invalid sampling rate " << optarg << std::endl;
+          exit(EXIT_FAILURE);
+        }
+        break;
+      case 'z':
+        args.sample_keys = atol(optarg);
+        break;
+      case 'q':
+        args.use_aet = true;
+        break;
       case 'W':
         {
           string_vec v{};
@@ -519,32 +1489,24 @@ void parse_stdin(Args& args, int argc, char** argv)
         args.cleaning_width = atol(optarg);
         break;
       case 'T':
-        args.use_tax = true;
-        args.tax_rate = atol(optarg) / 100.;
+        args.config.use_tax = true;
+        args.config.tax_rate = atol(optarg) / 100.;
         break;
       case 'm':
         args.priv_mem_percentage = atof(optarg);
         args.use_percentage = true;
         break;
       case 'F':
-        FLASH_SIZE = args.flash_size = atol(optarg);
-        FLASH_SIZE_FC_KLRU = args.flash_size = atol(optarg);
-        FLASH_SIZE_FC_KLRU_CLK = args.flash_size = atol(optarg);
-        FLASH_SHILD_FLASH_SIZE = args.flash_size = atol(optarg);
-		    FLASH_SIZE_FC_KLRU_CLK_ML = args.flash_size = atol(optarg);
+        args.config.flash_size = args.flash_size = atol(optarg);
         break;
       case 'D':
-        DRAM_SIZE = args.dram_size = atol(optarg);
-        DRAM_SIZE_FC_KLRU = args.dram_size = atol(optarg);
-        DRAM_SIZE_FC_KLRU_CLK = args.dram_size = atol(optarg);
-        FLASH_SHILD_DRAM_SIZE = args.dram_size = atol(optarg);
-		    DRAM_SIZE_FC_KLRU_CLK_ML = args.dram_size = atol(optarg);
-	      break;
+        args.config.dram_size = args.dram_size = atol(optarg);
+        break;
       case 'K':
-        K_LRU = atol(optarg);
+        args.config.k_lru = atol(optarg);
         break;
       case 'L':
-        KLRU_QUEUE_SIZE = atol(optarg);
+        args.config.klru_queue_size = atol(optarg);
         break;  
       case 'n':
         args.num_sections =  atol(optarg);
@@ -553,20 +1515,20 @@ void parse_stdin(Args& args, int argc, char** argv)
         args.num_dsections = atol(optarg);
         break;
       case 'k':
-        K = atof(optarg);
+        args.config.k = atof(optarg);
         break;
       case 'H':
-        L_FC = atol(optarg);
+        args.config.l_fc = atol(optarg);
         break;
       case 't':
         args.threshold = atof(optarg);
         break;
       case 'C':
-        CLOCK_MAX_VALUE = atol(optarg);
-        CLOCK_MAX_VALUE_KLRU = atol(optarg);
+        args.config.clock_max_value = atol(optarg);
+        args.config.clock_max_value_klru = atol(optarg);
         break;
       case 'A':
-        args.USER_SVM_TH = atol(optarg);
+        args.config.svm_threshold = atol(optarg);
         break;
       case 'Y':
         args.num_partitions = atoi(optarg);
@@ -589,7 +1551,7 @@ void list_input_parameters(const Args& args)
   // List input parameters
   std::cerr << "performing trace analysis on app " << args.app_str << std::endl
             << "partitions " << args.num_partitions << std::endl
-            << "policy " << Policy_names[args.policy_type] << std::endl
+            << "policy " << args.policy->name << std::endl
             << "trace " << args.trace << std::endl
             << "start counting hits at t = " << args.hit_start_time << std::endl
             << "global mem " << args.global_mem << std::endl
@@ -597,13 +1559,13 @@ void list_input_parameters(const Args& args)
   //          << "Request limit " << args.Request_limit << std::endl
   //          << "utilization rate " << args.lsm_util << std::endl
   //          << "rounding " << (args.roundup ? "on" : "off") << std::endl
-  //          << "use tax " << args.use_tax << std::endl
-  //          << "tax rate " << args.tax_rate << std::endl
+  //          << "use tax " << args.config.use_tax << std::endl
+  //          << "tax rate " << args.config.tax_rate << std::endl
   //          << "cleaning width " << args.cleaning_width << std::endl
   //          << "with steal weights of " << args.app_steal_sizes_str << std::endl
             << std::endl;
 
-  if (args.policy_type == SHADOWSLAB) 
+  if (args.policy == find_policy("shadowslab"))
   {
     if (args.memcachier_classes)
     {
@@ -618,157 +1580,243 @@ void list_input_parameters(const Args& args)
 }
 
 
-/// Factory to create a Policy of specified type with stats object included.
+/// Sets the slab class parameters of \a sts for the slab policies.
+void set_slab_classes(const Args& args, stats& sts)
+{
+  if (args.memcachier_classes) { sts.gfactor = 2.0; }
+  else { sts.gfactor = args.gfactor; }
+  sts.memcachier_classes = args.memcachier_classes;
+}
+
+/// Sets the sampling parameters of \a sts for the curve policies; only
+/// shadowlru and shadowlru_apps can model their curves with AET.
+void set_sampling(const Args& args, stats& sts)
+{
+  sts.sample_rate = args.sample_rate;
+  sts.sample_keys = args.sample_keys;
+  sts.use_aet = args.use_aet;
+  if (args.use_aet && sts.policy != "shadowlru" &&
+      sts.policy != "shadowlru_apps")
+  {
+    std::cerr << "-q only applies to shadowlru and shadowlru_apps" << std::endl;
+    exit(EXIT_FAILURE);
+  }
+}
+
+const std::vector<policy_entry> policy_registry = {
+  // name, flash, single_instance, curves, hourly_dumps, create
+  {"shadowlru", false, false, true, false,
+   [](Args& args, stats& sts) -> std::unique_ptr<Policy> {
+     set_sampling(args, sts);
+     return std::unique_ptr<Policy>{new shadowlru(sts)};
+   }},
+  {"shadowlru_apps", false, false, true, false,
+   [](Args& args, stats& sts) -> std::unique_ptr<Policy> {
+     set_sampling(args, sts);
+     return std::unique_ptr<Policy>{new shadowlru_apps(sts)};
+   }},
+  {"shadowlru_parallel", false, false, true, false,
+   [](Args& args, stats& sts) -> std::unique_ptr<Policy> {
+     if (args.sample_rate < 1 || args.sample_keys || args.use_aet)
+     {
+       std::cerr << "shadowlru_parallel computes exact curves; "
+                 << "-U, -z and -q don't apply" << std::endl;
+       exit(EXIT_FAILURE);
+     }
+     return std::unique_ptr<Policy>{
+       new shadowlru_parallel(sts, args.sweep_threads)};
+   }},
+  {"fifo", false, false, false, false,
+   [](Args&, stats& sts) -> std::unique_ptr<Policy> {
+     return std::unique_ptr<Policy>{new fifo(sts)};
+   }},
+  {"lru", false, false, false, false,
+   [](Args&, stats& sts) -> std::unique_ptr<Policy> {
+     return std::unique_ptr<Policy>{new LRU(sts)};
+   }},
+  {"slab", false, false, false, false,
+   [](Args& args, stats& sts) -> std::unique_ptr<Policy> {
+     set_slab_classes(args, sts);
+     return std::unique_ptr<Policy>{new slab(sts)};
+   }},
+  {"shadowslab", false, false, true, false,
+   [](Args& args, stats& sts) -> std::unique_ptr<Policy> {
+     set_slab_classes(args, sts);
+     set_sampling(args, sts);
+     return std::unique_ptr<Policy>{new shadowslab(sts)};
+   }},
+  {"partslab", false, false, true, false,
+   [](Args& args, stats& sts) -> std::unique_ptr<Policy> {
+     sts.partitions = args.partslab_partitions;
+     set_sampling(args, sts);
+     return std::unique_ptr<Policy>{new partslab(sts)};
+   }},
+  {"lsm", false, false, false, false,
+   [](Args& args, stats& sts) -> std::unique_ptr<Policy> {
+     sts.segment_size = args.segment_size;
+     sts.cleaning_width = args.cleaning_width;
+     return std::unique_ptr<Policy>{new lsm(sts)};
+   }},
+  {"multi", false, false, false, false,
+   [](Args& args, stats& sts) -> std::unique_ptr<Policy> {
+     sts.segment_size = args.segment_size;
+     sts.cleaning_width = args.cleaning_width;
+     lsc_multi* multi = new lsc_multi(sts, args.Subpolicy);
+     std::unique_ptr<Policy> policy{multi};
+     for (size_t appid : args.apps) {
+       assert(memcachier_app_size[appid] > 0);
+       uint32_t app_steal_size = 65536;
+       auto it = args.app_steal_sizes.find(appid);
+       if (it != args.app_steal_sizes.end()) {
+         app_steal_size = it->second;
+       } 
+       size_t private_mem = args.use_percentage ? 
+         (size_t)(memcachier_app_size[appid] * args.priv_mem_percentage) :
+         args.min_mem_pct;         
+       multi->add_app(appid,
+                      private_mem ,
+                      memcachier_app_size[appid],
+                      app_steal_size);
+     }
+     return policy;
+   }},
+  {"multislab", false, false, false, false,
+   [](Args& args, stats& sts) -> std::unique_ptr<Policy> {
+     set_slab_classes(args, sts);
+     slab_multi* slmulti = new slab_multi(sts);
+     std::unique_ptr<Policy> policy{slmulti};
+     for (size_t appid : args.apps) {
+       assert(memcachier_app_size[appid] > 0);
+       slmulti->add_app(appid, args.min_mem_pct, memcachier_app_size[appid]);
+     }
+     return policy;
+   }},
+  {"flashcache", true, false, false, false,
+   [](Args&, stats& sts) -> std::unique_ptr<Policy> {
+     return std::unique_ptr<Policy>{new FlashCache(sts)};
+   }},
+  {"victimcache", true, false, false, true,
+   [](Args&, stats& sts) -> std::unique_ptr<Policy> {
+     return std::unique_ptr<Policy>{new VictimCache(sts)};
+   }},
+  {"lruk", false, false, false, false,
+   [](Args&, stats& sts) -> std::unique_ptr<Policy> {
+     return std::unique_ptr<Policy>{new Lruk(sts)};
+   }},
+  {"ripq", true, false, false, true,
+   [](Args& args, stats& sts) -> std::unique_ptr<Policy> {
+     sts.block_size = args.block_size;
+     sts.flash_size = args.flash_size;
+     sts.num_sections = args.num_sections;
+     return std::unique_ptr<Policy>{
+       new ripq(sts, args.block_size, args.num_sections, args.flash_size)};
+   }},
+  {"ripq_shield", true, false, false, false,
+   [](Args& args, stats& sts) -> std::unique_ptr<Policy> {
+     sts.block_size = args.block_size;
+     sts.flash_size = args.flash_size;
+     sts.dram_size = args.dram_size;
+     sts.num_sections = args.num_sections;
+     sts.num_dsections = args.num_dsections;
+     return std::unique_ptr<Policy>{
+       new ripq_shield(sts, args.block_size, args.num_sections,
+                       args.dram_size, args.num_dsections, args.flash_size)};
+   }},
+  {"clock", false, false, false, false,
+   [](Args&, stats& sts) -> std::unique_ptr<Policy> {
+     return std::unique_ptr<Policy>{new Clock(sts)};
+   }},
+  {"flashcachelruk", true, false, false, false,
+   [](Args&, stats& sts) -> std::unique_ptr<Policy> {
+     return std::unique_ptr<Policy>{new FlashCacheLruk(sts)};
+   }},
+  {"flashcachelrukclk", true, false, false, false,
+   [](Args&, stats& sts) -> std::unique_ptr<Policy> {
+     return std::unique_ptr<Policy>{new FlashCacheLrukClk(sts)};
+   }},
+  {"segment_util", false, false, false, false,
+   [](Args&, stats& sts) -> std::unique_ptr<Policy> {
+     return std::unique_ptr<Policy>{new SegmentUtil(sts)};
+   }},
+  {"ramshield", false, false, false, false,
+   [](Args& args, stats& sts) -> std::unique_ptr<Policy> {
+     sts.threshold = args.threshold;
+     sts.flash_size = args.flash_size;
+     sts.dram_size = args.dram_size;
+     return std::unique_ptr<Policy>{new RamShield(sts, args.block_size)};
+   }},
+  {"ramshield_fifo", false, false, false, false,
+   [](Args& args, stats& sts) -> std::unique_ptr<Policy> {
+     sts.threshold = args.threshold;
+     sts.block_size = args.block_size;
+     sts.flash_size = args.flash_size;
+     sts.dram_size = args.dram_size;
+     return std::unique_ptr<Policy>{new RamShield_fifo(sts, args.block_size)};
+   }},
+  {"ramshield_sel", false, false, false, false,
+   [](Args& args, stats& sts) -> std::unique_ptr<Policy> {
+     sts.threshold = args.threshold;
+     sts.block_size = args.block_size;
+     sts.flash_size = args.flash_size;
+     sts.dram_size = args.dram_size;
+     return std::unique_ptr<Policy>{new RamShield_sel(sts, args.block_size)};
+   }},
+  // Replays run through the replay tool, not lsm-sim.
+  {"replay", false, false, false, false, nullptr},
+  // The Python backed policies share one interpreter and SVM model.
+  {"flashshield", true, true, false, true,
+   [](Args& args, stats& sts) -> std::unique_ptr<Policy> {
+     sts.threshold = args.threshold;
+     sts.flash_size = args.flash_size;
+     sts.dram_size = args.dram_size;
+     return std::unique_ptr<Policy>{new flashshield(sts)};
+   }},
+  {"flashcachelrukclkmachinelearning", true, true, false, false,
+   [](Args&, stats& sts) -> std::unique_ptr<Policy> {
+     return std::unique_ptr<Policy>{new FlashCacheLrukClkMachineLearning(sts)};
+   }},
+  {"partitioned_LRU", false, false, false, false,
+   [](Args& args, stats& sts) -> std::unique_ptr<Policy> {
+     return std::unique_ptr<Policy>{
+       new Partitioned_LRU(sts, args.num_partitions,
+                           args.max_overall_request_size)};
+   }},
+};
+
+/// Factory to create the Policy selected by -p with stats object included.
 ///
-/// @param policy_type the type of Policy to create
+/// @param args parameters of the run; args.policy is the Policy to create.
 ///
 /// @return std::unique_ptr<Policy> 
 std::unique_ptr<Policy> create_Policy(Args& args)
 {
-  stats sts{Policy_names[args.policy_type], &args.apps, args.global_mem};
-  std::unique_ptr<Policy> Policy{};
-   switch(args.policy_type) {
-    case SHADOWLRU : Policy.reset(new shadowlru(sts)); break;
-    case FIFO : Policy.reset(new fifo(sts)); break;
-    case LEAST_RECENTLY_USED : 
-      Policy.reset(new LRU(sts)); 
-      break;
-    case FLASHCACHE : Policy.reset(new FlashCache(sts)); break;
-    case FLASHCACHELRUK : Policy.reset(new FlashCacheLruk(sts)); break;
-    case FLASHCACHELRUKCLK : Policy.reset(new FlashCacheLrukClk(sts)); break;
-    case FLASHCACHELRUKCLKMACHINELEARNING :
-        APP_NUMBER = *std::begin(args.apps);
-        ML_SVM_TH = args.USER_SVM_TH;
-        Policy.reset(new FlashCacheLrukClkMachineLearning(sts));
-        break;
-    case VICTIMCACHE : Policy.reset(new VictimCache(sts)); break;
-    case LRUK : Policy.reset(new Lruk(sts)); break;
-    case CLOCK : Policy.reset(new Clock(sts)); break;
-    case SEGMENT_UTIL : Policy.reset(new SegmentUtil(sts)); break;
-    case SLAB :
-      if (args.memcachier_classes) { sts.gfactor = 2.0; } 
-      else { sts.gfactor = args.gfactor; }
-      sts.memcachier_classes = args.memcachier_classes;
-      Policy.reset(new slab(sts));
-      break;
-    case SHADOWSLAB:
-      if (args.memcachier_classes) { sts.gfactor = 2.0;} 
-      else { sts.gfactor = args.gfactor; }
-      sts.memcachier_classes = args.memcachier_classes;
-      Policy.reset(new shadowslab(sts));
-      break;
-    case PARTSLAB:
-      sts.partitions = args.partslab_partitions;
-      Policy.reset(new partslab(sts));
-      break;
-    case LSM:
-      sts.segment_size = args.segment_size;
-      sts.cleaning_width = args.cleaning_width;
-      Policy.reset(new lsm(sts));
-      break;
-    case MULTI:
-      sts.segment_size = args.segment_size;
-      sts.cleaning_width = args.cleaning_width;
-      {
-        lsc_multi* multi = new lsc_multi(sts, args.Subpolicy);
-        Policy.reset(multi);
-        for (size_t appid : args.apps) {
-          assert(memcachier_app_size[appid] > 0);
-          uint32_t app_steal_size = 65536;
-          auto it = args.app_steal_sizes.find(appid);
-          if (it != args.app_steal_sizes.end()) {
-            app_steal_size = it->second;
-          } 
-          size_t private_mem = args.use_percentage ? 
-            (size_t)(memcachier_app_size[appid] * args.priv_mem_percentage) :
-            args.min_mem_pct;         
-          multi->add_app(appid,
-                         private_mem ,
-                         memcachier_app_size[appid],
-                         app_steal_size);
-        }
-        if (args.use_tax) {
-          multi->set_tax(args.tax_rate);
-        }
-      }
-      break;
-    case MULTISLAB:
-    {
-      if (args.memcachier_classes) {
-        sts.gfactor = 2.0;
-      } else {
-        sts.gfactor = args.gfactor;
-      }
-      sts.memcachier_classes = args.memcachier_classes;
-      slab_multi* slmulti = new slab_multi(sts);
-      Policy.reset(slmulti);
-      for (size_t appid : args.apps) {
-        assert(memcachier_app_size[appid] > 0);
-        slmulti->add_app(appid, args.min_mem_pct, memcachier_app_size[appid]);
-      }
-      break;
-    }
-    case RIPQ:
-      sts.block_size = args.block_size;
-      sts.flash_size = args.flash_size;
-      sts.num_sections = args.num_sections;
-      Policy.reset(new ripq(sts, args.block_size, args.num_sections, args.flash_size));
-      break;
-    case RIPQ_SHIELD:
-      sts.block_size = args.block_size;
-      sts.flash_size = args.flash_size;
-      sts.dram_size = args.dram_size;
-      sts.num_sections = args.num_sections;
-      sts.num_dsections = args.num_dsections;
-      Policy.reset(new ripq_shield(sts, args.block_size, args.num_sections,
-                                   args.dram_size, args.num_dsections, args.flash_size));
-      break;
-    case RAMSHIELD:
-      sts.threshold = args.threshold;
-      sts.flash_size = args.flash_size;
-      sts.dram_size = args.dram_size;
-      Policy.reset(new RamShield(sts, args.block_size));
-      break;
-    case RAMSHIELD_FIFO:
-      sts.threshold = args.threshold;
-      sts.block_size = args.block_size;
-      sts.flash_size = args.flash_size;
-      sts.dram_size = args.dram_size;
-      Policy.reset(new RamShield_fifo(sts, args.block_size));
-      break;
-    case RAMSHIELD_SEL:
-      sts.threshold = args.threshold;
-      sts.block_size = args.block_size;
-      sts.flash_size = args.flash_size;
-      sts.dram_size = args.dram_size;
-      Policy.reset(new RamShield_sel(sts, args.block_size));
-      break;
-    case FLASHSHIELD:
-        FLASH_SHILD_APP_NUMBER = *std::begin(args.apps);
-        FLASH_SHILD_TH = args.USER_SVM_TH;
-        sts.threshold = args.threshold;
-        sts.flash_size = args.flash_size;
-        sts.dram_size = args.dram_size;
-        Policy.reset(new flashshield(sts));
-        break;
-    case REPLAY:
-        break;
-    case NONE:
-        break;
-    case PARTITIONED_LRU:
-        Policy.reset(new Partitioned_LRU(sts, 
-                                         args.num_partitions, 
-                                         args.max_overall_request_size));
-        break;
-  }
-  if (!Policy) {
+  if (!args.policy || !args.policy->create) {
     std::cerr << "No valid Policy selected!" << std::endl;
     exit(-1);
   }
-  else
-  {
-    //std::cout << "Policy created."  << std::endl;
-  }
-  return Policy; 
+
+  stats sts{args.policy->name, &args.apps, args.global_mem};
+  sts.key_space = args.key_space;
+  sts.config = args.config;
+  if (!args.apps.empty())
+    sts.config.app = *std::begin(args.apps);
+  std::unique_ptr<Policy> policy = args.policy->create(args, sts);
+  if (args.profile)
+    policy->enable_profiling();
+  return policy;
 }
 
+
+/// Creates the Policy of \a args with everything it prints going to \a out.
+std::unique_ptr<Policy> create_Policy(Args& args, std::ostream& out)
+{
+  // Some policies print while they are constructed. std::cout is shared by
+  // every thread, so one at a time may borrow it.
+  static std::mutex stdout_mutex{};
+  std::lock_guard<std::mutex> lock{stdout_mutex};
+  std::streambuf* stdout_buf = std::cout.rdbuf(out.rdbuf());
+  std::unique_ptr<Policy> policy = create_Policy(args);
+  std::cout.rdbuf(stdout_buf);
+  policy->set_output(&out);
+  return policy;
+}
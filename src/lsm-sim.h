@@ -0,0 +1,145 @@
+#ifndef LSM_SIM_H
+#define LSM_SIM_H
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "lsc_multi.h"
+#include "policy.h"
+#include "policy_config.h"
+#include "trace_reader.h"
+
+// The simulation driver (lsm-sim.cpp): options of a run, the policies they
+// can select and running them over a trace. bin/lsm-sim is its command line
+// (main.cpp); bin/lsm-bench builds policies through it as well.
+
+/// Most Requests simulate() hands to Policy::process_batch() at once; enough
+/// for prefetching to run well ahead, few enough to stay in the L1 cache.
+const size_t policy_batch_size = 256;
+
+struct policy_entry;
+
+struct Args {
+  
+  std::unordered_map<uint32_t, uint32_t> app_steal_sizes{};
+  std::set<uint32_t> apps{};
+
+  bool          all_apps             = true;             //< run all by default 
+  bool          roundup              = false;            //< no rounding default
+  float         lsm_util             = 1.0;              //< default util factor
+  std::string   trace                = "data/m.cap.out"; //< default filepath
+  double        hit_start_time       = 86400;            //< default warmup time
+  size_t        global_mem           = 0;
+  bool          verbose              = false;
+  double        gfactor              = 1.25;             //< Slab growth factor.
+  bool          memcachier_classes   = false;
+  size_t        partslab_partitions  = 2;
+  double        sample_rate          = 1;                //< SHARDS rate (-U)
+  size_t        sample_keys          = 0;                //< SHARDS bound (-z)
+  bool          use_aet              = false;            //< AET model (-q)
+  size_t        segment_size         = 1 * 1024 * 1024;
+  size_t        block_size           = 1 * 1024 * 1024;
+  size_t        num_dsections        = 4;
+  size_t        min_mem_pct          = 75;
+  const size_t  default_steal_size   = 65536;
+  double        priv_mem_percentage  = 0.25;
+  bool          use_percentage       = false;            // specify priv mem %
+  size_t        flash_size           = 0;
+  size_t        num_sections         = 0;
+  bool          debug                = false;
+  size_t        max_overall_request_size      = 1048576; // key + value
+
+  // Only parse this many Requests from the CSV file before breaking.
+  // Helpful for limiting runtime when playing around.
+  int           Request_limit        = 0;
+
+  // Threads parsing a CSV trace ahead of the simulation; 0 parses inline.
+  size_t        parser_threads       = 0;
+
+  // Only requests with begin_time <= time < end_time are simulated.
+  double        begin_time           = std::numeric_limits<double>::lowest();
+  double        end_time             = std::numeric_limits<double>::max();
+
+  // Kids are dense below this (see csv2bin -d); 0 if they aren't.
+  size_t        key_space            = 0;
+
+  // File listing configurations to simulate together (see -X).
+  std::string   config_list          = "";
+
+  // Sweep spec to run (see -x) and the threads running its jobs, or those
+  // of shadowlru_parallel; 0 runs one per core.
+  std::string   sweep_spec           = "";
+  size_t        sweep_threads        = 0;
+
+  // Checkpoint to write once warmup ends (-o) and to start from (-i).
+  std::string   checkpoint_out       = "";
+  std::string   checkpoint_in        = "";
+
+  // File of tunables to fork the run into once warmup ends (see -V).
+  std::string   variant_list         = "";
+
+  // Where to write per-window metrics (-Q), and the windows (-I): trace
+  // seconds, or Requests if metrics_requests isn't 0.
+  std::string   metrics_path         = "";
+  double        metrics_interval     = 3600;
+  uint64_t      metrics_requests     = 0;
+
+  // Profile process_request and its phases (-y; see profile.h).
+  bool          profile              = false;
+
+  /// Amount of dram memory allocated for ripq_shield active_blocks.
+  size_t        dram_size            = 0;
+
+  /// Parameters of the flash, multi-queue, clock and multi policies (-D -F
+  /// -K -L -k -H -C -A -T); every Policy gets a copy.
+  policy_config config{};
+  double        threshold            = 0.7;
+  size_t        cleaning_width       = 100;
+
+  std::string           app_str      = "";              //< for logging apps
+  const policy_entry*   policy       = nullptr;          //< set by -p
+  lsc_multi::Subpolicy  Subpolicy    = lsc_multi::Subpolicy(0);
+  std::string           app_steal_sizes_str = "";
+
+  // The number of partitions in which to globally partition the cache.
+  uint16_t num_partitions = 1;
+};
+
+/// A Policy -p can select.
+struct policy_entry {
+  const char* name;
+  bool        flash;            //< -s is the DRAM plus the flash size (-D -F)
+  bool        single_instance;  //< keeps state in globals; one at a time
+  bool        curves;           //< log_curves once the trace is simulated
+  bool        hourly_dumps;     //< dump_stats every hour with -v
+  // Creates the Policy; \a sts already holds the common parameters.
+  std::unique_ptr<Policy> (*create)(Args& args, stats& sts);
+};
+
+/// Every Policy -p can select, by name.
+extern const std::vector<policy_entry> policy_registry;
+
+/// @return the registry entry named \a name; nullptr if there is none.
+const policy_entry* find_policy(const std::string& name);
+
+std::unique_ptr<Policy> create_Policy(Args& args);
+std::unique_ptr<Policy> create_Policy(Args& args, std::ostream& out);
+void calculate_global_memory(Args& args);
+void parse_stdin(Args& args, int argc, char** argv);
+void parse_tokens(Args& args, std::vector<std::string> tokens);
+void list_input_parameters(const Args& args);
+std::unique_ptr<trace_reader> open_reader(const Args& args,
+                                          const std::set<uint32_t>& apps);
+void simulate_trace(Args& args, Policy& policy, trace_reader& reader,
+                    std::ostream& out);
+int run_configurations(const Args& base, const std::string& list);
+int run_sweep(const Args& base, const std::string& spec);
+
+#endif
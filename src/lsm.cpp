@@ -8,11 +8,9 @@
 
 // 日志结构缓存策略
 lsm::lsm(stats stat)
-    : Policy{stat}, cleaner{cleaning_policy::OLDEST_ITEM}, map{}, head{nullptr}, segments{}, free_segments{}
+    : Policy{stat}, cleaner{cleaning_policy::OLDEST_ITEM}, map{stat.key_space}, head{nullptr}, segments{}, free_segments{},
+      rng{0}
 {
-
-  srand(0);
-
   if (stat.global_mem % stat.segment_size != 0)
   {
     std::cerr << "WARNING: global_mem not a multiple of segment_size" << std::endl;
@@ -41,26 +39,30 @@ size_t lsm::process_request(const Request *r, bool warmup)
     ++stat.accesses;
 
   // 哈希表查找请求对应的lru链表节点指针
+  phase_timer lookup{profile.get(), phase::lookup};
   auto it = map.find(r->kid);
+  lookup.stop();
   // 找到了
-  if (it != map.end())
+  if (it)
   {
     if (!warmup)
       ++stat.hits;
 
-    auto list_it = it->second;
     // 当前请求所属的段
-    segment *old_segment = list_it->seg;
-    int32_t old_Request_size = list_it->req.size();
+    segment *old_segment = &segments[it->seg];
+    int32_t old_Request_size = old_segment->entries[it->slot].size();
     // 如果请求大小没有改变，将请求移到原段lru链表头部，然后直接返回
     if (old_Request_size == r->size())
     {
       // Promote this item to the front.
-      old_segment->queue.erase(list_it);
-      old_segment->queue.emplace_front(old_segment, *r);
-      map[r->kid] = old_segment->queue.begin();
+      phase_timer promote{profile.get(), phase::promote};
+      old_segment->kill(it->slot);
+      it->slot = old_segment->append(cache_entry{*r});
+      promote.stop();
 
       ++old_segment->access_count;
+      if (old_segment->entries.size() >= 2 * old_segment->live_count + 64)
+        compact(old_segment);
 
       return 1;
     }
@@ -82,14 +84,28 @@ size_t lsm::process_request(const Request *r, bool warmup)
 
   // 若当前开放段(头部段)的空间不够，选一个新空闲段为开放段
   if (head->filled_bytes + r->size() > stat.segment_size)
+  {
+    phase_timer evict{profile.get(), phase::evict};
     rollover(r->time);
+  }
   // assert(head->filled_bytes + r->size() <= stat.segment_size);
 
   // Add the new Request.
   // 将请求插入到当前开放段的lru链表头部
-  head->queue.emplace_front(head, *r);
+  const location added{index_of(head), head->append(cache_entry{*r})};
   // 更新请求到lru链表节点的映射
-  map[r->kid] = head->queue.begin();
+  // A resized item's old version stays where it is, dead. Cleaning may
+  // have moved or evicted it since the lookup above.
+  location *old = it ? map.find(r->kid) : nullptr;
+  if (old)
+  {
+    segments[old->seg].kill(old->slot);
+    *old = added;
+  }
+  else
+  {
+    map[r->kid] = added;
+  }
   // 更新开放段当前已使用的空间大小
   head->filled_bytes += r->size();
 
@@ -98,6 +114,20 @@ size_t lsm::process_request(const Request *r, bool warmup)
   return PROC_MISS;
 }
 
+// Prefetches the map slots and queue entries of upcoming requests (see
+// prefetch.h).
+void lsm::process_batch(const Request *begin, size_t n, bool warmup)
+{
+  pipeline_batch(n,
+    [&](size_t i) { map.prefetch(begin[i].kid); },
+    [&](size_t i) {
+      auto it = map.find(begin[i].kid);
+      if (it)
+        prefetch(&segments[it->seg].entries[it->slot]);
+    },
+    [&](size_t i) { process_request(&begin[i], warmup); });
+}
+
 size_t lsm::get_bytes_cached() const
 {
   return 0;
@@ -105,6 +135,36 @@ size_t lsm::get_bytes_cached() const
 
 void lsm::dump_util(const std::string &filename) {}
 
+void lsm::compact(segment *seg)
+{
+  uint32_t to = 0;
+  for (uint32_t from = 0; from < seg->entries.size(); ++from)
+  {
+    if (!seg->is_live(from))
+      continue;
+    seg->entries[to] = seg->entries[from];
+    map.find(seg->entries[to].kid)->slot = to;
+    ++to;
+  }
+  assert(to == seg->live_count);
+  seg->entries.erase(seg->entries.begin() + to, seg->entries.end());
+  seg->live.assign((to + 63) / 64, ~uint64_t(0));
+  if (to % 64)
+    seg->live.back() = (uint64_t(1) << (to % 64)) - 1;
+}
+
+void lsm::place(segment *dst)
+{
+  std::reverse(dst->entries.begin(), dst->entries.end());
+  const uint32_t index = index_of(dst);
+  for (uint32_t slot = 0; slot < dst->entries.size(); ++slot)
+  {
+    location *loc = map.find(dst->entries[slot].kid);
+    assert(loc);
+    *loc = location{index, slot};
+  }
+}
+
 void lsm::rollover(double timestamp)
 {
   // 标记当前开放段是否更新成功
@@ -112,16 +172,14 @@ void lsm::rollover(double timestamp)
   for (auto &segment : segments)
   {
     // 已经被实例化了，跳过
-    if (segment)
+    if (segment.in_use)
       continue;
 
-    // 使用emplace方法实例化新段
-    // 这是C++标准库容器的一个方法，用于就地构造元素，避免不必要的拷贝或移动操作
-    segment.emplace();
+    segment.in_use = true;
     // 空闲段-1
     --free_segments;
     // 将head指针指向新实例化的段
-    head = &segment.value();
+    head = &segment;
     // 段的创建时间戳
     head->low_timestamp = timestamp;
     rolled = true;
@@ -136,12 +194,80 @@ void lsm::rollover(double timestamp)
     clean();
 }
 
+// 保存/恢复检查点：按段序号保存每个段及其lru链表，恢复时重建map
+// 每个请求后保存其是否为map中的有效版本；只保存有效版本，顺序为从新到旧
+void lsm::save(checkpoint_writer &w) const
+{
+  stat.save(w);
+  w.put(uint64_t(segments.size()));
+  w.put(free_segments);
+  w.put(rng);
+  for (const segment &segment : segments)
+  {
+    w.put(segment.in_use);
+    if (!segment.in_use)
+      continue;
+    w.put(&segment == head);
+    w.put(segment.filled_bytes);
+    w.put(segment.access_count);
+    w.put(segment.low_timestamp);
+    w.put(uint64_t(segment.live_count));
+    for (uint32_t slot = uint32_t(segment.entries.size()); slot-- > 0;)
+    {
+      if (!segment.is_live(slot))
+        continue;
+      w.put(segment.entries[slot]);
+      w.put(true);
+    }
+  }
+}
+
+void lsm::restore(checkpoint_reader &r)
+{
+  stat.restore(r);
+  r.expect(uint64_t(segments.size()), "number of segments");
+  free_segments = r.get<size_t>();
+  rng = r.get<glibc_rand>();
+  map = hash_map{stat.key_space};
+  head = nullptr;
+  for (segment &seg : segments)
+  {
+    seg.reset();
+    if (!r.get<bool>())
+      continue;
+    seg.in_use = true;
+    if (r.get<bool>())
+      head = &seg;
+    seg.filled_bytes = r.get<size_t>();
+    seg.access_count = r.get<uint64_t>();
+    seg.low_timestamp = r.get<double>();
+    // Items come newest first.
+    const uint64_t n = r.get<uint64_t>();
+    std::vector<cache_entry> entries{};
+    std::vector<bool> live{};
+    for (uint64_t i = 0; i < n; ++i)
+    {
+      entries.push_back(r.get<cache_entry>());
+      live.push_back(r.get<bool>());
+    }
+    for (uint64_t i = n; i-- > 0;)
+    {
+      const uint32_t slot = seg.append(entries[i]);
+      if (live[i])
+        map[entries[i].kid] = location{index_of(&seg), slot};
+      else
+        seg.kill(slot);
+    }
+  }
+  assert(head);
+}
+
 // 输出段的实例化情况
 void lsm::dump_usage()
 {
   std::cerr << "[";
   for (auto &segment : segments)
-    std::cerr << (bool(segment) ? "X" : "_");
+    std::cerr << (segment.in_use ? "X" : "_");
   std::cerr << "]" << std::endl;
 }
 
@@ -177,25 +303,25 @@ auto lsm::choose_cleaning_sources_random() -> std::vector<segment *>
     for (size_t j = 0; j < 1000000; ++j)
     {
       // 随机选取一个段
-      int r = rand() % segments.size();
+      int r = rng.rand() % segments.size();
       auto &segment = segments.at(r);
 
       // Don't pick free segments.
-      if (!segment)
+      if (!segment.in_use)
         continue;
 
       // Don't pick the head segment.
-      if (&segment.value() == head)
+      if (&segment == head)
         continue;
 
       // Don't pick any segment we've already picked!
       bool already_picked = false;
       for (auto &already_in : srcs)
-        already_picked |= (already_in == &segment.value());
+        already_picked |= (already_in == &segment);
       if (already_picked)
         continue;
 
-      srcs.emplace_back(&segment.value());
+      srcs.emplace_back(&segment);
       break;
     }
     // Check for enough in use segments during cleaning; if not then a bug!
@@ -213,14 +339,14 @@ auto lsm::choose_cleaning_sources_oldest_item() -> std::vector<segment *>
   for (auto &segment : segments)
   {
     // Don't pick free segments.
-    if (!segment)
+    if (!segment.in_use)
       continue;
 
     // Don't pick the head segment.
-    if (&segment.value() == head)
+    if (&segment == head)
       continue;
 
-    srcs.emplace_back(&segment.value());
+    srcs.emplace_back(&segment);
   }
 
   // 按创建时间从旧到新排序
@@ -245,9 +371,9 @@ auto lsm::choose_cleaning_sources_oldest_item() -> std::vector<segment *>
   for (auto &segment : segments)
   {
     // Don't pick free segments.
-    if (!segment)
+    if (!segment.in_use)
       continue;
-    segment->access_count = 0;
+    segment.access_count = 0;
   }
 
   // Check for enough in use segments during cleaning; if not then a bug!
@@ -263,14 +389,14 @@ auto lsm::choose_cleaning_sources_rumble() -> std::vector<segment *>
   for (auto &segment : segments)
   {
     // Don't pick free segments.
-    if (!segment)
+    if (!segment.in_use)
       continue;
 
     // Don't pick the head segment.
-    if (&segment.value() == head)
+    if (&segment == head)
       continue;
 
-    srcs.emplace_back(&segment.value());
+    srcs.emplace_back(&segment);
   }
 
   // 按段的访问次数从小到大排序
@@ -292,9 +418,9 @@ auto lsm::choose_cleaning_sources_rumble() -> std::vector<segment *>
   for (auto &segment : segments)
   {
     // Don't pick free segments.
-    if (!segment)
+    if (!segment.in_use)
       continue;
-    segment->access_count = 0;
+    segment.access_count = 0;
   }
 
   // Check for enough in use segments during cleaning; if not then a bug!
@@ -314,14 +440,14 @@ auto lsm::choose_cleaning_sources_round_robin() -> std::vector<segment *>
   {
     auto &segment = segments.at(next);
 
-    if (!segment)
+    if (!segment.in_use)
       continue;
 
     // Don't pick the head segment.
-    if (&segment.value() == head)
+    if (&segment == head)
       continue;
 
-    srcs.emplace_back(&segment.value());
+    srcs.emplace_back(&segment);
 
     ++next;
     next %= segments.size();
@@ -337,14 +463,14 @@ auto lsm::choose_cleaning_destination() -> segment *
   {
     // Don't pick a used segment. (This also guarantees we don't pick
     // the same free segment more than once.)
-    if (segment)
+    if (segment.in_use)
       continue;
 
-    // Construct, clean empty segment here.
-    segment.emplace();
+    // Freed segments are reset, so this one is clean and empty.
+    segment.in_use = true;
     --free_segments;
 
-    return &segment.value();
+    return &segment;
   }
 
   assert(false);
@@ -356,11 +482,11 @@ void lsm::dump_cleaning_plan(std::vector<segment *> srcs,
   std::cerr << "Cleaning Plan [";
   for (auto &segment : segments)
   {
-    if (segment)
+    if (segment.in_use)
     {
       for (auto &src : srcs)
       {
-        if (src == &segment.value())
+        if (src == &segment)
         {
           std::cerr << "S";
           goto next;
@@ -368,7 +494,7 @@ void lsm::dump_cleaning_plan(std::vector<segment *> srcs,
       }
       for (auto &dst : dsts)
       {
-        if (dst == &segment.value())
+        if (dst == &segment)
         {
           std::cerr << "D";
           goto next;
@@ -386,6 +512,8 @@ void lsm::dump_cleaning_plan(std::vector<segment *> srcs,
 
 void lsm::clean()
 {
+  phase_timer timer{profile.get(), phase::clean};
+
   /*
   const char* spinner = "|/-\\";
   static uint8_t last = 0;
@@ -395,13 +523,14 @@ void lsm::clean()
   // 根据GC策略选取cleaning_width个GC的受害者段
   std::vector<segment *> src_segments = choose_cleaning_sources();
 
-  // One iterator for each segment to be cleaned. We use these to keep a
-  // finger into each queue and merge them into a sorted order in the
-  // destination segments.
-  // 获取每个受害者段的lru链表头部迭代器
-  std::vector<lru_queue::iterator> its{};
+  // One position for each segment to be cleaned: how many of its entries
+  // are left, taken from the back of its array, newest first. We use these
+  // to keep a finger into each segment and merge them into a sorted order
+  // in the destination segments.
+  // 每个受害者段中剩余的请求数，从数组尾部(最新的请求)开始
+  std::vector<uint32_t> its{};
   for (auto *segment : src_segments)
-    its.emplace_back(segment->queue.begin());
+    its.emplace_back(uint32_t(segment->entries.size()));
 
   size_t dst_index = 0;
   // 从空闲段中选取一个段容纳GC的数据
@@ -410,33 +539,38 @@ void lsm::clean()
   std::vector<segment *> dst_segments{};
   dst_segments.push_back(dst);
 
+  // The segments with entries left, in a heap with the one whose next
+  // entry is the newest on top; of equal timestamps the first segment's
+  // goes first.
+  // 选取每个GC段当前指向的请求中 请求时间最晚的那个请求
+  auto front = [&](size_t i) -> const cache_entry & {
+    return src_segments[i]->entries[its[i] - 1];
+  };
+  auto older = [&](size_t a, size_t b) {
+    const uint32_t ta = front(a).timestamp;
+    const uint32_t tb = front(b).timestamp;
+    return ta < tb || (ta == tb && a > b);
+  };
+  std::vector<size_t> fronts{};
+  for (size_t i = 0; i < src_segments.size(); ++i)
+    if (its[i] > 0)
+      fronts.push_back(i);
+  std::make_heap(fronts.begin(), fronts.end(), older);
+  // Moves segment it_to_incr's finger to its next entry.
+  auto advance = [&](size_t it_to_incr) {
+    std::pop_heap(fronts.begin(), fronts.end(), older);
+    if (--its[it_to_incr] > 0)
+      std::push_heap(fronts.begin(), fronts.end(), older);
+    else
+      fronts.pop_back();
+  };
+
   while (true)
   {
-    item *item = nullptr;
-    size_t it_to_incr = 0;
-    // 遍历要GC的段
-    for (size_t i = 0; i < src_segments.size(); ++i)
-    {
-      // 获取当前段的迭代器
-      auto &it = its.at(i);
-      // 若当前段的迭代器已经遍历完，跳过
-      if (it == src_segments.at(i)->queue.end())
-        continue;
-      // 选取每个GC段的迭代器 当前指向的请求中 请求时间最晚的那个请求
-      if (!item || it->req.time > item->req.time)
-      {
-        item = &*it;
-        it_to_incr = i;
-      }
-    }
-
     // All done with all its.
     // 已经没有需要迁移的数据了
-    if (!item)
+    if (fronts.empty())
     {
-      for (size_t i = 0; i < src_segments.size(); ++i)
-        assert(its.at(i) == src_segments.at(i)->queue.end());
-
       // 最后一个段中的碎片空间大小
       stat.cleaned_ext_frag_bytes += (stat.segment_size - dst->filled_bytes);
       // GC之后迁移数据所生成的新段数
@@ -444,31 +578,21 @@ void lsm::clean()
 
       break;
     }
+    const size_t it_to_incr = fronts.front();
+    const cache_entry *item = &front(it_to_incr);
 
     // 迁移当前请求
-    // Check to see if this version is still needed.
-    auto it = map.find(item->req.kid);
-    // If not in the hash table, just drop it.
-    if (it == map.end())
-    { // 若当前请求不在哈希表中(被删除？)，直接跳过
-      // 当前段的迭代器指向下一个请求
-      ++its.at(it_to_incr);
-      continue;
-    }
-    // If hash table pointer refers to a different version, drop this one.
-    if (&*it->second != item)
-    { // 若当前请求在哈希表中查询到的指针指向的请求版本不是当前请求(被更新，无效化了)，跳过
-      // 当前段的迭代器指向下一个请求
-      ++its.at(it_to_incr);
+    // Check to see if this version is still needed: dead slots were
+    // promoted or replaced by a newer version, just drop them.
+    if (!src_segments[it_to_incr]->is_live(its[it_to_incr] - 1))
+    { // 若当前请求已无效，直接跳过
+      advance(it_to_incr);
       continue;
     }
 
-    // 当前请求所属的段需要和当前GC的段相同(不能是被更新写入到另外段的无效请求)
-    assert(src_segments.at(it_to_incr) == item->seg);
-
     // Check to see if there is room for the item in the dst.
     // 若当前容纳迁移数据的段空间不足，继续选取新的空闲段
-    if (dst->filled_bytes + item->req.size() > stat.segment_size)
+    if (dst->filled_bytes + item->size() > stat.segment_size)
     {
       // 记录当前段的碎片空间大小
       stat.cleaned_ext_frag_bytes += (stat.segment_size - dst->filled_bytes);
@@ -488,101 +612,76 @@ void lsm::clean()
       // 放入容纳迁移数据的段列表
       dst_segments.push_back(dst);
     }
-    assert(dst->filled_bytes + item->req.size() <= stat.segment_size);
-    // 当前段的迭代器指向下一个请求
-    ++its.at(it_to_incr);
-
-    // Relocate *to the back* to retain timestamp sort order.
-    // 将当前请求迁移到容纳迁移数据的段的lru链表尾部
-    dst->queue.emplace_back(dst, item->req);
-    // 更新哈希表中请求到lru链表节点的映射
-    map[item->req.kid] = (--dst->queue.end());
-    dst->filled_bytes += item->req.size();
+    assert(dst->filled_bytes + item->size() <= stat.segment_size);
+    // Relocate newest first; place() below turns dst around to retain
+    // timestamp sort order, and points the map at it.
+    // 将当前请求迁移到容纳迁移数据的段
+    dst->append(*item);
+    dst->filled_bytes += item->size();
     // 段的创建时间，以GC迁移的最后一个请求的时间戳为准
-    dst->low_timestamp = item->req.time;
+    dst->low_timestamp = item->get_time();
+    // 当前段的指针指向下一个请求
+    advance(it_to_incr);
   }
 
   // Clear items that are going to get thrown on the floor from the hashtable.
   // 已经迁移了cleaning_width-1个段的数据，剩余数据驱逐
   for (size_t i = 0; i < src_segments.size(); ++i)
-  { // 遍历每个GC段，递增其迭代器直至遍历完所有请求
-    auto &it = its.at(i);
-    while (it != src_segments.at(i)->queue.end())
+  { // 遍历每个GC段的剩余请求，驱逐其中有效的请求
+    const segment *src = src_segments.at(i);
+    for (uint32_t slot = its.at(i); slot-- > 0;)
     {
-      // Need to do a double check here. The item we are evicting may
-      // still exist in the hash table but it may point to a newer version
-      // of this object. In that case, skip the erase from the hash table.
-      auto hash_it = map.find(it->req.kid);
-      if (hash_it != map.end())
-      {
-        item *from_list = &*it;              // 当前段中的请求指针
-        item *from_hash = &*hash_it->second; // 当前请求在哈希表中映射到的请求指针
-
-        // 若两个指针相同，说明当前段中当前请求有效，进行驱逐
-        if (from_list == from_hash)
-        {
-          map.erase(it->req.kid);
-          ++stat.evicted_items;
-          stat.evicted_bytes += from_list->req.size();
-        }
-      }
-
-      ++it;
+      if (!src->is_live(slot))
+        continue;
+      map.erase(src->entries[slot].kid);
+      ++stat.evicted_items;
+      stat.evicted_bytes += src->entries[slot].size();
     }
   }
 
+  for (segment *dst : dst_segments)
+    place(dst);
+
   const bool debug = false;
   if (debug)
   {
     // Sanity check - none of the items left in the hash table should point
     // into a src_segment.
     // 遍历哈希表中所有项，检查是否还存在指向被GC段的请求
-    for (auto &entry : map)
-    {
-      item &item = *entry.second;
+    map.for_each([&](uint32_t, location &entry) {
       for (segment *src : src_segments)
-        assert(item.seg != src);
-    }
+        assert(entry.seg != index_of(src));
+    });
 
     // dump_cleaning_plan(src_segments, dst_segments);
   }
 
   // Reset each src segment as free for reuse.
   // 重置每个GC段，使其成为空闲段
-  for (auto *src : src_segments) // 遍历每个GC段指针
+  for (auto *src : src_segments)
   {
-    for (auto &segment : segments) // 遍历段容器中的每个位置
-    {
-      if (src == &*segment)
-      {
-        segment = nullopt;
-        ++free_segments;
-      }
-    }
+    src->reset();
+    ++free_segments;
   }
 
   if (debug)
   {
-    // Sanity check - none of the segments should contain more data than their
-    // rated capacity.
-    size_t stored_in_whole_cache = 0; // 所有段中存储的请求总大小(有效+无效)
-    // 遍历每个段，检查其中容纳的请求总大小是否超过了段的容量
+    // Sanity check - none of the segments should contain more live data
+    // than they were filled with.
+    size_t stored_in_whole_cache = 0; // 所有段中存储的请求总大小
+    // 遍历每个段，检查其中有效请求的总大小是否超过了段的容量
     for (auto &segment : segments)
     {
-      if (!segment)
+      if (!segment.in_use)
         continue;
 
       size_t bytes = 0;
-      for (const auto &item : segment->queue)
-      {
-        // 这里没有查哈希表，因此包括无效的请求
-        // 无效+有效的请求总大小不应超过段的容量
-        assert(item.seg == &segment.value());
-        bytes += item.req.size();
-      }
+      for (uint32_t slot = 0; slot < segment.entries.size(); ++slot)
+        if (segment.is_live(slot))
+          bytes += segment.entries[slot].size();
       assert(bytes <= stat.segment_size);
-      assert(bytes == segment->filled_bytes);
-      stored_in_whole_cache += bytes;
+      assert(bytes <= segment.filled_bytes);
+      stored_in_whole_cache += segment.filled_bytes;
     }
 
     // Sanity check - the sum of all of the Requests active in the hash table
@@ -592,24 +691,24 @@ void lsm::clean()
     size_t reachable_from_map = 0; // 活跃请求总大小
     std::unordered_set<int32_t> seen{};
     // 遍历哈希表中映射到的活跃请求
-    for (auto &entry : map)
-    {
-      item &item = *entry.second;
+    map.for_each([&](uint32_t kid, location &entry) {
+      const cache_entry &item = segments[entry.seg].entries[entry.slot];
+      assert(segments[entry.seg].is_live(entry.slot));
       // HT key had better only point to objects with the same kid.
       // 不应出现错误映射(id->请求 不对应)
-      if (entry.first != item.req.kid)
+      if (kid != item.kid)
       {
         std::cerr << "Mismatch! map entry "
-                  << entry.first << " != " << item.req.kid << std::endl;
-        item.req.dump();
+                  << kid << " != " << item.kid << std::endl;
+        item.dump();
       }
-      assert(entry.first == item.req.kid);
+      assert(kid == item.kid);
       // Better not see the same kid twice among the objects in the HT.
       // 哈希表中不应出现重复的请求映射
-      assert(seen.find(item.req.kid) == seen.end());
-      reachable_from_map += item.req.size();
-      seen.insert(item.req.kid);
-    }
+      assert(seen.find(item.kid) == seen.end());
+      reachable_from_map += item.size();
+      seen.insert(item.kid);
+    });
     // 活跃请求总大小不应超过存储的所有请求总大小
     if (reachable_from_map > stored_in_whole_cache)
     {
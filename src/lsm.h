@@ -1,10 +1,12 @@
-#include <experimental/optional>
-#include <list>
+#include <cassert>
 #include <unordered_map>
 #include <vector>
 
 #include "policy.h"
 #include "common.h"
+#include "cache_entry.h"
+#include "key_map.h"
+#include "glibc_rand.h"
 
 #ifndef LSM_H
 #define LSM_H
@@ -14,32 +16,71 @@
 class lsm : public Policy
 {
 private:
-  class segment;
-
-  class item
+  // Where an item lives: the index of its segment and its slot there.
+  struct location
   {
-  public:
-    item(segment *seg, const Request &req)
-        : seg{seg}, req{req}
-    {
-    }
-
-    segment *seg;
-    Request req;
+    uint32_t seg;
+    uint32_t slot;
   };
 
-  typedef std::list<item> lru_queue;
-  typedef std::unordered_map<uint32_t, lru_queue::iterator> hash_map;
+  typedef key_map<location> hash_map;
 
+  // A segment keeps its items in an append-only array, oldest first, so
+  // appending is a pointer bump and cleaning a sequential scan. Written
+  // items never move: a promoted item is appended again, and the slot it
+  // leaves is cleared in live, a bitmap with a bit per slot. An item is live
+  // iff the hash map points at its slot. Arrays keep their memory when a
+  // segment is freed, for its next use.
   class segment
   {
   public:
     segment()
-        : queue{}, filled_bytes{}, access_count{}, low_timestamp{}
+        : entries{}, live{}, live_count{}, in_use{}, filled_bytes{},
+          access_count{}, low_timestamp{}
+    {
+    }
+
+    // @return - the slot \a entry was appended at, which is live.
+    uint32_t append(const cache_entry &entry)
+    {
+      const uint32_t slot = uint32_t(entries.size());
+      entries.push_back(entry);
+      if (slot % 64 == 0)
+        live.push_back(0);
+      live[slot / 64] |= uint64_t(1) << (slot % 64);
+      ++live_count;
+      return slot;
+    }
+
+    bool is_live(uint32_t slot) const
     {
+      return (live[slot / 64] >> (slot % 64)) & 1;
     }
 
-    lru_queue queue;
+    void kill(uint32_t slot)
+    {
+      assert(is_live(slot));
+      live[slot / 64] &= ~(uint64_t(1) << (slot % 64));
+      --live_count;
+    }
+
+    // Frees the segment.
+    void reset()
+    {
+      entries.clear();
+      live.clear();
+      live_count = 0;
+      in_use = false;
+      filled_bytes = 0;
+      access_count = 0;
+      low_timestamp = 0;
+    }
+
+    counted_vector<cache_entry, mem_tag::segments> entries;
+    counted_vector<uint64_t, mem_tag::segments> live;
+    size_t live_count;
+
+    bool in_use;
     size_t filled_bytes;
 
     uint64_t access_count;
@@ -59,6 +100,7 @@ public:
   ~lsm();
 
   size_t process_request(const Request *r, bool warmup);
+  void process_batch(const Request *begin, size_t n, bool warmup);
   size_t get_bytes_cached() const;
 
   double get_running_hit_rate();
@@ -67,6 +109,10 @@ public:
 
   void dump_util(const std::string &filename);
 
+  bool can_checkpoint() const { return true; }
+  void save(checkpoint_writer &w) const;
+  void restore(checkpoint_reader &r);
+
 private:
   void rollover(double timestamp);
   void clean();
@@ -79,6 +125,17 @@ private:
   std::vector<segment *> choose_cleaning_sources_oldest_item();
   segment *choose_cleaning_destination();
 
+  uint32_t index_of(const segment *seg) const
+  {
+    return uint32_t(seg - segments.data());
+  }
+
+  // Drops the dead slots of \a seg once they outnumber its live ones.
+  void compact(segment *seg);
+  // Points the map at the items of \a dst, a cleaning destination that was
+  // filled newest first, after turning it around.
+  void place(segment *dst);
+
   void dump_cleaning_plan(std::vector<segment *> srcs,
                           std::vector<segment *> dsts);
 
@@ -87,9 +144,12 @@ private:
   hash_map map;
 
   segment *head;
-  std::vector<optional<segment>> segments;
+  std::vector<segment> segments;
   size_t free_segments;
 
+  // Picks the segments the random cleaner cleans.
+  glibc_rand rng;
+
   lsm(const lsm &) = delete;
   lsm &operator=(const lsm &) = delete;
   lsm(lsm &&) = delete;
@@ -0,0 +1,61 @@
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <set>
+
+#include "lsm-sim.h"
+
+using namespace std::chrono;
+typedef high_resolution_clock hrc;
+
+int main(int argc, char *argv[])
+{
+  Args args;
+  calculate_global_memory(args);
+  parse_stdin(args, argc, argv);
+
+  if (!args.config_list.empty() && !args.sweep_spec.empty())
+  {
+    std::cerr << "-X and -x can't be combined" << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  if (!args.config_list.empty() &&
+      !(args.checkpoint_out.empty() && args.checkpoint_in.empty()))
+  {
+    std::cerr << "-X can't be combined with -o or -i" << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  if (!args.variant_list.empty() &&
+      !(args.config_list.empty() && args.sweep_spec.empty()))
+  {
+    std::cerr << "-V can't be combined with -X or -x" << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  if (!args.sweep_spec.empty() && !args.checkpoint_out.empty())
+  {
+    std::cerr << "-x can't be combined with -o" << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  if (!args.config_list.empty())
+    return run_configurations(args, args.config_list);
+  if (!args.sweep_spec.empty())
+    return run_sweep(args, args.sweep_spec);
+
+  std::unique_ptr<trace_reader> reader =
+    open_reader(args, args.all_apps ? std::set<uint32_t>{} : args.apps);
+  args.key_space = reader->get_key_space();
+
+  std::unique_ptr<Policy> Policy = create_Policy(args);
+  list_input_parameters(args);
+
+  auto start = hrc::now();
+  simulate_trace(args, *Policy, *reader, std::cout);
+  auto stop = hrc::now();
+
+  double seconds = duration_cast<milliseconds>(stop - start).count() / 1000.;
+  (void)seconds;
+  // std::cerr << "total execution time: " << seconds << std::endl;
+
+  return 0;
+}
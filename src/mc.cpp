@@ -65,6 +65,7 @@ typedef struct
 
 static slabclass_t slabclass[MAX_NUMBER_OF_SLAB_CLASSES];
 static int power_largest;
+static double slabclass_factor; // factor slabclass was built for; 0 if none
 
 /**
  * Determines the chunk sizes and initializes the slab class descriptors
@@ -76,6 +77,16 @@ static int power_largest;
  */
 uint16_t slabs_init(const double factor)
 {
+    // Sweeps construct slab policies while others are running; rebuilding
+    // the same table under them would briefly clear it.
+    if (factor == slabclass_factor)
+    {
+        for (int i = POWER_SMALLEST; i < power_largest; ++i)
+            std::cout << "slab class " << i << " size " << slabclass[i].size << std::endl;
+        std::cout << "slab class " << power_largest << " size " << item_size_max << std::endl;
+        return power_largest;
+    }
+
     int i = POWER_SMALLEST - 1;
 
     // stutsman: original memcached code boost class size by
@@ -105,6 +116,7 @@ uint16_t slabs_init(const double factor)
 
     std::cout << "slab class " << i << " size " << item_size_max << std::endl;
 
+    slabclass_factor = factor;
     return power_largest;
 }
 
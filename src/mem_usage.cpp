@@ -0,0 +1,74 @@
+#include <iomanip>
+#include <mutex>
+
+#include "mem_usage.h"
+
+namespace {
+
+const char *mem_tag_names[MEM_TAGS] = {"hash_index", "queue", "segments",
+                                       "flash_blocks", "distances"};
+
+// The counters of every thread that counted; they outlive their threads,
+// since what a thread allocated may live on after it.
+std::mutex threads_mutex{};
+std::vector<std::unique_ptr<mem_counters>> threads{};
+
+struct mem_total
+{
+  int64_t live;
+  int64_t peak;
+};
+
+mem_total total(size_t t)
+{
+  std::lock_guard<std::mutex> lock{threads_mutex};
+  mem_total sum{0, 0};
+  for (const std::unique_ptr<mem_counters> &c : threads)
+  {
+    sum.live += c->live[t].load(std::memory_order_relaxed);
+    sum.peak += c->peak[t].load(std::memory_order_relaxed);
+  }
+  if (sum.live < 0)
+    sum.live = 0;
+  return sum;
+}
+
+} // namespace
+
+mem_counters &register_mem_counters()
+{
+  std::unique_ptr<mem_counters> counters{new mem_counters{}};
+  std::lock_guard<std::mutex> lock{threads_mutex};
+  threads.push_back(std::move(counters));
+  return *threads.back();
+}
+
+void write_mem_usage(std::ostream &out)
+{
+  const std::streamsize precision = out.precision();
+  bool first = true;
+  for (size_t t = 0; t < MEM_TAGS; ++t)
+  {
+    const mem_total sum = total(t);
+    if (sum.peak == 0)
+      continue;
+    out << (first ? "" : " ") << mem_tag_names[t] << " " << std::fixed
+        << std::setprecision(1) << sum.live / 1048576. << "/"
+        << sum.peak / 1048576.;
+    first = false;
+  }
+  out.unsetf(std::ios::floatfield);
+  out.precision(precision);
+}
+
+void write_mem_table(std::ostream &out)
+{
+  out << "structure live_bytes peak_bytes" << std::endl;
+  for (size_t t = 0; t < MEM_TAGS; ++t)
+  {
+    const mem_total sum = total(t);
+    if (sum.peak == 0)
+      continue;
+    out << mem_tag_names[t] << " " << sum.live << " " << sum.peak << std::endl;
+  }
+}
@@ -0,0 +1,139 @@
+#ifndef MEM_USAGE_H
+#define MEM_USAGE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <ostream>
+#include <unordered_map>
+#include <vector>
+
+// Accounting of the memory policies hold, by the structure holding it.
+//
+// Containers of the policies allocate through a counting_allocator tagged
+// with what they are (see the aliases below), which keeps the live and peak
+// bytes of every tag. lsm-sim -v reports them in its progress line and when
+// it dumps stats, so a run that grows too large shows what grew.
+//
+// Every thread counts into its own counters, which only it writes, so
+// counting costs a few plain loads and stores; the writers below add up the
+// counters of all threads. With -X or -x the totals cover every
+// configuration that runs at the same time, and the peak is the sum of the
+// threads' peaks, which is exact for a single run and an upper bound
+// otherwise.
+
+enum class mem_tag
+{
+  hash_index,   // per-key tables (key_map and the policies' hash maps)
+  queue,        // LRU, FIFO and CLOCK queues
+  segments,     // queues of lsm's and multi's segments
+  flash_blocks, // ripq's and ramshield's flash blocks, where ghosts live
+  distances,    // hit_rate_curve distance counts
+};
+
+static const size_t MEM_TAGS = size_t(mem_tag::distances) + 1;
+
+// The counters of one thread. live may go negative in a thread that frees
+// what another one allocated; only the sum over threads is meaningful.
+struct mem_counters
+{
+  std::atomic<int64_t> live[MEM_TAGS];
+  std::atomic<int64_t> peak[MEM_TAGS];
+};
+
+// @return - the counters of the calling thread, created on its first call.
+mem_counters &register_mem_counters();
+
+inline mem_counters &local_mem_counters()
+{
+  static thread_local mem_counters *counters = nullptr;
+  if (!counters)
+    counters = &register_mem_counters();
+  return *counters;
+}
+
+inline void mem_allocated(mem_tag tag, size_t bytes)
+{
+  mem_counters &c = local_mem_counters();
+  const size_t t = size_t(tag);
+  const int64_t live = c.live[t].load(std::memory_order_relaxed) + bytes;
+  c.live[t].store(live, std::memory_order_relaxed);
+  if (live > c.peak[t].load(std::memory_order_relaxed))
+    c.peak[t].store(live, std::memory_order_relaxed);
+}
+
+inline void mem_freed(mem_tag tag, size_t bytes)
+{
+  mem_counters &c = local_mem_counters();
+  const size_t t = size_t(tag);
+  c.live[t].store(c.live[t].load(std::memory_order_relaxed) - bytes,
+                  std::memory_order_relaxed);
+}
+
+// Writes the live and peak MB of every tag that was used on one line, e.g.
+// "hash_index 10.2/12.0 queue 3.1/3.1".
+void write_mem_usage(std::ostream &out);
+
+// Writes a line with the live and peak bytes of every tag that was used.
+void write_mem_table(std::ostream &out);
+
+// std::allocator that counts what it allocates under \a Tag.
+template <typename T, mem_tag Tag>
+class counting_allocator
+{
+public:
+  typedef T value_type;
+
+  template <typename U>
+  struct rebind
+  {
+    typedef counting_allocator<U, Tag> other;
+  };
+
+  counting_allocator() noexcept {}
+
+  template <typename U>
+  counting_allocator(const counting_allocator<U, Tag> &) noexcept
+  {
+  }
+
+  T *allocate(size_t n)
+  {
+    mem_allocated(Tag, n * sizeof(T));
+    return std::allocator<T>{}.allocate(n);
+  }
+
+  void deallocate(T *p, size_t n) noexcept
+  {
+    mem_freed(Tag, n * sizeof(T));
+    std::allocator<T>{}.deallocate(p, n);
+  }
+
+  template <typename U>
+  bool operator==(const counting_allocator<U, Tag> &) const noexcept
+  {
+    return true;
+  }
+
+  template <typename U>
+  bool operator!=(const counting_allocator<U, Tag> &) const noexcept
+  {
+    return false;
+  }
+};
+
+template <typename T, mem_tag Tag>
+using counted_list = std::list<T, counting_allocator<T, Tag>>;
+
+template <typename T, mem_tag Tag>
+using counted_vector = std::vector<T, counting_allocator<T, Tag>>;
+
+template <typename K, typename V, mem_tag Tag>
+using counted_unordered_map =
+    std::unordered_map<K, V, std::hash<K>, std::equal_to<K>,
+                       counting_allocator<std::pair<const K, V>, Tag>>;
+
+#endif
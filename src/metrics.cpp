@@ -0,0 +1,224 @@
+#include <cassert>
+#include <cinttypes>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#include "metrics.h"
+
+namespace {
+
+bool ends_with(const std::string &s, const std::string &suffix)
+{
+  return s.size() >= suffix.size() &&
+         s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+} // namespace
+
+metrics_writer::metrics_writer(const std::string &path, size_t slots)
+    : path{path}, file{fopen(path.c_str(), "wb")},
+      binary{ends_with(path, ".bin")}, ring(slots), pushed{}, written{},
+      closed{false}, mutex{}, row_pushed{}, row_written{}, writer{}
+{
+  assert(slots > 0);
+  if (!file)
+  {
+    std::cerr << "Couldn't open " << path << " for writing" << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  if (binary)
+  {
+    metrics_header header{};
+    memcpy(header.magic, METRICS_MAGIC, sizeof(header.magic));
+    header.version = METRICS_VERSION;
+    header.row_size = sizeof(metrics_row);
+    fwrite(&header, sizeof(header), 1, file);
+  }
+  else
+  {
+    fputs("begin,end,app,accesses,hits,hit_bytes,miss_bytes,evicted_items,"
+          "evicted_bytes,hits_dram,hits_flash,writes_flash,"
+          "flash_bytes_written,bytes_cached\n", file);
+  }
+
+  writer = std::thread{[this] { run(); }};
+}
+
+metrics_writer::~metrics_writer()
+{
+  {
+    std::lock_guard<std::mutex> lock{mutex};
+    closed = true;
+  }
+  row_pushed.notify_one();
+  writer.join();
+
+  if (fclose(file) != 0)
+  {
+    std::cerr << "Couldn't write metrics to " << path << std::endl;
+    exit(EXIT_FAILURE);
+  }
+}
+
+void metrics_writer::push(const metrics_row &row)
+{
+  {
+    std::unique_lock<std::mutex> lock{mutex};
+    row_written.wait(lock, [this] { return pushed - written < ring.size(); });
+    ring[pushed % ring.size()] = row;
+    ++pushed;
+  }
+  row_pushed.notify_one();
+}
+
+void metrics_writer::run()
+{
+  std::unique_lock<std::mutex> lock{mutex};
+  while (true)
+  {
+    row_pushed.wait(lock, [this] { return written < pushed || closed; });
+    if (written == pushed)
+      break;
+
+    // Rows up to pushed are ours until written moves past them.
+    const uint64_t end = pushed;
+    lock.unlock();
+    for (uint64_t i = written; i < end; ++i)
+      write(ring[i % ring.size()]);
+    lock.lock();
+    written = end;
+    row_written.notify_one();
+  }
+}
+
+void metrics_writer::write(const metrics_row &row)
+{
+  if (binary)
+  {
+    fwrite(&row, sizeof(row), 1, file);
+    return;
+  }
+
+  char app[16];
+  if (row.app == METRICS_ALL_APPS)
+    strcpy(app, "all");
+  else
+    snprintf(app, sizeof(app), "%" PRIu32, row.app);
+  fprintf(file, "%.10g,%.10g,%s,%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64
+                ",%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64
+                ",%" PRIu64 ",%" PRIu64 "\n",
+          row.begin, row.end, app, row.accesses, row.hits, row.hit_bytes,
+          row.miss_bytes, row.evicted_items, row.evicted_bytes, row.hits_dram,
+          row.hits_flash, row.writes_flash, row.flash_bytes_written,
+          row.bytes_cached);
+}
+
+metrics::metrics(const std::string &path, double interval, uint64_t requests)
+    : interval{interval}, requests{requests}, started{false}, window_begin{},
+      window_requests{}, last_time{}, at_begin{}, apps{}, app_index{},
+      writer{path, 4096}
+{
+  assert(interval > 0 || requests > 0);
+}
+
+metrics_row metrics::snapshot(const stats &stat)
+{
+  metrics_row row{};
+  row.app = METRICS_ALL_APPS;
+  row.accesses = stat.accesses;
+  row.hits = stat.hits;
+  row.evicted_items = stat.evicted_items;
+  row.evicted_bytes = stat.evicted_bytes;
+  row.hits_dram = stat.hits_dram;
+  row.hits_flash = stat.hits_flash;
+  row.writes_flash = stat.writes_flash;
+  row.flash_bytes_written = stat.flash_bytes_written;
+  row.bytes_cached = stat.bytes_cached;
+  return row;
+}
+
+void metrics::advance(const Request &r, const stats &stat)
+{
+  if (!started)
+  {
+    started = true;
+    window_begin = interval > 0 ? std::floor(r.time / interval) * interval
+                                : r.time;
+    at_begin = snapshot(stat);
+    return;
+  }
+
+  if (interval > 0)
+  {
+    // Windows without Requests get rows too, so curves stay regular.
+    while (r.time >= window_begin + interval)
+    {
+      close(window_begin + interval, stat);
+      window_begin += interval;
+    }
+  }
+  else if (window_requests == requests)
+  {
+    close(last_time, stat);
+    window_begin = r.time;
+  }
+}
+
+void metrics::finish(const stats &stat)
+{
+  if (started)
+    close(interval > 0 ? window_begin + interval : last_time, stat);
+  started = false;
+}
+
+void metrics::close(double end, const stats &stat)
+{
+  const metrics_row now = snapshot(stat);
+
+  uint64_t hit_bytes = 0;
+  uint64_t miss_bytes = 0;
+  for (const auto &app : apps)
+  {
+    hit_bytes += app.second.hit_bytes;
+    miss_bytes += app.second.miss_bytes;
+  }
+
+  metrics_row all = now;
+  all.begin = window_begin;
+  all.end = end;
+  all.accesses = now.accesses - at_begin.accesses;
+  all.hits = now.hits - at_begin.hits;
+  all.hit_bytes = hit_bytes;
+  all.miss_bytes = miss_bytes;
+  all.evicted_items = now.evicted_items - at_begin.evicted_items;
+  all.evicted_bytes = now.evicted_bytes - at_begin.evicted_bytes;
+  all.hits_dram = now.hits_dram - at_begin.hits_dram;
+  all.hits_flash = now.hits_flash - at_begin.hits_flash;
+  all.writes_flash = now.writes_flash - at_begin.writes_flash;
+  all.flash_bytes_written =
+      now.flash_bytes_written - at_begin.flash_bytes_written;
+  writer.push(all);
+
+  for (auto &app : apps)
+  {
+    counters &c = app.second;
+    if (c.accesses == 0)
+      continue;
+    metrics_row row{};
+    row.begin = window_begin;
+    row.end = end;
+    row.app = app.first;
+    row.accesses = c.accesses;
+    row.hits = c.hits;
+    row.hit_bytes = c.hit_bytes;
+    row.miss_bytes = c.miss_bytes;
+    writer.push(row);
+    c = counters{};
+  }
+
+  at_begin = now;
+  window_requests = 0;
+}
@@ -0,0 +1,179 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "request.h"
+#include "stats.h"
+
+// Time series of a run's counters (lsm-sim -I/-Q).
+//
+// After warmup the run is cut into windows of fixed trace time or of a fixed
+// number of Requests. For every window a row with the counters of the whole
+// cache is written, followed by one row per app that had Requests in it:
+//
+//   begin,end,app,accesses,hits,hit_bytes,miss_bytes,evicted_items,
+//   evicted_bytes,hits_dram,hits_flash,writes_flash,flash_bytes_written,
+//   bytes_cached
+//
+// Cache-wide counters are the change of the Policy's stats over the window
+// (bytes_cached is its level at the end); hits and bytes are attributed to
+// apps by the driver as Requests are processed, so app rows only carry
+// accesses, hits, hit_bytes and miss_bytes. Rows go through a ring of
+// preallocated slots to a thread that writes them, so the simulation never
+// waits for output unless the writer falls a whole ring behind.
+//
+// Files ending in ".bin" hold a metrics_header and the rows as they are in
+// memory (host byte order, like binary traces); anything else is CSV.
+
+static const char METRICS_MAGIC[8] = {'L', 'S', 'M', 'M', 'E', 'T', 'R', 'C'};
+static const uint32_t METRICS_VERSION = 1;
+
+// App of the rows with the counters of the whole cache.
+static const uint32_t METRICS_ALL_APPS = UINT32_MAX;
+
+struct metrics_header
+{
+  char magic[8];
+  uint32_t version;
+  uint32_t row_size;
+};
+
+struct metrics_row
+{
+  double begin;        // time windows: [begin, end) of the window
+  double end;          // Request windows: times of its first and last Request
+  uint32_t app;        // METRICS_ALL_APPS for the whole cache
+  uint32_t pad;
+  uint64_t accesses;
+  uint64_t hits;
+  uint64_t hit_bytes;
+  uint64_t miss_bytes;
+  uint64_t evicted_items;
+  uint64_t evicted_bytes;
+  uint64_t hits_dram;
+  uint64_t hits_flash;
+  uint64_t writes_flash;
+  uint64_t flash_bytes_written;
+  uint64_t bytes_cached;
+};
+
+// Writes metrics_rows to a file on a background thread.
+class metrics_writer
+{
+public:
+  // Exits if \a path can't be written.
+  metrics_writer(const std::string &path, size_t slots);
+
+  // Writes the rows still in the ring and closes the file.
+  ~metrics_writer();
+
+  // Queues \a row, waiting only if the ring is full.
+  void push(const metrics_row &row);
+
+private:
+  void run();
+  void write(const metrics_row &row);
+
+  std::string path;
+  FILE *file;
+  bool binary;
+
+  std::vector<metrics_row> ring;
+  uint64_t pushed;
+  uint64_t written;
+  bool closed;
+
+  std::mutex mutex;
+  std::condition_variable row_pushed;
+  std::condition_variable row_written;
+  std::thread writer;
+
+  metrics_writer(const metrics_writer &) = delete;
+  metrics_writer &operator=(const metrics_writer &) = delete;
+};
+
+// Cuts the Requests of a run after warmup into windows and hands a row per
+// window and app to a metrics_writer.
+class metrics
+{
+public:
+  // @param interval - trace seconds per window; 0 to cut by Requests.
+  // @param requests - Requests per window when \a interval is 0.
+  metrics(const std::string &path, double interval, uint64_t requests);
+
+  // Closes the windows that end at or before \a r, which is about to be
+  // processed; the first call opens the first window.
+  void advance(const Request &r, const stats &stat);
+
+  // Counts \a r, which has just been processed.
+  void add(const Request &r, bool hit)
+  {
+    counters &c = app_counters(r.appid);
+    ++c.accesses;
+    if (hit)
+    {
+      ++c.hits;
+      c.hit_bytes += r.size();
+    }
+    else
+    {
+      c.miss_bytes += r.size();
+    }
+    ++window_requests;
+    last_time = r.time;
+  }
+
+  // Closes the last window, if any, and writes out every row.
+  void finish(const stats &stat);
+
+private:
+  struct counters
+  {
+    uint64_t accesses;
+    uint64_t hits;
+    uint64_t hit_bytes;
+    uint64_t miss_bytes;
+  };
+
+  counters &app_counters(uint32_t appid)
+  {
+    auto it = app_index.find(appid);
+    if (it != app_index.end())
+      return apps[it->second].second;
+    app_index.emplace(appid, apps.size());
+    apps.push_back({appid, counters{}});
+    return apps.back().second;
+  }
+
+  // @return - the cache-wide counters of \a stat.
+  static metrics_row snapshot(const stats &stat);
+
+  // Writes the rows of the current window, which ends at \a end.
+  void close(double end, const stats &stat);
+
+  double interval;
+  uint64_t requests;
+
+  bool started;
+  double window_begin;
+  uint64_t window_requests;
+  double last_time;
+  metrics_row at_begin; // cache-wide counters when the window opened
+
+  // Apps in order of their first Request.
+  std::vector<std::pair<uint32_t, counters>> apps;
+  std::unordered_map<uint32_t, size_t> app_index;
+
+  metrics_writer writer;
+};
+
+#endif
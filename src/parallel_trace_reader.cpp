@@ -0,0 +1,164 @@
+#include <iostream>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "parallel_trace_reader.h"
+
+parallel_trace_reader::parallel_trace_reader(const std::string &path,
+                                             size_t nthreads)
+    : base{nullptr}, length{}, chunk_starts{}, ring{}, mutex{},
+      chunk_ready{}, slot_free{}, next_chunk{}, head_chunk{}, stopping{false},
+      head_pos{}, bytes_read{}, workers{}
+{
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+  {
+    std::cerr << "Couldn't open trace " << path << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) != 0)
+  {
+    std::cerr << "Couldn't stat trace " << path << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  length = st.st_size;
+
+  if (length > 0)
+  {
+    base = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (base == MAP_FAILED)
+    {
+      std::cerr << "Couldn't mmap trace " << path << std::endl;
+      exit(EXIT_FAILURE);
+    }
+    madvise(base, length, MADV_SEQUENTIAL);
+  }
+  close(fd);
+
+  // Cut the file at the first newline at or after every CHUNK_SIZE offset;
+  // only the pages around the cuts are touched here.
+  const char *bytes = static_cast<const char *>(base);
+  size_t start = 0;
+  while (start < length)
+  {
+    chunk_starts.push_back(start);
+    size_t cut = start + CHUNK_SIZE;
+    if (cut >= length)
+      break;
+    const char *nl =
+        static_cast<const char *>(memchr(bytes + cut, '\n', length - cut));
+    start = nl ? size_t(nl - bytes) + 1 : length;
+  }
+  chunk_starts.push_back(length);
+
+  nthreads = std::max<size_t>(nthreads, 1);
+  ring.resize(2 * nthreads + 2);
+  for (size_t t = 0; t < nthreads; ++t)
+    workers.emplace_back(&parallel_trace_reader::worker, this);
+}
+
+parallel_trace_reader::~parallel_trace_reader()
+{
+  {
+    std::lock_guard<std::mutex> lock{mutex};
+    stopping = true;
+  }
+  slot_free.notify_all();
+  for (std::thread &t : workers)
+    t.join();
+
+  if (base)
+    munmap(base, length);
+}
+
+void parallel_trace_reader::worker()
+{
+  const size_t num_chunks = chunk_starts.size() - 1;
+  for (;;)
+  {
+    size_t chunk = 0;
+    {
+      std::unique_lock<std::mutex> lock{mutex};
+      // The slot for chunk c is free once chunk c - ring.size() is drained.
+      slot_free.wait(lock, [&] {
+        return stopping || next_chunk >= num_chunks ||
+               next_chunk < head_chunk + ring.size();
+      });
+      if (stopping || next_chunk >= num_chunks)
+        return;
+      chunk = next_chunk++;
+    }
+
+    slot &s = ring[chunk % ring.size()];
+    parse_chunk(chunk, &s);
+
+    {
+      std::lock_guard<std::mutex> lock{mutex};
+      s.ready = true;
+    }
+    chunk_ready.notify_one();
+  }
+}
+
+void parallel_trace_reader::parse_chunk(size_t chunk, slot *s) const
+{
+  const char *pos = static_cast<const char *>(base) + chunk_starts[chunk];
+  const char *const end = static_cast<const char *>(base) +
+                          chunk_starts[chunk + 1];
+
+  s->requests.clear();
+  s->bytes = 0;
+  while (pos < end)
+  {
+    const char *nl = static_cast<const char *>(memchr(pos, '\n', end - pos));
+    // Only the last chunk can end without a newline.
+    const char *line_end = nl ? nl : end;
+
+    s->requests.emplace_back();
+    s->requests.back().parse(pos, line_end);
+    s->bytes += line_end - pos;
+
+    pos = nl ? nl + 1 : end;
+  }
+}
+
+size_t parallel_trace_reader::read(Request *out, size_t n)
+{
+  const size_t num_chunks = chunk_starts.size() - 1;
+  size_t filled = 0;
+  while (filled < n && head_chunk < num_chunks)
+  {
+    slot &s = ring[head_chunk % ring.size()];
+    {
+      std::unique_lock<std::mutex> lock{mutex};
+      chunk_ready.wait(lock, [&] { return s.ready; });
+    }
+
+    size_t take = std::min(n - filled, s.requests.size() - head_pos);
+    std::copy(s.requests.begin() + head_pos,
+              s.requests.begin() + head_pos + take, out + filled);
+    filled += take;
+    head_pos += take;
+    if (head_pos < s.requests.size())
+      break;
+
+    // Hand the drained slot back to the workers.
+    bytes_read += s.bytes;
+    head_pos = 0;
+    {
+      std::lock_guard<std::mutex> lock{mutex};
+      s.ready = false;
+      ++head_chunk;
+    }
+    slot_free.notify_all();
+  }
+  return filled;
+}
@@ -0,0 +1,67 @@
+#ifndef PARALLEL_TRACE_READER_H
+#define PARALLEL_TRACE_READER_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "trace_reader.h"
+
+// Parses a CSV trace on several threads while the simulation runs.
+//
+// The mapped file is cut into chunks of roughly CHUNK_SIZE bytes that end on
+// line boundaries. Worker threads claim chunks in file order and parse each
+// into its own slot of a bounded ring; read() drains the slots strictly in
+// chunk order, so Requests come out in exactly the order the serial
+// csv_trace_reader produces them. Workers never run more than ring.size()
+// chunks ahead of the consumer, which bounds memory to a few chunks' worth
+// of Requests per thread.
+class parallel_trace_reader : public trace_reader
+{
+public:
+  parallel_trace_reader(const std::string &path, size_t nthreads);
+  ~parallel_trace_reader();
+
+  size_t read(Request *out, size_t n);
+  size_t get_bytes_read() const { return bytes_read; }
+
+private:
+  static constexpr size_t CHUNK_SIZE = 4 * 1024 * 1024;
+
+  struct slot
+  {
+    slot() : requests{}, bytes{}, ready{false} {}
+
+    std::vector<Request> requests;
+    size_t bytes;  // line bytes (excluding newlines) parsed into requests
+    bool ready;
+  };
+
+  void worker();
+  void parse_chunk(size_t chunk, slot *s) const;
+
+  void *base;
+  size_t length;
+  std::vector<size_t> chunk_starts;  // plus a final entry at length
+
+  std::vector<slot> ring;
+  std::mutex mutex;
+  std::condition_variable chunk_ready;
+  std::condition_variable slot_free;
+  size_t next_chunk;  // next chunk a worker will claim
+  size_t head_chunk;  // chunk read() is draining
+  bool stopping;
+
+  size_t head_pos;  // next Request to hand out from the head slot
+  size_t bytes_read;
+
+  std::vector<std::thread> workers;
+
+  parallel_trace_reader(const parallel_trace_reader &) = delete;
+  parallel_trace_reader &operator=(const parallel_trace_reader &) = delete;
+};
+
+#endif
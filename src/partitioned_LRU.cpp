@@ -3,6 +3,8 @@
 #include <cassert>
 
 #include "partitioned_LRU.h"
+#include "cache_entry.h"
+#include "prefetch.h"
 #include "openssl/sha.h"
 
 struct Partitioned_LRU::Partition // 单个分区
@@ -49,9 +51,9 @@ struct Partitioned_LRU::Partition // 单个分区
     {
       // 对象链表节点指针
       auto queue_iterator = map_iterator->second;
-      Request &existing_request = *queue_iterator;
+      const cache_entry &existing_request = *queue_iterator;
       if (existing_request.size() == request.size() &&
-          existing_request.frag_sz == request.frag_sz) // 若请求大小与对象大小相同
+          existing_request.get_frag() == request.frag_sz) // 若请求大小与对象大小相同
       {
         // 移动到lru队列头部
         m_partition_queue.erase(queue_iterator);
@@ -65,10 +67,10 @@ struct Partitioned_LRU::Partition // 单个分区
       else // 若请求大小与对象大小不同，更新
       {
         // 从lru队列中删除，然后重新插入
-        m_partition_queue.erase(queue_iterator);
-        m_partition_map.erase(existing_request.kid);
         m_r_stats.bytes_cached -= existing_request.size();
         m_partition_bytes_cached -= existing_request.size();
+        m_partition_map.erase(map_iterator);
+        m_partition_queue.erase(queue_iterator);
         absolute_bytes_added = add_request(request);
       }
     }
@@ -79,6 +81,22 @@ struct Partitioned_LRU::Partition // 单个分区
     return absolute_bytes_added;
   }
 
+  // Prefetches the map slot of \a kid (see prefetch.h).
+  void prefetch_slot(uint32_t kid) const
+  {
+    prefetch_bucket(m_partition_map, kid);
+  }
+
+  // Prefetches the queue entry of \a kid, if it is cached.
+  void prefetch_entry(uint32_t kid) const
+  {
+    auto map_iterator = m_partition_map.find(kid);
+    if (map_iterator != m_partition_map.end())
+    {
+      prefetch(&*map_iterator->second);
+    }
+  }
+
   // Adds a request to the cache within this partition.
   //
   // If adequate space with respect to this partition to add the request does
@@ -97,14 +115,14 @@ struct Partitioned_LRU::Partition // 单个分区
       while (m_partition_bytes_cached + request.size() > m_partition_size && !m_partition_queue.empty())
       {
         // 驱逐队尾请求
-        Request *eviction_candidate = &m_partition_queue.back();
-        m_partition_queue.pop_back();
-        m_partition_map.erase(eviction_candidate->kid);
-        m_partition_bytes_cached -= eviction_candidate->size();
-        m_r_stats.bytes_cached -= eviction_candidate->size();
+        const cache_entry &eviction_candidate = m_partition_queue.back();
+        m_partition_map.erase(eviction_candidate.kid);
+        m_partition_bytes_cached -= eviction_candidate.size();
+        m_r_stats.bytes_cached -= eviction_candidate.size();
 
-        m_r_stats.evicted_bytes += eviction_candidate->size();
+        m_r_stats.evicted_bytes += eviction_candidate.size();
         m_r_stats.evicted_items++;
+        m_partition_queue.pop_back();
       }
       // 插入新请求
       if (m_partition_bytes_cached + request.size() <= m_partition_size)
@@ -123,8 +141,8 @@ private:
   stats &m_r_stats;
   const size_t m_partition_size;                                              // 分区大小
   size_t m_partition_bytes_cached;                                            // 分区中缓存的字节数
-  std::unordered_map<uint32_t, std::list<Request>::iterator> m_partition_map; // 哈希表
-  std::list<Request> m_partition_queue;                                       // 链表
+  std::unordered_map<uint32_t, std::list<cache_entry>::iterator> m_partition_map; // 哈希表
+  std::list<cache_entry> m_partition_queue;                                       // 链表
 };
 
 Partitioned_LRU::Partitioned_LRU(stats stat,
@@ -138,7 +156,7 @@ Partitioned_LRU::Partitioned_LRU(stats stat,
   m_p_partitions.reserve(num_partitions);
   for (size_t i = 0; i < num_partitions; ++i)
   {
-    m_p_partitions[i] = std::make_unique<Partition>(partition_size, this->stat);
+    m_p_partitions.push_back(std::make_unique<Partition>(partition_size, this->stat));
   }
 }
 
@@ -147,6 +165,36 @@ Partitioned_LRU::~Partitioned_LRU()
 }
 
 size_t Partitioned_LRU::process_request(const Request *p_request, bool warmup)
+{
+  // 计算请求哈希值，mod分区数得到分区序号
+  return process_in_partition(p_request, warmup,
+                              p_request->hash_key(m_num_partitions));
+}
+
+void Partitioned_LRU::process_batch(const Request *begin, size_t n,
+                                    bool warmup)
+{
+  // Partitions of the requests between the one being processed and the
+  // farthest one prefetched.
+  size_t partitions[PREFETCH_DISTANCE + 1];
+  pipeline_batch(n,
+    [&](size_t i) {
+      size_t &partition = partitions[i % (PREFETCH_DISTANCE + 1)];
+      partition = begin[i].hash_key(m_num_partitions);
+      m_p_partitions[partition]->prefetch_slot(begin[i].kid);
+    },
+    [&](size_t i) {
+      size_t partition = partitions[i % (PREFETCH_DISTANCE + 1)];
+      m_p_partitions[partition]->prefetch_entry(begin[i].kid);
+    },
+    [&](size_t i) {
+      process_in_partition(&begin[i], warmup,
+                           partitions[i % (PREFETCH_DISTANCE + 1)]);
+    });
+}
+
+size_t Partitioned_LRU::process_in_partition(const Request *p_request,
+                                             bool warmup, size_t partition)
 {
   Request request = *p_request;
   assert(request.size() > 0);
@@ -158,10 +206,8 @@ size_t Partitioned_LRU::process_request(const Request *p_request, bool warmup)
   {
     ++stat.accesses;
   }
-  // 计算请求哈希值，mod分区数得到分区序号
-  size_t request_hash = p_request->hash_key(m_num_partitions);
   // 对应的分区处理请求
-  return m_p_partitions[request_hash]->process_request(p_request, warmup);
+  return m_p_partitions[partition]->process_request(p_request, warmup);
 }
 
 size_t Partitioned_LRU::get_bytes_cached() const
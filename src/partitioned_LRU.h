@@ -36,6 +36,11 @@ public:
   // bytes due to processing this request. i.e. bytes_evicted - bytes_cached.
   size_t process_request(const Request *request, bool warmup);
 
+  // Processes a batch of requests, hashing each of them once and prefetching
+  // the map slots and queue entries of upcoming ones in their partitions
+  // (see prefetch.h).
+  void process_batch(const Request *begin, size_t n, bool warmup);
+
   // Reports the current number of bytes utilized by cached requests.
   // (conforms to Policy interface)
   //
@@ -44,6 +49,10 @@ public:
   size_t get_bytes_cached() const;
 
 private:
+  // Counts \a p_request and hands it to partition \a partition.
+  size_t process_in_partition(const Request *p_request, bool warmup,
+                              size_t partition);
+
   size_t m_num_partitions;
   size_t m_max_overall_request_size;
   std::vector<std::unique_ptr<Partition>> m_p_partitions;
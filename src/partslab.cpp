@@ -7,7 +7,8 @@
 #include "mc.h"
 
 partslab::partslab(stats stat)
-    : Policy{stat}, slabs{}, size_curve{}
+    : Policy{stat}, slabs{}, size_curve{},
+      sampler{stat.sample_rate, stat.sample_keys}, compulsory_misses{}
 {
   slabs.resize(stat.partitions);
   std::cerr << "Initialized with " << stat.partitions << " partitions" << std::endl;
@@ -21,6 +22,15 @@ size_t partslab::process_request(const Request *r, bool warmup)
 {
   assert(r->size() > 0);
 
+  // 空间采样：只模拟被采样的键
+  auto forget = [this](uint32_t kid) {
+    slabs.at(std::hash<uint32_t>{}(kid) % stat.partitions).remove(kid);
+  };
+  if (!warmup)
+    sampler.seen();
+  if (!sampler.sample(r->kid) || !sampler.admit(r->kid, forget))
+    return PROC_MISS;
+
   // decltype(r->kid) 用于获取 r->kid 的类型，std::hash<decltype(r->kid)> 则是一个针对该类型的哈希函数对象
   // {} 是一个临时对象的构造方式，(r->kid) 则是对 r->kid 进行哈希计算，生成一个无符号整数类型的哈希值
   // 根据请求键哈希值计算出slab class序号
@@ -34,15 +44,17 @@ size_t partslab::process_request(const Request *r, bool warmup)
     // Don't count compulsory misses.
     // if (!warmup)
     // size_curve.miss();
+    if (!warmup)
+      compulsory_misses += sampler.weight();
     return PROC_MISS;
   }
 
   // 计算近似全局重用距离(分区重用距离*分区数+分区序号)
-  const size_t approx_global_size_distance = size_distance *
+  const size_t approx_global_size_distance = sampler.scale(size_distance) *
                                                  stat.partitions +
                                              klass;
   if (!warmup)
-    size_curve.hit(approx_global_size_distance);
+    size_curve.hit(approx_global_size_distance, sampler.weight());
 
   return 0;
 }
@@ -61,6 +73,7 @@ void partslab::log_curves()
     app_ids += std::to_string(a);
 
   std::string filename_suffix{"-app" + app_ids + (stat.memcachier_classes ? "-memcachier" : "-memcached")};
+  sampler.adjust(size_curve, compulsory_misses);
   size_curve.dump_cdf("partslab-size-curve" + filename_suffix + ".data");
   dump_util("partslab-util" + filename_suffix + ".data");
 }
@@ -6,6 +6,7 @@
 #include "hit_rate_curve.h"
 #include "policy.h"
 #include "shadowlru.h"
+#include "shards.h"
 #include "mc.h"
 
 // policy derived from Cliffhanger paper
@@ -25,6 +26,10 @@ public:
 private:
   std::vector<shadowlru> slabs;
   hit_rate_curve size_curve;
+  // Keys simulated, across all partitions, and the weight of the
+  // compulsory misses the curve leaves out.
+  shards sampler;
+  size_t compulsory_misses;
 };
 
 #endif
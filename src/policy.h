@@ -2,9 +2,11 @@
 #define Policy_H
 
 #include <cassert>
+#include <memory>
 #include <string>
 
 #include "common.h"
+#include "profile.h"
 #include "request.h"
 #include "stats.h"
 #include <iostream>
@@ -30,18 +32,29 @@ protected:
   stats stat;
   bool all_apps;
   std::string m_file_name;
+  // Where the statistics written during a run go; std::cout unless the
+  // driver runs several policies at once (see set_output()).
+  std::ostream *out;
+  // Latency profile (see profile.h); null unless profiling is enabled.
+  std::shared_ptr<profiler> profile;
 
 public:
   Policy(stats stat)
-      : stat{stat}, all_apps{!stat.apps ? false : stat.apps->empty()}, m_file_name("")
+      : stat{stat}, all_apps{!stat.apps ? false : stat.apps->empty()}, m_file_name(""),
+        out{&std::cout}, profile{}
   {
   }
 
   Policy(stats stat, const std::string &file_name)
-      : stat{stat}, all_apps{!stat.apps ? false : stat.apps->empty()}, m_file_name(file_name)
+      : stat{stat}, all_apps{!stat.apps ? false : stat.apps->empty()}, m_file_name(file_name),
+        out{&std::cout}, profile{}
   {
   }
 
+  // Copies (e.g. the LRUs of a slab) write to the same output and profile.
+  Policy(const Policy &) = default;
+  Policy &operator=(const Policy &) = default;
+
   virtual ~Policy() {}
 
   enum
@@ -51,23 +64,67 @@ public:
 
   virtual size_t process_request(const Request *request, bool warmup) = 0;
 
+  // Processes the \a n Requests starting at \a begin in order, all of them
+  // in warmup or all of them not. Policies whose per-key lookups miss the
+  // CPU caches override it to prefetch for upcoming Requests (see
+  // prefetch.h).
+  virtual void process_batch(const Request *begin, size_t n, bool warmup)
+  {
+    for (size_t i = 0; i < n; ++i)
+      process_request(&begin[i], warmup);
+  }
+
   virtual size_t get_bytes_cached() const = 0;
 
   virtual void log_curves()
   {
-    std::cout << "Not enabled for this Policy" << std::endl;
+    *out << "Not enabled for this Policy" << std::endl;
   }
 
   stats *get_stats() { return &stat; }
 
+  // Checkpointing (see checkpoint.h). Policies that support it override all
+  // three: save() writes everything later Requests depend on, and restore()
+  // reads it back into a Policy built with the same parameters.
+  virtual bool can_checkpoint() const { return false; }
+  virtual void save(checkpoint_writer &w) const { assert(false); }
+  virtual void restore(checkpoint_reader &r) { assert(false); }
+
+  // Changes the tunables of a running Policy (see lsm-sim -V): the knobs of
+  // \a config that are read as Requests arrive, and the threshold. Sizes
+  // and everything else the Policy was built from stay as they are.
+  virtual void retune(const policy_config &config, double threshold)
+  {
+    stat.config.k = config.k;
+    stat.config.l_fc = config.l_fc;
+    stat.config.use_tax = config.use_tax;
+    stat.config.tax_rate = config.tax_rate;
+    stat.threshold = threshold;
+  }
+
+  // Sends this policy's statistics output to \a stream instead of std::cout.
+  void set_output(std::ostream *stream) { out = stream; }
+
+  // Records the latency of process_request() and its phases from now on
+  // (lsm-sim -y).
+  void enable_profiling() { profile = std::make_shared<profiler>(); }
+  profiler *get_profiler() { return profile.get(); }
+
+  // Writes the latency profile, if there is one.
+  void write_profile()
+  {
+    if (profile)
+      profile->write(*out);
+  }
+
   virtual void write_statistics_header()
   {
-    std::cout << "hit_rate utilization" << std::endl;
+    *out << "hit_rate utilization" << std::endl;
   }
 
   virtual void log_statistics_sample_point(const double &trace_time)
   {
-    std::cout << std::setprecision(10) << trace_time << " "
+    *out << std::setprecision(10) << trace_time << " "
               << stat.get_hit_rate() << " "
               << stat.get_utilization() << " "
               << std::endl;
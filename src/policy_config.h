@@ -0,0 +1,41 @@
+#ifndef POLICY_CONFIG_H
+#define POLICY_CONFIG_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Tuning knobs of the flash, multi-queue, clock and multi policies, set
+// from the command line. Every Policy gets its own copy through
+// stats::config, so differently configured policies can run side by side in
+// one process.
+struct policy_config
+{
+  /// -D/-F; DRAM and flash capacity of the flash cache policies.
+  size_t dram_size = 51209600;
+  size_t flash_size = 51209600;
+
+  /// -k/-H; weight and hit value of flashcache's flashiness formula.
+  double k = 1;
+  size_t l_fc = 1;
+
+  /// -K/-L; number of queues of lruk and the size of each.
+  size_t k_lru = 8;
+  size_t klru_queue_size = 1024;
+
+  /// -C; maximum clock value of clock and of flashcachelrukclk's queues.
+  size_t clock_max_value = 15;
+  size_t clock_max_value_klru = 7;
+
+  /// -T; whether multi taxes idle memory, and at which rate.
+  bool use_tax = false;
+  double tax_rate = 0.05;
+
+  /// -A; SVM threshold of flashcachelrukclkmachinelearning and flashshield.
+  double svm_threshold = 1;
+
+  /// App whose SVM model flashcachelrukclkmachinelearning and flashshield
+  /// load; the first app of the run.
+  uint32_t app = 0;
+};
+
+#endif
@@ -0,0 +1,216 @@
+#ifndef POOL_LRU_H
+#define POOL_LRU_H
+
+#include <cassert>
+#include <cinttypes>
+#include <cstddef>
+#include <iterator>
+#include <new>
+#include <type_traits>
+
+#include "mem_usage.h"
+
+// Intrusive doubly linked LRU queue whose nodes live in a pool, for LRU.
+//
+// Nodes are 32-bit handles into chunks of CHUNK nodes that are allocated as
+// the queue grows and never move, so a handle stays valid until its node is
+// erased and a per-key table can hold handles instead of iterators. Erased
+// nodes go on a free list and are reused before a new chunk is allocated;
+// the chunks are only released by clear(). Moving a node to the front
+// relinks it in place, so a hit costs no allocation and no table update.
+//
+// A node is a T and two handles, 28 bytes for a cache_entry, against 36
+// bytes and a malloc header for a std::list node. T has to be trivially
+// copyable, as nodes are never destroyed.
+template <typename T, mem_tag Tag>
+class pool_lru
+{
+public:
+  typedef uint32_t handle;
+  static const handle NONE = UINT32_MAX;
+
+  static_assert(std::is_trivially_copyable<T>::value,
+                "pool_lru never destroys its values");
+
+  pool_lru()
+      : chunks{}, head{NONE}, tail{NONE}, free_list{NONE}, used{}, count{}
+  {
+  }
+
+  T &operator[](handle h) { return *value(node_at(h)); }
+  const T &operator[](handle h) const
+  {
+    return *value(const_cast<pool_lru *>(this)->node_at(h));
+  }
+
+  // @return - the most recently used node, or NONE if empty.
+  handle front() const { return head; }
+  // @return - the least recently used node, or NONE if empty.
+  handle back() const { return tail; }
+  // @return - the node after \a h towards the back, or NONE.
+  handle next(handle h) const
+  {
+    return const_cast<pool_lru *>(this)->node_at(h).next;
+  }
+
+  size_t size() const { return count; }
+  bool empty() const { return count == 0; }
+
+  handle push_front(const T &v)
+  {
+    const handle h = allocate(v);
+    link_front(h);
+    return h;
+  }
+
+  handle push_back(const T &v)
+  {
+    const handle h = allocate(v);
+    node &n = node_at(h);
+    n.prev = tail;
+    n.next = NONE;
+    if (tail != NONE)
+      node_at(tail).next = h;
+    else
+      head = h;
+    tail = h;
+    return h;
+  }
+
+  void move_to_front(handle h)
+  {
+    if (h == head)
+      return;
+    unlink(h);
+    link_front(h);
+  }
+
+  void erase(handle h)
+  {
+    unlink(h);
+    node_at(h).next = free_list;
+    free_list = h;
+    --count;
+  }
+
+  void pop_back()
+  {
+    assert(tail != NONE);
+    erase(tail);
+  }
+
+  // Erases every node and releases the pool.
+  void clear()
+  {
+    chunks.clear();
+    head = tail = free_list = NONE;
+    used = 0;
+    count = 0;
+  }
+
+  // Iterates from the most to the least recently used value.
+  class const_iterator
+  {
+  public:
+    typedef std::forward_iterator_tag iterator_category;
+    typedef T value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef const T *pointer;
+    typedef const T &reference;
+
+    const_iterator(const pool_lru *queue, handle h) : queue{queue}, h{h} {}
+
+    reference operator*() const { return (*queue)[h]; }
+    pointer operator->() const { return &(*queue)[h]; }
+    const_iterator &operator++()
+    {
+      h = queue->next(h);
+      return *this;
+    }
+    bool operator==(const const_iterator &other) const { return h == other.h; }
+    bool operator!=(const const_iterator &other) const { return h != other.h; }
+
+  private:
+    const pool_lru *queue;
+    handle h;
+  };
+
+  const_iterator begin() const { return const_iterator{this, head}; }
+  const_iterator end() const { return const_iterator{this, NONE}; }
+
+private:
+  static const unsigned CHUNK_BITS = 10;
+  static const handle CHUNK = handle(1) << CHUNK_BITS;
+
+  struct node
+  {
+    typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+    handle prev;
+    handle next;
+  };
+
+  static T *value(node &n) { return reinterpret_cast<T *>(&n.storage); }
+
+  node &node_at(handle h)
+  {
+    assert(h < used);
+    return chunks[h >> CHUNK_BITS][h & (CHUNK - 1)];
+  }
+
+  handle allocate(const T &v)
+  {
+    handle h = free_list;
+    if (h != NONE)
+    {
+      free_list = node_at(h).next;
+    }
+    else
+    {
+      assert(used < NONE);
+      if (used == chunks.size() * CHUNK)
+        chunks.emplace_back(size_t(CHUNK));
+      h = used++;
+    }
+    new (&node_at(h).storage) T(v);
+    ++count;
+    return h;
+  }
+
+  void link_front(handle h)
+  {
+    node &n = node_at(h);
+    n.prev = NONE;
+    n.next = head;
+    if (head != NONE)
+      node_at(head).prev = h;
+    else
+      tail = h;
+    head = h;
+  }
+
+  void unlink(handle h)
+  {
+    node &n = node_at(h);
+    if (n.prev != NONE)
+      node_at(n.prev).next = n.next;
+    else
+      head = n.next;
+    if (n.next != NONE)
+      node_at(n.next).prev = n.prev;
+    else
+      tail = n.prev;
+  }
+
+  counted_vector<counted_vector<node, Tag>, Tag> chunks;
+  handle head;
+  handle tail;
+  handle free_list;
+  // Nodes handed out of the chunks so far, free or not.
+  handle used;
+  size_t count;
+};
+
+template <typename T, mem_tag Tag>
+const typename pool_lru<T, Tag>::handle pool_lru<T, Tag>::NONE;
+
+#endif
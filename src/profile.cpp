@@ -0,0 +1,76 @@
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+
+#include "profile.h"
+
+namespace {
+
+const char *phase_names[PHASES] = {"request", "lookup",  "promote", "evict",
+                                   "clean",   "balance", "credits"};
+
+} // namespace
+
+latency_histogram::latency_histogram()
+    : counts{}, n{}, total{}, largest{}
+{
+}
+
+uint64_t latency_histogram::bucket_max(size_t b)
+{
+  if (b < SUB_BUCKETS)
+    return b;
+  const unsigned log = unsigned(b / SUB_BUCKETS) + SUB_BITS - 1;
+  const unsigned shift = log - SUB_BITS;
+  const uint64_t lowest = (SUB_BUCKETS + b % SUB_BUCKETS) << shift;
+  return lowest + ((uint64_t(1) << shift) - 1);
+}
+
+uint64_t latency_histogram::percentile(double q) const
+{
+  if (n == 0)
+    return 0;
+  const uint64_t rank =
+      std::max<uint64_t>(1, uint64_t(std::ceil(q * double(n))));
+  uint64_t seen = 0;
+  for (size_t b = 0; b < BUCKETS; ++b)
+  {
+    seen += counts[b];
+    if (seen >= rank)
+      return std::min(bucket_max(b), largest);
+  }
+  return largest;
+}
+
+profiler::profiler()
+    : histograms{}, start_ticks{profile_ticks()},
+      start_time{std::chrono::steady_clock::now()}
+{
+}
+
+void profiler::write(std::ostream &out) const
+{
+  const double ticks = double(profile_ticks() - start_ticks);
+  const double nanoseconds = double(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now() - start_time)
+          .count());
+  const double ns_per_tick = ticks > 0 ? nanoseconds / ticks : 1;
+
+  const std::streamsize precision = out.precision();
+  out << "phase count mean_ns p50_ns p99_ns p999_ns max_ns" << std::endl;
+  for (size_t p = 0; p < PHASES; ++p)
+  {
+    const latency_histogram &h = histograms[p];
+    if (h.count() == 0)
+      continue;
+    out << std::fixed << std::setprecision(1) << phase_names[p] << " "
+        << h.count() << " " << h.mean() * ns_per_tick << " "
+        << h.percentile(0.5) * ns_per_tick << " "
+        << h.percentile(0.99) * ns_per_tick << " "
+        << h.percentile(0.999) * ns_per_tick << " "
+        << h.max() * ns_per_tick << std::endl;
+  }
+  out.unsetf(std::ios::floatfield);
+  out.precision(precision);
+}
@@ -0,0 +1,150 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// Latency profile of a Policy (lsm-sim -y).
+//
+// The driver times every process_request() and Policies time the phases
+// inside it they expose (see phase below); each phase gets a histogram of
+// its durations, and write() prints count, mean, p50, p99, p999 and max of
+// each in nanoseconds. Phases nest inside the Request and may nest inside
+// each other (lsm's clean() runs inside its eviction), so their times don't
+// add up to the Request's.
+//
+// Durations are read from the time stamp counter, which costs some 20
+// cycles per read, and converted to nanoseconds with the counter's rate
+// over the whole run. Without a profiler a phase_timer only tests a null
+// pointer.
+
+enum class phase
+{
+  request, // the whole process_request()
+  lookup,  // hash table lookup of the Request's key
+  promote, // moving a hit to the front of its queue
+  evict,   // the eviction loop making room for a miss
+  clean,   // lsm::clean()
+  balance, // ripq::balance()
+  credits, // flashcache's credit and flashiness updates
+};
+
+static const size_t PHASES = size_t(phase::credits) + 1;
+
+// @return - the time stamp counter, or nanoseconds where there is none.
+inline uint64_t profile_ticks()
+{
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+#endif
+}
+
+// HDR-style histogram: exact below 2^SUB_BITS ticks, then 2^SUB_BITS
+// buckets per power of two, so a percentile is off by at most 1/16.
+class latency_histogram
+{
+public:
+  static const unsigned SUB_BITS = 4;
+  static const uint64_t SUB_BUCKETS = uint64_t(1) << SUB_BITS;
+  static const size_t BUCKETS = (64 - SUB_BITS + 1) * SUB_BUCKETS;
+
+  latency_histogram();
+
+  void record(uint64_t ticks)
+  {
+    ++counts[bucket(ticks)];
+    ++n;
+    total += ticks;
+    if (ticks > largest)
+      largest = ticks;
+  }
+
+  uint64_t count() const { return n; }
+  double mean() const { return n ? double(total) / n : 0; }
+  uint64_t max() const { return largest; }
+
+  // @return - the largest value of the bucket holding the sample of rank
+  //           ceil(q * count()); 0 if there are no samples.
+  uint64_t percentile(double q) const;
+
+private:
+  static size_t bucket(uint64_t ticks)
+  {
+    if (ticks < SUB_BUCKETS)
+      return ticks;
+    const unsigned log = 63 - __builtin_clzll(ticks);
+    return (log - SUB_BITS + 1) * SUB_BUCKETS +
+           ((ticks >> (log - SUB_BITS)) & (SUB_BUCKETS - 1));
+  }
+
+  // @return - the largest value that falls into bucket \a b.
+  static uint64_t bucket_max(size_t b);
+
+  uint64_t counts[BUCKETS];
+  uint64_t n;
+  uint64_t total;
+  uint64_t largest;
+};
+
+class profiler
+{
+public:
+  profiler();
+
+  void record(phase p, uint64_t ticks)
+  {
+    histograms[size_t(p)].record(ticks);
+  }
+
+  // Writes a line per phase that was recorded, in nanoseconds.
+  void write(std::ostream &out) const;
+
+private:
+  latency_histogram histograms[PHASES];
+
+  // Where the run started, to convert ticks to nanoseconds.
+  uint64_t start_ticks;
+  std::chrono::steady_clock::time_point start_time;
+};
+
+// Records the ticks from its construction to stop() (or its destruction)
+// as phase \a p of \a profile; does nothing if \a profile is null.
+class phase_timer
+{
+public:
+  phase_timer(profiler *profile, phase p)
+      : profile{profile}, p{p}, start{profile ? profile_ticks() : 0}
+  {
+  }
+
+  ~phase_timer() { stop(); }
+
+  void stop()
+  {
+    if (profile)
+    {
+      profile->record(p, profile_ticks() - start);
+      profile = nullptr;
+    }
+  }
+
+private:
+  profiler *profile;
+  phase p;
+  uint64_t start;
+
+  phase_timer(const phase_timer &) = delete;
+  phase_timer &operator=(const phase_timer &) = delete;
+};
+
+#endif
@@ -3,16 +3,16 @@
 #include <fstream>
 #include "ram_shield.h"
 
-size_t blockSize = 1048576;
-double allocation_threshold = 1;
+static const size_t blockSize = 1048576;
+static const double allocation_threshold = 1;
 
-RamShield::RamShield(stats stat, size_t block_size) : FlashCache(stat),
+RamShield::RamShield(stats stat, size_t block_size) : FlashCache(stat, 0),
 													  flash{},
 													  allObjects{},
 													  maxBlocks{},
 													  numBlocks{}
 {
-	maxBlocks = FLASH_SIZE / block_size; // 块数量
+	maxBlocks = stat.config.flash_size / block_size; // 块数量
 }
 
 RamShield::~RamShield() {}
@@ -27,7 +27,7 @@ size_t RamShield::proc(const Request *r, bool warmup)
 
 	double currTime = r->time;
 
-	assert(dramSize + flashSize <= DRAM_SIZE + FLASH_SIZE * stat.threshold);
+	assert(dramSize + flashSize <= stat.config.dram_size + stat.config.flash_size * stat.threshold);
 	auto searchRKId = allObjects.find(r->kid);
 	if (searchRKId != allObjects.end()) // 请求对象存在
 	{
@@ -85,7 +85,7 @@ size_t RamShield::proc(const Request *r, bool warmup)
 					item.flashIt->size += item.size;
 					flashSize += item.size;
 					// 若总空间大小超过阈值，驱逐全局lru末尾对象
-					while (dramSize + flashSize > DRAM_SIZE + FLASH_SIZE * stat.threshold)
+					while (dramSize + flashSize > stat.config.dram_size + stat.config.flash_size * stat.threshold)
 					{
 						// 全局lru队列中最后一个对象
 						uint32_t globalLruKid = globalLru.back();
@@ -94,7 +94,7 @@ size_t RamShield::proc(const Request *r, bool warmup)
 						// 驱逐对象
 						evict_item(victimItem, warmup);
 					}
-					assert(dramSize + flashSize <= DRAM_SIZE + FLASH_SIZE * stat.threshold);
+					assert(dramSize + flashSize <= stat.config.dram_size + stat.config.flash_size * stat.threshold);
 				}
 			}
 			item.lastAccessInTrace = counter; // 更新逻辑时间戳
@@ -127,12 +127,12 @@ size_t RamShield::proc(const Request *r, bool warmup)
 	 */
 	// 插入新对象/更新重插入对象
 	RamShield::RItem newItem(r, counter);
-	assert(((unsigned int)newItem.size) <= DRAM_SIZE);
-	assert(dramSize + flashSize <= DRAM_SIZE + FLASH_SIZE * stat.threshold);
+	assert(((unsigned int)newItem.size) <= stat.config.dram_size);
+	assert(dramSize + flashSize <= stat.config.dram_size + stat.config.flash_size * stat.threshold);
 	while (true)
 	{
 		// 若DRAM空间足够，且总空间大小不超过阈值，直接插入到DRAM中
-		if ((newItem.size + dramSize <= DRAM_SIZE) && (dramSize + flashSize + newItem.size <= DRAM_SIZE + FLASH_SIZE * stat.threshold))
+		if ((newItem.size + dramSize <= stat.config.dram_size) && (dramSize + flashSize + newItem.size <= stat.config.dram_size + stat.config.flash_size * stat.threshold))
 		{
 			// 将对象插入到DRAM中
 			add_item(newItem);
@@ -142,20 +142,20 @@ size_t RamShield::proc(const Request *r, bool warmup)
 		// Not enough space in DRAM, check flash
 		assert(numBlocks <= maxBlocks);
 		// 若无法直接插入dram,首先检查总空间大小是否超过阈值，若超过，驱逐全局lru末尾对象
-		if ((dramSize + flashSize + newItem.size) > DRAM_SIZE + FLASH_SIZE * stat.threshold)
+		if ((dramSize + flashSize + newItem.size) > stat.config.dram_size + stat.config.flash_size * stat.threshold)
 		{
 			uint32_t globalLruKid = globalLru.back();
 			RamShield::RItem &victimItem = allObjects[globalLruKid];
 			assert(victimItem.size > 0);
 			// 驱逐对象
 			evict_item(victimItem, warmup);
-			assert(dramSize + flashSize <= DRAM_SIZE + FLASH_SIZE * stat.threshold);
+			assert(dramSize + flashSize <= stat.config.dram_size + stat.config.flash_size * stat.threshold);
 		}
 		else if (numBlocks < maxBlocks) // dram空间不足但总空间大小未超过阈值，且flash块数量未达到最大值
 		{
 			// 分配新块，将dram中flashiness最大的对象迁移到新块中，直到新块满且空间利用率高于阈值
 			allocate_flash_block(warmup);
-			assert(dramSize + flashSize <= DRAM_SIZE + FLASH_SIZE * stat.threshold);
+			assert(dramSize + flashSize <= stat.config.dram_size + stat.config.flash_size * stat.threshold);
 		}
 		else
 		{
@@ -204,7 +204,7 @@ void RamShield::evict_item(RamShield::RItem &victimItem, bool warmup /*uint32_t
 		// 若块的空间利用率低于阈值，对块进行GC
 		if ((curr_block->size / (double)stat.block_size) < stat.threshold)
 		{
-			assert(dramSize <= DRAM_SIZE);
+			assert(dramSize <= stat.config.dram_size);
 			// 对块进行GC,有效对象迁移到DRAM中
 			evict_block(curr_block);
 			// 重新分配新块，将dram中flashiness最大的对象迁移到新块中，直到新块满且空间利用率高于阈值
@@ -237,15 +237,15 @@ void RamShield::evict_block(blockIt victim_block)
 		}
 	}
 	// 从flash中删除块
-	flash.erase(victim_block);
 	flashSize -= victim_block->size;
+	flash.erase(victim_block);
 	numBlocks--;
 	assert(numBlocks == flash.size());
 }
 
 void RamShield::allocate_flash_block(bool warmup)
 {
-	assert(flashSize <= FLASH_SIZE);
+	assert(flashSize <= stat.config.flash_size);
 
 	flash.emplace_front(); // 在flash头部插入新块
 	RamShield::Block &curr_block = flash.front();
@@ -291,7 +291,7 @@ void RamShield::allocate_flash_block(bool warmup)
 	numBlocks++;
 	flashSize += curr_block.size;
 	assert(numBlocks <= maxBlocks);
-	assert(flashSize <= FLASH_SIZE);
+	assert(flashSize <= stat.config.flash_size);
 
 	if (!warmup)
 	{
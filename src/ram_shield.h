@@ -11,9 +11,14 @@
 
 class RamShield : public FlashCache
 {
+public:
+	// Blocks and ghosts aren't part of what FlashCache::save() writes.
+	bool can_checkpoint() const { return false; }
+
 protected:
 	struct Block;
-	typedef std::list<Block>::iterator blockIt;
+	typedef counted_list<Block, mem_tag::flash_blocks> block_list;
+	typedef block_list::iterator blockIt;
 
 	struct RItem : public FlashCache::Item // 请求对象
 	{
@@ -34,12 +39,12 @@ protected:
 	struct Block
 	{
 		size_t size;
-		std::list<uint32_t> items; // block中的对象列表
+		counted_list<uint32_t, mem_tag::flash_blocks> items; // block中的对象列表
 		Block() : size{}, items{} {}
 	};
 
-	std::list<Block> flash; // flash中的块列表
-	std::unordered_map<uint32_t, RItem> allObjects;
+	block_list flash; // flash中的块列表
+	counted_unordered_map<uint32_t, RItem, mem_tag::hash_index> allObjects;
 	size_t maxBlocks;
 	size_t numBlocks;
 	void add_item(RItem &newItem);
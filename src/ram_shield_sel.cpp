@@ -19,7 +19,7 @@ size_t RamShield_sel::proc(const Request *r, bool warmup)
 
 	double currTime = r->time;
 
-	assert(dramSize + flashSize <= DRAM_SIZE + FLASH_SIZE * stat.threshold);
+	assert(dramSize + flashSize <= stat.config.dram_size + stat.config.flash_size * stat.threshold);
 	auto searchRKId = allObjects.find(r->kid);
 	if (searchRKId != allObjects.end()) // 请求对象存在
 	{
@@ -74,14 +74,14 @@ size_t RamShield_sel::proc(const Request *r, bool warmup)
 					item.flashIt->size += item.size;
 					flashSize += item.size;
 					// 若总空间超过阈值，进行驱逐
-					while (dramSize + flashSize > DRAM_SIZE + FLASH_SIZE * stat.threshold)
+					while (dramSize + flashSize > stat.config.dram_size + stat.config.flash_size * stat.threshold)
 					{
 						uint32_t globalLruKid = globalLru.back();
 						RamShield::RItem &victimItem = allObjects[globalLruKid];
 						assert(victimItem.size > 0);
 						evict_item(victimItem, warmup);
 					}
-					assert(dramSize + flashSize <= DRAM_SIZE + FLASH_SIZE * stat.threshold);
+					assert(dramSize + flashSize <= stat.config.dram_size + stat.config.flash_size * stat.threshold);
 				}
 			}
 			item.lastAccessInTrace = counter;
@@ -114,29 +114,29 @@ size_t RamShield_sel::proc(const Request *r, bool warmup)
 	 */
 	// 插入新对象/更新重插入对象
 	RamShield::RItem newItem(r, counter);
-	assert(((unsigned int)newItem.size) <= DRAM_SIZE);
-	assert(dramSize + flashSize <= DRAM_SIZE + FLASH_SIZE * stat.threshold);
+	assert(((unsigned int)newItem.size) <= stat.config.dram_size);
+	assert(dramSize + flashSize <= stat.config.dram_size + stat.config.flash_size * stat.threshold);
 	while (true)
 	{
 		// 若DRAM空间足够，且总空间大小不超过阈值，直接插入到DRAM中
-		if (newItem.size + dramSize <= DRAM_SIZE && (dramSize + flashSize + newItem.size <= DRAM_SIZE + FLASH_SIZE * stat.threshold))
+		if (newItem.size + dramSize <= stat.config.dram_size && (dramSize + flashSize + newItem.size <= stat.config.dram_size + stat.config.flash_size * stat.threshold))
 		{
 			add_item(newItem);
-			assert(dramSize + flashSize <= DRAM_SIZE + FLASH_SIZE * stat.threshold);
+			assert(dramSize + flashSize <= stat.config.dram_size + stat.config.flash_size * stat.threshold);
 			return PROC_MISS;
 		}
 
 		// Not enough space in DRAM
 		assert(numBlocks <= maxBlocks);
 		// 若无法直接插入dram,首先检查总空间大小是否超过阈值，若超过，驱逐全局lru末尾对象
-		if ((dramSize + flashSize + newItem.size) > DRAM_SIZE + FLASH_SIZE * stat.threshold)
+		if ((dramSize + flashSize + newItem.size) > stat.config.dram_size + stat.config.flash_size * stat.threshold)
 		{
 			uint32_t globalLruKid = globalLru.back();
 			RamShield::RItem &victimItem = allObjects[globalLruKid];
 			assert(victimItem.size > 0);
 			// 驱逐对象
 			evict_item(victimItem, warmup);
-			assert(dramSize + flashSize <= DRAM_SIZE + FLASH_SIZE * stat.threshold);
+			assert(dramSize + flashSize <= stat.config.dram_size + stat.config.flash_size * stat.threshold);
 		}
 		else if (numBlocks == maxBlocks) // dram空间不足但总空间大小未超过阈值，且flash块数量达到最大值
 		{
@@ -149,15 +149,15 @@ size_t RamShield_sel::proc(const Request *r, bool warmup)
 			}
 			assert(victim_block != flash.end());
 			evict_block(victim_block);
-			assert(dramSize + flashSize <= DRAM_SIZE + FLASH_SIZE * stat.threshold);
+			assert(dramSize + flashSize <= stat.config.dram_size + stat.config.flash_size * stat.threshold);
 		}
 		else if (numBlocks < maxBlocks) // dram空间不足但总空间大小未超过阈值，且flash块数量未达到最大值
 		{
 			// 分配新块，将dram中flashiness最大的对象迁移到新块中，直到新块满且空间利用率高于阈值
 			allocate_flash_block(warmup);
-			assert(dramSize + flashSize <= DRAM_SIZE + FLASH_SIZE * stat.threshold);
+			assert(dramSize + flashSize <= stat.config.dram_size + stat.config.flash_size * stat.threshold);
 			assert(numBlocks <= maxBlocks);
-			assert(dramSize <= DRAM_SIZE);
+			assert(dramSize <= stat.config.dram_size);
 		}
 		else
 		{
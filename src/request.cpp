@@ -2,6 +2,7 @@
 #include <string>
 #include <stdexcept>
 #include <sstream>
+#include <cstdint>
 
 #include "common.h"
 #include "request.h"
@@ -9,6 +10,11 @@
 // #include "openssl/sha.h"
 #include <openssl/evp.h>
 
+Request::Request()
+    : time{}, key_sz{}, val_sz{}, frag_sz{}, kid{}, appid{}, type{}, hit{}
+{
+}
+
 // 请求结构体，支持读取csv并解析，以及生成哈希值
 Request::Request(const std::string &s)
     : time{}, key_sz{}, val_sz{}, frag_sz{}, kid{}, appid{}, type{}, hit{}
@@ -40,6 +46,122 @@ void Request::parse(const std::string &s)
   }
 }
 
+namespace
+{
+// Exact powers of ten representable as doubles.
+const double exact_pow10[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7,
+                              1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15,
+                              1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+inline bool is_digit(char c)
+{
+  return static_cast<unsigned char>(c - '0') < 10;
+}
+
+// Parses a plain decimal integer ("-?[0-9]+") at \a p the way std::stoi
+// would, advancing \a p past it. Returns false for anything stoi would treat
+// differently (signs other than '-', whitespace, overflow, ...).
+inline bool parse_int(const char *&p, const char *end, int *out)
+{
+  bool neg = false;
+  if (p != end && *p == '-')
+  {
+    neg = true;
+    ++p;
+  }
+  const char *digits = p;
+  int64_t v = 0;
+  while (p != end && is_digit(*p))
+  {
+    v = v * 10 + (*p - '0');
+    if (v > int64_t(INT32_MAX) + 1)
+      return false;
+    ++p;
+  }
+  if (p == digits)
+    return false;
+  v = neg ? -v : v;
+  if (v > INT32_MAX || v < INT32_MIN)
+    return false;
+  *out = int(v);
+  return true;
+}
+
+// Parses a plain decimal ("-?[0-9]*.?[0-9]*") at \a p, advancing \a p past
+// it. Only accepts values whose digits fit in a double's mantissa with at
+// most 22 fractional digits: both the mantissa and the power of ten are then
+// exact, so the single division rounds exactly like std::stod does.
+inline bool parse_time(const char *&p, const char *end, double *out)
+{
+  bool neg = false;
+  if (p != end && *p == '-')
+  {
+    neg = true;
+    ++p;
+  }
+  uint64_t mantissa = 0;
+  int frac_digits = 0;
+  bool any = false;
+  while (p != end && is_digit(*p))
+  {
+    mantissa = mantissa * 10 + (*p++ - '0');
+    if (mantissa > (uint64_t(1) << 53))
+      return false;
+    any = true;
+  }
+  if (p != end && *p == '.')
+  {
+    ++p;
+    while (p != end && is_digit(*p))
+    {
+      mantissa = mantissa * 10 + (*p++ - '0');
+      if (mantissa > (uint64_t(1) << 53) || ++frac_digits > 22)
+        return false;
+      any = true;
+    }
+  }
+  if (!any)
+    return false;
+  double v = double(mantissa) / exact_pow10[frac_digits];
+  *out = neg ? -v : v;
+  return true;
+}
+
+inline bool expect_comma(const char *&p, const char *end)
+{
+  if (p == end || *p != ',')
+    return false;
+  ++p;
+  return true;
+}
+} // namespace
+
+void Request::parse(const char *begin, const char *end)
+{
+  const char *p = begin;
+  int app = 0, t = 0, k = 0, v = 0, id = 0;
+  double ts = 0;
+
+  const bool ok = parse_time(p, end, &ts) && expect_comma(p, end) &&
+                  parse_int(p, end, &app) && expect_comma(p, end) &&
+                  parse_int(p, end, &t) && expect_comma(p, end) &&
+                  parse_int(p, end, &k) && expect_comma(p, end) &&
+                  parse_int(p, end, &v) && expect_comma(p, end) &&
+                  parse_int(p, end, &id) && (p == end || *p == ',');
+  if (!ok)
+  {
+    parse(std::string(begin, end));
+    return;
+  }
+
+  time = ts;
+  appid = app;
+  type = req_type(t);
+  key_sz = k;
+  val_sz = v;
+  kid = id;
+}
+
 // debug/check
 void Request::dump() const
 {
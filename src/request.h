@@ -8,8 +8,15 @@
 struct Request
 {
 
+  Request();
   Request(const std::string &s);
   void parse(const std::string &s);
+
+  // Populates this Request from the CSV line in [begin, end) (no newline)
+  // without allocating. Well-formed lines are parsed in place; anything
+  // unusual is handed to parse(const std::string &) so the results and error
+  // reporting are exactly those of the string path.
+  void parse(const char *begin, const char *end);
   void dump() const;
   int32_t size() const;
   int32_t get_frag() const;
@@ -1,11 +1,8 @@
 #include "ripq.h"
 
-static bool file_defined = false;
-static double lastRequest = 0;
-
 ripq::ripq(stats stat, size_t block_size, size_t num_sections, size_t flash_size)
     : Policy{stat}, sections{}, num_sections(num_sections),
-      section_size{}, warmup{}, map{}, out{}
+      section_size{}, warmup{}, map{stat.key_space}, last_request{}, out{}
 {
   assert(block_size);
   assert(num_sections && flash_size);
@@ -61,6 +58,7 @@ void ripq::add(const Request *r, int section_id)
     // 将段中的块进行迁移，保证段中的块不超过段的大小
     balance(section_id);
     // 若最后一个段中的块超过段的大小，则驱逐
+    phase_timer timer{profile.get(), phase::evict};
     while (sections[num_sections - 1]->filled_bytes > section_size)
     {
       evict();
@@ -90,6 +88,7 @@ void ripq::add_virtual(item_ptr it, int section_id)
     // 块重平衡
     balance(section_id);
     // 最后一个段进行块驱逐
+    phase_timer timer{profile.get(), phase::evict};
     while (sections[num_sections - 1]->filled_bytes > section_size)
     {
       evict();
@@ -99,6 +98,7 @@ void ripq::add_virtual(item_ptr it, int section_id)
 
 void ripq::balance(int start)
 {
+  phase_timer timer{profile.get(), phase::balance};
   // 遍历段，对超出容量限制的段中的块进行迁移
   for (uint32_t i = start; i < num_sections - 1; i++)
   {
@@ -203,18 +203,20 @@ void ripq::evict()
 size_t ripq::process_request(const Request *r, bool warmup)
 {
   assert(r->size() > 0);
-  lastRequest = r->time;
+  last_request = r->time;
   this->warmup = warmup;
   if (!warmup)
     ++stat.accesses;
 
   // 查找请求对应的item
+  phase_timer lookup{profile.get(), phase::lookup};
   auto it = map.find(r->kid);
+  lookup.stop();
 
-  if (it != map.end()) // 找到了
+  if (it) // 找到了
   {
     // 请求对应的item
-    auto item_it = it->second;
+    auto item_it = *it;
 
     // 若请求大小和item大小相同，即不需要更新
     if (item_it->req.size() == r->size())
@@ -291,7 +293,9 @@ ripq::item_ptr ripq::block::add(const Request *req)
   filled_bytes += req->size();
   // 块中的对象总数
   num_items++;
-  item_ptr new_item(new item(*req, shared_from_this())); // Items are added also to virtual sections for debug purposes
+  item_ptr new_item = std::allocate_shared<item>(
+      counting_allocator<item, mem_tag::flash_blocks>{}, *req,
+      shared_from_this()); // Items are added also to virtual sections for debug purposes
   // 当前对象加入到块对象列表头部
   items.push_front(new_item);
   return items.front();
@@ -328,7 +332,9 @@ void ripq::section::seal_phy_block()
 {
   active_phy_block->active = false;
   filled_bytes += active_phy_block->filled_bytes; // We count the block filled bytes only when it becomes sealed
-  block_ptr new_phy_block(new block(shared_from_this(), false));
+  block_ptr new_phy_block = std::allocate_shared<block>(
+      counting_allocator<block, mem_tag::flash_blocks>{}, shared_from_this(),
+      false);
   blocks.push_front(active_phy_block);
   active_phy_block = new_phy_block;
 }
@@ -337,7 +343,9 @@ void ripq::section::seal_phy_block()
 void ripq::section::seal_vir_block()
 {
   active_vir_block->active = false;
-  block_ptr new_vir_block(new block(shared_from_this(), true));
+  block_ptr new_vir_block = std::allocate_shared<block>(
+      counting_allocator<block, mem_tag::flash_blocks>{}, shared_from_this(),
+      true);
   filled_bytes += active_vir_block->filled_bytes;
   blocks.push_front(active_vir_block);
   active_vir_block = new_vir_block;
@@ -394,12 +402,11 @@ ripq::block_ptr ripq::section::evict_block()
 void ripq::dump_stats(void)
 {
   std::string filename{stat.policy + "-block_size" + std::to_string(stat.block_size) + "-flash_size" + std::to_string(stat.flash_size) + "-num_sections" + std::to_string(stat.num_sections)};
-  if (!file_defined)
+  if (!out.is_open())
   {
     out.open(filename);
-    file_defined = true;
   }
-  out << "Last Request was at :" << lastRequest << std::endl;
+  out << "Last Request was at :" << last_request << std::endl;
   stat.dump(out);
   out << std::endl;
 }
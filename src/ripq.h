@@ -1,15 +1,18 @@
 #include <unordered_map>
 #include <list>
 #include <memory>
+#include <atomic>
 #include <boost/enable_shared_from_this.hpp>
 
+#include "key_map.h"
+#include "mem_usage.h"
 #include "policy.h"
 #include "common.h"
 
 #ifndef RIPQ_H
 #define RIPQ_H
 
-static int global_bid; // Used for debugging
+static std::atomic<int> global_bid; // Used for debugging
 
 class ripq : public Policy
 {
@@ -22,11 +25,11 @@ protected:
   typedef std::shared_ptr<item> item_ptr;
   typedef std::shared_ptr<section> section_ptr;
 
-  typedef std::list<block_ptr> block_list;
-  typedef std::list<item_ptr> item_list;
+  typedef counted_list<block_ptr, mem_tag::flash_blocks> block_list;
+  typedef counted_list<item_ptr, mem_tag::flash_blocks> item_list;
   typedef std::vector<section_ptr> section_vector;
 
-  typedef std::unordered_map<uint32_t, item_ptr> hash_map;
+  typedef key_map<item_ptr> hash_map;
 
   section_vector sections;
   size_t num_sections;
@@ -161,6 +164,7 @@ protected:
   };
 
 private:
+  double last_request;
   std::ofstream out;
 
 public:
@@ -205,11 +205,11 @@ size_t ripq_shield::proc(const Request *r, bool warmup)
   }
   // flash中查找
   auto it_flash = map.find(r->kid);
-  if (it_flash != map.end())
+  if (it_flash)
   {
     // dram和flash中只会存在一个
     assert(it_dram == dram_map.end());
-    item_it = std::static_pointer_cast<item>(it_flash->second);
+    item_it = std::static_pointer_cast<item>(*it_flash);
     assert(!item_it->in_dram);
   }
 
@@ -3,12 +3,16 @@
 #include "shadowlru.h"
 
 shadowlru::shadowlru()
-    : Policy{{"", {}, 0}}, class_size{}, size_curve{}, queue{}, part_of_slab_allocator{true}
+    : Policy{{"", {}, 0}}, class_size{}, size_curve{}, object_curve{}, queue{},
+      part_of_slab_allocator{true}, sampler{}, model{}
 {
 }
 
 shadowlru::shadowlru(const stats &stat)
-    : Policy{stat}, class_size{}, size_curve{}, queue{}, part_of_slab_allocator{false}
+    : Policy{stat}, class_size{}, size_curve{}, object_curve{},
+      queue{stat.sample_rate < 1 || stat.sample_keys ? 0 : stat.key_space},
+      part_of_slab_allocator{false},
+      sampler{stat.sample_rate, stat.sample_keys}, model{}
 {
 }
 
@@ -20,21 +24,21 @@ shadowlru::~shadowlru()
 // distance in the chain (bytes).
 size_t shadowlru::remove(const Request *r)
 {
+  return remove(r->kid);
+}
 
-  // Sum the sizes of all Requests up until we reach 'r'.
-  size_t stack_dist = 0;
-
-  auto it = queue.begin();
-  while (it++ != queue.end())
+size_t shadowlru::remove(uint32_t kid)
+{
+  if (stat.use_aet)
   {
-    if (it->kid == r->kid)
-    {
-      stat.bytes_cached -= it->size();
-      queue.erase(it);
-      break;
-    }
-    stack_dist += it->size();
+    model.remove(kid);
+    return 0;
   }
+
+  // Sum the sizes of all Requests up until we reach 'r'.
+  const size_t bytes = queue.bytes();
+  const size_t stack_dist = queue.remove(kid);
+  stat.bytes_cached -= bytes - queue.bytes();
   return stack_dist;
 }
 
@@ -42,23 +46,42 @@ size_t shadowlru::process_request(const Request *r, bool warmup)
 {
   assert(r->size() > 0);
 
+  // 空间采样：只模拟被采样的键，距离按采样率放大
+  if (!warmup)
+    sampler.seen();
+  if (!sampler.sample(r->kid) ||
+      !sampler.admit(r->kid, [this](uint32_t kid) { remove(kid); }))
+  {
+    model.skip();
+    return PROC_MISS;
+  }
+
+  // 累计重用距离：从队列头部到目标请求(含)的字节数，未找到时为整个队列的字节数
+  // The distance counts from PROC_MISS, so it is one less than these bytes
+  // and only stays PROC_MISS for the very first request.
   size_t size_distance = PROC_MISS;
-  // 遍历链表，累计重用距离，若找到目标请求，删除并退出循环
-  for (auto it = queue.begin(); it != queue.end(); ++it)
+  size_t object_distance = PROC_MISS;
+  if (stat.use_aet)
   {
-    Request &item = *it;
-    // 累计重用距离
-    size_distance += item.size();
-    if (item.kid == r->kid)
-    {
-      stat.bytes_cached -= item.size();
-      queue.erase(it);
-      break;
-    }
+    const size_t bytes = model.bytes();
+    const size_t objects = model.keys();
+    // Reuses become hits in log_curves(), once the model is complete.
+    if (model.access(r->kid, r->size(), sampler.weight(), warmup))
+      return 0;
+    size_distance += sampler.scale(bytes);
+    object_distance += sampler.scale(objects);
+  }
+  else
+  {
+    const size_t bytes = queue.bytes();
+    const size_t objects = queue.size();
+    // 插入到队列头部
+    const stack_distance::distance depth =
+        queue.touch(r->kid, r->size(), r->frag_sz);
+    size_distance += sampler.scale(depth.bytes ? depth.bytes : bytes);
+    object_distance += sampler.scale(depth.objects ? depth.objects : objects);
+    stat.bytes_cached += queue.bytes() - bytes;
   }
-  // 插入到链表头部
-  stat.bytes_cached += r->size();
-  queue.emplace_front(*r);
 
   if (!warmup)
   {
@@ -66,12 +89,16 @@ size_t shadowlru::process_request(const Request *r, bool warmup)
     if (size_distance != PROC_MISS)
     {
       if (!part_of_slab_allocator)
-        size_curve.hit(size_distance);
+      {
+        size_curve.hit(size_distance, sampler.weight());
+        object_curve.hit(object_distance, sampler.weight());
+      }
     }
     else
     {
       // Compulsory miss must have come before this new get hit.
-      size_curve.miss();
+      size_curve.miss(sampler.weight());
+      object_curve.miss(sampler.weight());
     }
   }
 
@@ -92,13 +119,12 @@ std::vector<size_t> shadowlru::get_class_frags(size_t slab_size) const
   size_t page_dist = 0, frag_sum = 0;
   std::vector<size_t> frags{};
   // 遍历lru队列
-  for (const Request &r : queue)
-  {
+  queue.for_each([&](int32_t size, int32_t frag) {
     // If within the current page just sum.
     // otherwise record OH for this page and reset sums
     // to reflect sums at first element of new page.
     // 若当前累计的请求大小超过了一个最大slab大小，则记录一个slab中请求的碎片大小
-    if (page_dist + r.size() > slab_size)
+    if (page_dist + size > slab_size)
     {
       // 记录每个slab中请求的碎片大小
       frags.push_back(frag_sum);
@@ -106,10 +132,10 @@ std::vector<size_t> shadowlru::get_class_frags(size_t slab_size) const
       frag_sum = 0;
     }
     // 累计请求大小
-    page_dist += r.size();
+    page_dist += size;
     // 当前请求在其slab class下的碎片大小
-    frag_sum += r.get_frag();
-  }
+    frag_sum += frag;
+  });
 
   // Make sure to count possible final incomlete page missed above.
   // 记录最后一个slab中请求的碎片大小
@@ -128,5 +154,10 @@ void shadowlru::log_curves()
     app_ids += std::to_string(a);
 
   std::string filename_suffix{"-app" + app_ids + (stat.memcachier_classes ? "-memcachier" : "-memcached")};
+  if (stat.use_aet)
+    model.fill(size_curve, object_curve);
+  sampler.adjust(size_curve);
+  sampler.adjust(object_curve);
   size_curve.dump_cdf("shadowlru-size-curve" + filename_suffix + ".data");
+  object_curve.dump_cdf("shadowlru-object-curve" + filename_suffix + ".data");
 }
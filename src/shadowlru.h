@@ -1,10 +1,11 @@
 #ifndef SHADOWLRU_H
 #define SHADOWLRU_H
 
-#include <list>
-
+#include "aet.h"
 #include "hit_rate_curve.h"
 #include "policy.h"
+#include "shards.h"
+#include "stack_distance.h"
 
 // Policy derived from Cliffhanger paper
 class shadowlru : public Policy
@@ -16,6 +17,7 @@ public:
 
   size_t process_request(const Request *r, bool warmup);
   size_t remove(const Request *r);
+  size_t remove(uint32_t kid);
 
   size_t get_bytes_cached() const;
   std::vector<size_t> get_class_frags(size_t slab_size) const;
@@ -25,13 +27,24 @@ public:
     return &size_curve;
   }
 
+  const hit_rate_curve *get_object_curve() const
+  {
+    return &object_curve;
+  }
+
   void log_curves();
 
 private:
   size_t class_size;
   hit_rate_curve size_curve;
-  std::list<Request> queue;
+  // Distances in objects instead of bytes.
+  hit_rate_curve object_curve;
+  stack_distance queue;
   bool part_of_slab_allocator;
+  // Keys simulated; a slab allocator samples for its classes itself.
+  shards sampler;
+  // With stat.use_aet, models the curve instead of the queue.
+  aet model;
 };
 
 #endif
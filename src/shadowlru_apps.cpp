@@ -0,0 +1,49 @@
+#include <cassert>
+
+#include "shadowlru_apps.h"
+
+shadowlru_apps::shadowlru_apps(const stats &stat)
+    : Policy{stat}, apps{}
+{
+}
+
+shadowlru_apps::~shadowlru_apps()
+{
+}
+
+size_t shadowlru_apps::process_request(const Request *r, bool warmup)
+{
+  assert(r->size() > 0);
+
+  if (!warmup)
+    ++stat.accesses;
+
+  app &a = apps[r->appid];
+  if (!a.lru)
+  {
+    a.ids.insert(r->appid);
+    stats app_stat{stat};
+    app_stat.apps = &a.ids;
+    app_stat.accesses = 0;
+    // Each app only sees some of the kids; a dense index per app would
+    // take the whole key space many times over.
+    app_stat.key_space = 0;
+    a.lru.reset(new shadowlru(app_stat));
+  }
+
+  const size_t bytes = a.lru->get_bytes_cached();
+  const size_t size_distance = a.lru->process_request(r, warmup);
+  stat.bytes_cached += a.lru->get_bytes_cached() - bytes;
+  return size_distance;
+}
+
+size_t shadowlru_apps::get_bytes_cached() const
+{
+  return stat.bytes_cached;
+}
+
+void shadowlru_apps::log_curves()
+{
+  for (auto &a : apps)
+    a.second.lru->log_curves();
+}
@@ -0,0 +1,38 @@
+#ifndef SHADOWLRU_APPS_H
+#define SHADOWLRU_APPS_H
+
+#include <map>
+#include <memory>
+#include <set>
+
+#include "policy.h"
+#include "shadowlru.h"
+
+// A shadowlru per application, so that one pass over a trace gives the
+// curves of every app in it. Requests are handed to the shadowlru of their
+// appid, created on its first Request with the parameters of this one, and
+// each writes its curves as a run of shadowlru with -a for its app alone
+// would.
+class shadowlru_apps : public Policy
+{
+public:
+  shadowlru_apps(const stats &stat);
+  ~shadowlru_apps();
+
+  size_t process_request(const Request *r, bool warmup);
+  size_t get_bytes_cached() const;
+  void log_curves();
+
+private:
+  struct app
+  {
+    // What the shadowlru's stats point to as its apps.
+    std::set<uint32_t> ids{};
+    std::unique_ptr<shadowlru> lru{};
+  };
+
+  // By appid; map nodes stay put, so the ids do as well.
+  std::map<uint32_t, app> apps;
+};
+
+#endif
@@ -0,0 +1,217 @@
+#include <algorithm>
+#include <cassert>
+
+#include "shadowlru_parallel.h"
+
+namespace {
+
+// Requests per chunk: the first Requests of keys, merged on one thread, are
+// a smaller share of larger chunks, while two banks of them are held at
+// once.
+const size_t CHUNK_REQUESTS = 1 << 17;
+
+} // namespace
+
+const size_t shadowlru_parallel::NONE;
+
+shadowlru_parallel::shadowlru_parallel(const stats &stat, size_t threads)
+    : Policy{stat},
+      threads{threads ? threads
+                      : std::max(1u, std::thread::hardware_concurrency())},
+      chunks{}, filling{}, filling_chunk{}, unmerged{NONE},
+      queue{stat.key_space}, size_curve{}, object_curve{}, mutex{}, started{},
+      finished{}, round{}, running{}, done{}, stopping{}, workers{}
+{
+  for (size_t i = 0; i < 2 * this->threads; ++i)
+  {
+    chunks.emplace_back(new chunk{});
+    chunks.back()->accesses.reserve(CHUNK_REQUESTS);
+  }
+  for (size_t t = 0; t < this->threads; ++t)
+    workers.emplace_back([this, t] { work(t); });
+}
+
+shadowlru_parallel::~shadowlru_parallel()
+{
+  {
+    std::lock_guard<std::mutex> lock{mutex};
+    stopping = true;
+  }
+  started.notify_all();
+  for (std::thread &worker : workers)
+    worker.join();
+}
+
+size_t shadowlru_parallel::process_request(const Request *r, bool warmup)
+{
+  assert(r->size() > 0);
+  add(r->kid, r->size(), r->frag_sz, warmup);
+  return PROC_MISS;
+}
+
+void shadowlru_parallel::process_batch(const Request *begin, size_t n,
+                                       bool warmup)
+{
+  for (size_t i = 0; i < n; ++i)
+  {
+    assert(begin[i].size() > 0);
+    add(begin[i].kid, begin[i].size(), begin[i].frag_sz, warmup);
+  }
+}
+
+void shadowlru_parallel::add(uint32_t kid, int32_t size, int32_t frag,
+                             bool warmup)
+{
+  chunk &c = at(filling, filling_chunk);
+  c.accesses.push_back(access{kid, size, frag, warmup});
+  if (c.accesses.size() < CHUNK_REQUESTS)
+    return;
+  if (++filling_chunk == threads)
+    flip();
+}
+
+void shadowlru_parallel::flip()
+{
+  wait();
+  {
+    std::lock_guard<std::mutex> lock{mutex};
+    running = filling;
+    done = 0;
+    ++round;
+  }
+  started.notify_all();
+
+  // The chunks handed over before are older, so they go first.
+  if (unmerged != NONE)
+    merge(unmerged);
+  unmerged = filling;
+  filling ^= 1;
+  filling_chunk = 0;
+}
+
+void shadowlru_parallel::wait()
+{
+  if (unmerged == NONE)
+    return;
+  std::unique_lock<std::mutex> lock{mutex};
+  finished.wait(lock, [this] { return done == threads; });
+}
+
+void shadowlru_parallel::merge(size_t bank)
+{
+  for (size_t t = 0; t < threads; ++t)
+  {
+    chunk &c = at(bank, t);
+    for (const first_access &f : c.firsts)
+    {
+      size_t bytes = f.bytes;
+      size_t objects = f.objects;
+      const stack_distance::distance depth = queue.depth(f.kid);
+      if (depth.bytes)
+      {
+        bytes += depth.bytes;
+        objects += depth.objects;
+        queue.remove(f.kid);
+      }
+      else
+      {
+        bytes += queue.bytes();
+        objects += queue.size();
+      }
+
+      if (f.warmup)
+        continue;
+      // Distances count from PROC_MISS as in shadowlru.
+      if (bytes)
+      {
+        size_curve.hit(bytes - 1);
+        object_curve.hit(objects - 1);
+      }
+      else
+      {
+        size_curve.miss();
+        object_curve.miss();
+      }
+    }
+    queue.append(c.local);
+    size_curve.merge(c.size_curve);
+    object_curve.merge(c.object_curve);
+
+    c.accesses.clear();
+    c.firsts.clear();
+    c.local = stack_distance{};
+    c.size_curve = hit_rate_curve{};
+    c.object_curve = hit_rate_curve{};
+  }
+  stat.bytes_cached = queue.bytes();
+}
+
+void shadowlru_parallel::work(size_t thread)
+{
+  uint64_t seen = 0;
+  for (;;)
+  {
+    size_t bank = 0;
+    {
+      std::unique_lock<std::mutex> lock{mutex};
+      started.wait(lock, [&] { return stopping || round != seen; });
+      if (stopping)
+        return;
+      seen = round;
+      bank = running;
+    }
+
+    compute(at(bank, thread));
+
+    {
+      std::lock_guard<std::mutex> lock{mutex};
+      ++done;
+    }
+    finished.notify_one();
+  }
+}
+
+void shadowlru_parallel::compute(chunk &c)
+{
+  for (const access &a : c.accesses)
+  {
+    const size_t bytes = c.local.bytes();
+    const size_t objects = c.local.size();
+    const stack_distance::distance depth =
+        c.local.touch(a.kid, a.size, a.frag);
+    if (!depth.bytes)
+      c.firsts.push_back(first_access{a.kid, a.warmup, bytes, objects});
+    else if (!a.warmup)
+    {
+      c.size_curve.hit(depth.bytes - 1);
+      c.object_curve.hit(depth.objects - 1);
+    }
+  }
+}
+
+size_t shadowlru_parallel::get_bytes_cached() const
+{
+  return stat.bytes_cached;
+}
+
+void shadowlru_parallel::log_curves()
+{
+  if (filling_chunk != 0 || !at(filling, 0).accesses.empty())
+    flip();
+  wait();
+  if (unmerged != NONE)
+  {
+    merge(unmerged);
+    unmerged = NONE;
+  }
+
+  std::string app_ids = "";
+
+  for (auto &a : *stat.apps)
+    app_ids += std::to_string(a);
+
+  // Named as the curves of shadowlru, which these are.
+  std::string filename_suffix{"-app" + app_ids + (stat.memcachier_classes ? "-memcachier" : "-memcached")};
+  size_curve.dump_cdf("shadowlru-size-curve" + filename_suffix + ".data");
+  object_curve.dump_cdf("shadowlru-object-curve" + filename_suffix + ".data");
+}
@@ -0,0 +1,115 @@
+#ifndef SHADOWLRU_PARALLEL_H
+#define SHADOWLRU_PARALLEL_H
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "hit_rate_curve.h"
+#include "policy.h"
+#include "stack_distance.h"
+
+// The exact curves of shadowlru, with the stack distances computed on
+// several threads.
+//
+// Requests are split into chunks, one per thread, and each thread runs a
+// stack of its own over its chunk. A key requested earlier in the same
+// chunk gets its distance from that stack alone, as everything in front of
+// it was requested in the chunk too. A key's first Request in the chunk
+// only knows the bytes of the keys requested before it in the chunk; the
+// rest lies in the stack of all earlier chunks. Merging the chunks in order
+// corrects those Requests: each one adds the depth of its key in the global
+// stack, and then takes the key out, so that a key is never counted twice.
+// The keys of the chunk then go in front of the global stack in the order
+// of its own.
+//
+// Only the first Request of each key in a chunk is merged on one thread, so
+// the larger the chunks and the more their keys repeat, the better it
+// scales. The chunks of one round are merged while the threads work on the
+// next. The curves are exactly those of shadowlru, but a Request's
+// distance is only known once its chunk is merged, so process_request()
+// returns PROC_MISS, and get_bytes_cached() lags behind by up to two rounds.
+class shadowlru_parallel : public Policy
+{
+public:
+  // @param threads - threads computing distances; 0 for one per core.
+  shadowlru_parallel(const stats &stat, size_t threads);
+  ~shadowlru_parallel();
+
+  size_t process_request(const Request *r, bool warmup);
+  void process_batch(const Request *begin, size_t n, bool warmup);
+
+  size_t get_bytes_cached() const;
+  void log_curves();
+
+private:
+  struct access
+  {
+    uint32_t kid;
+    int32_t size;
+    int32_t frag;
+    bool warmup;
+  };
+
+  // The first Request of a key in a chunk, with the bytes and objects of
+  // the keys requested before it in the chunk.
+  struct first_access
+  {
+    uint32_t kid;
+    bool warmup;
+    size_t bytes;
+    size_t objects;
+  };
+
+  struct chunk
+  {
+    std::vector<access> accesses{};
+    stack_distance local{};
+    std::vector<first_access> firsts{};
+    // Hits of the keys requested earlier in the chunk.
+    hit_rate_curve size_curve{};
+    hit_rate_curve object_curve{};
+  };
+
+  void add(uint32_t kid, int32_t size, int32_t frag, bool warmup);
+  // Hands the chunks being filled to the threads and merges the ones they
+  // had before.
+  void flip();
+  // Waits for the chunks the threads were handed last.
+  void wait();
+  // Merges the chunks of \a bank into the global stack and the curves, and
+  // empties them.
+  void merge(size_t bank);
+  void work(size_t thread);
+  static void compute(chunk &c);
+
+  chunk &at(size_t bank, size_t thread) { return *chunks[bank * threads + thread]; }
+
+  size_t threads;
+  // Two banks of a chunk per thread: one filled while the threads work on
+  // the other.
+  std::vector<std::unique_ptr<chunk>> chunks;
+  size_t filling;
+  size_t filling_chunk;
+  // The bank handed to the threads that is not merged yet, or NONE.
+  size_t unmerged;
+  static const size_t NONE = ~size_t(0);
+
+  stack_distance queue;
+  hit_rate_curve size_curve;
+  hit_rate_curve object_curve;
+
+  std::mutex mutex;
+  std::condition_variable started;
+  std::condition_variable finished;
+  // Bumped whenever the threads are handed a bank.
+  uint64_t round;
+  size_t running;
+  size_t done;
+  bool stopping;
+  std::vector<std::thread> workers;
+};
+
+#endif
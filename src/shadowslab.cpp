@@ -8,7 +8,8 @@
 #include "common.h"
 
 shadowslab::shadowslab(stats stat)
-    : Policy{stat}, slabs{}, slabids{}, slab_for_key{}, next_slabid{0}, size_curve{}, slab_count{}
+    : Policy{stat}, slabs{}, slabids{}, slab_for_key{}, next_slabid{0}, size_curve{}, slab_count{},
+      sampler{stat.sample_rate, stat.sample_keys}
 {
 
   if (stat.memcachier_classes)
@@ -37,6 +38,13 @@ size_t shadowslab::process_request(const Request *r, bool warmup)
 {
   assert(r->size() > 0);
 
+  // 空间采样：只模拟被采样的键
+  if (!warmup)
+    sampler.seen();
+  if (!sampler.sample(r->kid) ||
+      !sampler.admit(r->kid, [this](uint32_t kid) { forget(kid); }))
+    return PROC_MISS;
+
   if (!warmup)
   {
     ++stat.accesses;
@@ -55,7 +63,7 @@ size_t shadowslab::process_request(const Request *r, bool warmup)
     // it must penalized. In practice, memcachier and memcached's policies
     // cover the same range, so this shouldn't get invoked anyway.
     if (!warmup)
-      size_curve.miss();
+      size_curve.miss(sampler.weight());
     return PROC_MISS;
   }
 
@@ -90,7 +98,7 @@ size_t shadowslab::process_request(const Request *r, bool warmup)
   {
     // Count compulsory misses.
     if (!warmup)
-      size_curve.miss();
+      size_curve.miss(sampler.weight());
     return PROC_MISS;
   }
 
@@ -100,7 +108,9 @@ size_t shadowslab::process_request(const Request *r, bool warmup)
 
   // Determine if we need to 'grow' the slab class by giving it more slabs.
   // 当前slab class中缓存的数据对应多少个slab
-  size_t max_slabid_index = slab_class.get_bytes_cached() / SLABSIZE;
+  // 采样时字节数按采样率放大
+  size_t max_slabid_index =
+      sampler.scale(slab_class.get_bytes_cached()) / SLABSIZE;
   // 当前slab class的slab列表
   std::vector<uint64_t> &class_ids = slabids.at(klass);
   // 若当前slab class的slab数量不够，扩容1个slab
@@ -109,16 +119,16 @@ size_t shadowslab::process_request(const Request *r, bool warmup)
 
   // Figure out where in the space of slabids this access hit.
   // 当前重用距离对应第几个slab
-  size_t slabid_index = size_distance / SLABSIZE;
+  size_t slabid_index = sampler.scale(size_distance) / SLABSIZE;
   // 当前slab class中的对应slab
   size_t slabid = class_ids.at(slabid_index);
 
   // 记录全局重用距离
   size_t approx_global_size_distance =
-      (slabid * SLABSIZE) + (size_distance % SLABSIZE);
+      (slabid * SLABSIZE) + (sampler.scale(size_distance) % SLABSIZE);
   if (!warmup)
   {
-    size_curve.hit(approx_global_size_distance);
+    size_curve.hit(approx_global_size_distance, sampler.weight());
     ++stat.hits;
   }
 
@@ -130,6 +140,14 @@ size_t shadowslab::get_bytes_cached() const
   return 0;
 }
 
+void shadowslab::forget(uint32_t kid)
+{
+  // A key is only in slab_for_key once it hit, so look in every class.
+  for (shadowlru &slab_class : slabs)
+    slab_class.remove(kid);
+  slab_for_key.erase(kid);
+}
+
 std::pair<uint64_t, uint64_t> shadowslab::get_slab_class(uint32_t size)
 {
   uint64_t class_size = 64;
@@ -172,6 +190,7 @@ void shadowslab::log_curves()
   std::string filename_suffix{"-app" + app_ids + (stat.memcachier_classes ? "-memcachier" : "-memcached")};
 
   // 保存重用距离cdf
+  sampler.adjust(size_curve);
   size_curve.dump_cdf("shadowslab-size-curve" + filename_suffix + ".data");
   dump_util("shadowslab-util" + filename_suffix + ".data");
 }
@@ -211,8 +230,9 @@ void shadowslab::dump_util(const std::string &filename)
   // Gather frag vectors for all slab classes.
   std::vector<std::vector<size_t>> frag_vectors{};
   // 遍历所有slab class，获取每个slab class中请求的碎片大小
+  // 采样时按采样后的字节数划分slab
   for (const auto &slab : slabs)
-    frag_vectors.emplace_back(slab.get_class_frags(SLABSIZE));
+    frag_vectors.emplace_back(slab.get_class_frags(sampler.unscale(SLABSIZE)));
 
   // Determine total number of slab ids.
   size_t num_slabs = 0;
@@ -238,7 +258,10 @@ void shadowslab::dump_util(const std::string &filename)
     const std::vector<size_t> &fs = frag_vectors.at(slab_class);
     // 根据当前slab在slab class中的位置，获取当前slab的碎片大小
     // 累加到总碎片大小中
-    total_wasted += fs.at(slab_dist);
+    // A class may hold fewer bytes than it once did, or than its sample
+    // suggests; its last slabs then hold nothing.
+    if (size_t(slab_dist) < fs.size())
+      total_wasted += sampler.scale(fs[slab_dist]);
     // 当前累计的slab的总大小
     size_t cache_size = (1 + next_slab) * SLABSIZE;
     // 计算当前的总空间利用率
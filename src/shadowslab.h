@@ -6,6 +6,7 @@
 #include "hit_rate_curve.h"
 #include "policy.h"
 #include "shadowlru.h"
+#include "shards.h"
 #include "mc.h"
 
 // policy derived from Cliffhanger paper
@@ -25,6 +26,8 @@ public:
 private:
   std::pair<uint64_t, uint64_t> get_slab_class(uint32_t size);
   std::pair<int32_t, int64_t> get_next_slab(uint32_t c);
+  // Removes a key that is no longer sampled from every slab class.
+  void forget(uint32_t kid);
 
   // 每个slab中使用shadowlru
   std::vector<shadowlru> slabs;
@@ -44,6 +47,9 @@ private:
   // If true use memcachier size classes instead of memcacheds.
 
   uint32_t slab_count;
+
+  // Keys simulated, across all slab classes.
+  shards sampler;
 };
 
 #endif
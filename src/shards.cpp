@@ -0,0 +1,28 @@
+#include <cassert>
+#include <cmath>
+
+#include "shards.h"
+
+const uint32_t shards::MODULUS;
+
+shards::shards(double rate, size_t max_keys)
+    : threshold{uint32_t(std::lround(rate * MODULUS))}, max_keys{max_keys},
+      expected{}, sampled{}, by_hash{}
+{
+  assert(rate > 0 && rate <= 1);
+  if (threshold == 0)
+    threshold = 1;
+}
+
+void shards::adjust(hit_rate_curve &curve, size_t unrecorded) const
+{
+  if (!sampling())
+    return;
+
+  const int64_t missing =
+      std::llround(expected) - int64_t(curve.accesses() + unrecorded);
+  if (missing >= 0)
+    curve.hit(0, size_t(missing));
+  else
+    curve.remove_shortest(size_t(-missing));
+}
@@ -0,0 +1,138 @@
+#ifndef SHARDS_H
+#define SHARDS_H
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstddef>
+#include <utility>
+
+#include "hit_rate_curve.h"
+#include "key_map.h"
+#include "mem_usage.h"
+
+// Spatially hashed sampling of keys for approximate miss ratio curves
+// (SHARDS, Waldspurger et al., FAST '15).
+//
+// A kid is sampled if a hash of it is below a threshold T out of MODULUS.
+// Every Request for a sampled key is kept and every other one dropped, so a
+// stack of the sampled keys alone holds about R = T / MODULUS of the bytes
+// of the full stack at the same point, and its distances times 1 / R
+// estimate the full stack's.
+//
+// With a key bound (fixed-size SHARDS) the threshold starts at the rate and
+// is lowered whenever more keys than the bound have been sampled, dropping
+// the keys with the highest hashes. Hits and misses counted at a higher rate
+// then stand for fewer Requests than those counted later, so they are
+// weighted by 1 / R at the time they are counted (weight()). Without a key
+// bound the weight is 1, so curves count Requests as they always did.
+//
+// A few hot keys can take a large share of the Requests, and whether they
+// are sampled or not then skews the whole curve. adjust() makes up the
+// difference between the Requests counted and those expected at the rate
+// with hits at the shortest distance (SHARDS_adj), where hot keys hit.
+class shards
+{
+public:
+  // @param rate - fraction of the keys to sample, in (0, 1].
+  // @param max_keys - most keys sampled at once; 0 for no bound.
+  shards(double rate = 1, size_t max_keys = 0);
+
+  // @return - true if some Requests are dropped.
+  bool sampling() const { return threshold < MODULUS || max_keys > 0; }
+
+  // @return - true if Requests for \a kid are sampled.
+  bool sample(uint32_t kid) const { return hash(kid) < threshold; }
+
+  // Counts a Request outside warmup, sampled or not, for adjust().
+  void seen() { expected += rate() * weight(); }
+
+  // Adds the Requests \a curve lacks, or takes away those it has too many
+  // of, at the shortest distances. \a unrecorded is the weight of sampled
+  // Requests outside warmup that were neither a hit nor a miss.
+  void adjust(hit_rate_curve &curve, size_t unrecorded = 0) const;
+
+  // Records a Request for \a kid, which sample() keeps. With a key bound
+  // this may lower the threshold; evict(kid) is then called for each key
+  // that is no longer sampled.
+  //
+  // @return - false if \a kid itself is no longer sampled.
+  template <typename F>
+  bool admit(uint32_t kid, F evict)
+  {
+    if (max_keys == 0 || sampled.find(kid))
+      return true;
+    const uint32_t h = hash(kid);
+    sampled[kid] = h;
+    by_hash.emplace_back(h, kid);
+    std::push_heap(by_hash.begin(), by_hash.end());
+
+    bool kept = true;
+    while (sampled.size() > max_keys)
+    {
+      // Every key with the highest hash goes, so the threshold drops below
+      // it.
+      threshold = by_hash.front().first;
+      while (!by_hash.empty() && by_hash.front().first >= threshold)
+      {
+        const uint32_t dropped = by_hash.front().second;
+        std::pop_heap(by_hash.begin(), by_hash.end());
+        by_hash.pop_back();
+        sampled.erase(dropped);
+        if (dropped == kid)
+          kept = false;
+        else
+          evict(dropped);
+      }
+    }
+    return kept;
+  }
+
+  // @return - \a bytes of the sampled stack scaled to the full stack.
+  size_t scale(size_t bytes) const
+  {
+    return threshold == MODULUS ? bytes : size_t(bytes / rate());
+  }
+
+  // @return - \a bytes of the full stack scaled to the sampled stack.
+  size_t unscale(size_t bytes) const
+  {
+    return threshold == MODULUS ? bytes : size_t(bytes * rate());
+  }
+
+  // @return - the weight of a hit or miss counted now.
+  size_t weight() const
+  {
+    return max_keys == 0 ? 1 : (uint64_t(MODULUS) << WEIGHT_BITS) /
+                                   std::max(threshold, uint32_t(1));
+  }
+
+  double rate() const { return double(threshold) / MODULUS; }
+
+private:
+  static const uint32_t MODULUS = 1u << 24;
+  // Fixed point bits of weight(), so that rates a little apart still get
+  // weights a little apart.
+  static const unsigned WEIGHT_BITS = 16;
+
+  static uint32_t hash(uint32_t kid)
+  {
+    // The splitmix64 finalizer; kids are often sequential, so the low bits
+    // of kid alone would sample runs of them.
+    uint64_t z = kid + 0x9E3779B97F4A7C15ull;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    z ^= z >> 31;
+    return uint32_t(z >> 40);
+  }
+
+  uint32_t threshold;
+  size_t max_keys;
+  // Weight the Requests seen would have in the curve at the rate.
+  double expected;
+  // With a key bound, the sampled keys and their hashes, and a max-heap of
+  // them by hash.
+  key_map<uint32_t> sampled;
+  counted_vector<std::pair<uint32_t, uint32_t>, mem_tag::hash_index> by_hash;
+};
+
+#endif
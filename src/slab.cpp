@@ -121,6 +121,39 @@ size_t slab::get_bytes_cached() const
   return b;
 }
 
+// 保存/恢复检查点：每个slab class的LRU以及key到slab class的映射
+void slab::save(checkpoint_writer &w) const
+{
+  stat.save(w);
+  w.put(uint64_t(slab_count));
+  w.put(mem_in_use);
+  for (const LRU &slab_class : slabs)
+    slab_class.save(w);
+  w.put(uint64_t(slab_for_key.size()));
+  for (const auto &entry : slab_for_key)
+  {
+    w.put(entry.first);
+    w.put(entry.second);
+  }
+}
+
+void slab::restore(checkpoint_reader &r)
+{
+  stat.restore(r);
+  r.expect(uint64_t(slab_count), "number of slab classes");
+  mem_in_use = r.get<uint64_t>();
+  for (LRU &slab_class : slabs)
+    slab_class.restore(r);
+  slab_for_key.clear();
+  const uint64_t n = r.get<uint64_t>();
+  slab_for_key.reserve(n);
+  for (uint64_t i = 0; i < n; ++i)
+  {
+    const uint32_t kid = r.get<uint32_t>();
+    slab_for_key.emplace(kid, r.get<uint32_t>());
+  }
+}
+
 std::pair<uint64_t, uint64_t> slab::get_slab_class(uint32_t size)
 {
   uint64_t class_size = 64;
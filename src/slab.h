@@ -23,6 +23,10 @@ public:
   size_t process_request(const Request *r, bool warmup);
   size_t get_bytes_cached() const;
 
+  bool can_checkpoint() const { return true; }
+  void save(checkpoint_writer &w) const;
+  void restore(checkpoint_reader &r);
+
 private:
   std::pair<uint64_t, uint64_t> get_slab_class(uint32_t size);
 
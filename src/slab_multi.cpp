@@ -82,7 +82,7 @@ void slab_multi::dump_app_stats(double time)
   for (auto &p : apps)
   {
     application &app = p.second;
-    app.dump_stats(time);
+    app.dump_stats(*out, time);
   }
 }
 
@@ -101,7 +101,7 @@ size_t slab_multi::process_request(const Request *r, bool warmup)
   if (!warmup && ((last_dump == 0.) || (r->time - last_dump > 3600.)))
   {
     if (last_dump == 0.)
-      application::dump_stats_header();
+      application::dump_stats_header(*out);
     dump_app_stats(r->time);
     if (last_dump == 0.)
       last_dump = r->time;
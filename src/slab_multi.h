@@ -51,52 +51,52 @@ public:
       return true;
     }
 
-    static void dump_stats_header()
+    static void dump_stats_header(std::ostream &out)
     {
-      std::cout << "time "
-                << "app "
-                << "subPolicy "
-                << "target_mem "
-                << "credit_bytes "
-                << "share "
-                << "min_mem "
-                << "min_mem_pct "
-                << "steal_size "
-                << "bytes_in_use "
-                << "need "
-                << "hits "
-                << "accesses "
-                << "shadow_q_hits "
-                << "survivor_items "
-                << "survivor_bytes "
-                << "evicted_items "
-                << "evicted_bytes "
-                << "hit_rate "
-                << std::endl;
+      out << "time "
+          << "app "
+          << "subPolicy "
+          << "target_mem "
+          << "credit_bytes "
+          << "share "
+          << "min_mem "
+          << "min_mem_pct "
+          << "steal_size "
+          << "bytes_in_use "
+          << "need "
+          << "hits "
+          << "accesses "
+          << "shadow_q_hits "
+          << "survivor_items "
+          << "survivor_bytes "
+          << "evicted_items "
+          << "evicted_bytes "
+          << "hit_rate "
+          << std::endl;
     }
 
-    void dump_stats(double time)
+    void dump_stats(std::ostream &out, double time)
     {
-      std::cout << int64_t(time) << " "
-                << appid << " "
-                << "multislab "
-                << target_mem << " "
-                << credit_bytes << " "
-                << target_mem + credit_bytes << " "
-                << min_mem << " "
-                << min_mem_pct << " "
-                << 0 << " "
-                << bytes_in_use << " "
-                << need() << " "
-                << hits << " "
-                << accesses << " "
-                << shadow_q_hits << " "
-                << survivor_items << " "
-                << survivor_bytes << " "
-                << evicted_items << " "
-                << evicted_bytes << " "
-                << double(hits) / accesses << " "
-                << std::endl;
+      out << int64_t(time) << " "
+          << appid << " "
+          << "multislab "
+          << target_mem << " "
+          << credit_bytes << " "
+          << target_mem + credit_bytes << " "
+          << min_mem << " "
+          << min_mem_pct << " "
+          << 0 << " "
+          << bytes_in_use << " "
+          << need() << " "
+          << hits << " "
+          << accesses << " "
+          << shadow_q_hits << " "
+          << survivor_items << " "
+          << survivor_bytes << " "
+          << evicted_items << " "
+          << evicted_bytes << " "
+          << double(hits) / accesses << " "
+          << std::endl;
     }
 
     double need()
@@ -0,0 +1,142 @@
+#include <algorithm>
+#include <cassert>
+
+#include "stack_distance.h"
+
+namespace {
+
+const size_t MIN_SLOTS = 1024;
+
+} // namespace
+
+stack_distance::stack_distance(size_t key_space)
+    : slot_of{key_space}, objects{}, tree{}, next{}, total{}
+{
+}
+
+stack_distance::distance stack_distance::depth(uint32_t kid) const
+{
+  const uint32_t *slot = slot_of.find(kid);
+  if (!slot)
+    return {0, 0};
+  const sums before = prefix(*slot);
+  return {total - before.bytes, slot_of.size() - before.objects};
+}
+
+stack_distance::distance stack_distance::touch(uint32_t kid, int32_t size,
+                                               int32_t frag)
+{
+  assert(size > 0);
+  distance depth{0, 0};
+  uint32_t *slot = slot_of.find(kid);
+  if (slot)
+  {
+    const sums before = prefix(*slot);
+    depth = {total - before.bytes, slot_of.size() - before.objects};
+    object &old = objects[*slot];
+    add(*slot, -int64_t(old.size));
+    total -= old.size;
+    old.size = 0;
+  }
+
+  if (next == objects.size())
+  {
+    renumber();
+    // Renumbering moves the slots around.
+    slot = slot_of.find(kid);
+  }
+  if (!slot)
+    slot = &slot_of[kid];
+
+  *slot = uint32_t(next);
+  objects[next] = object{kid, size, frag};
+  add(next, size);
+  total += size;
+  ++next;
+  return depth;
+}
+
+size_t stack_distance::remove(uint32_t kid)
+{
+  const uint32_t *slot = slot_of.find(kid);
+  if (!slot)
+    return 0;
+  object &old = objects[*slot];
+  const size_t in_front = total - prefix(*slot).bytes - old.size;
+  add(*slot, -int64_t(old.size));
+  total -= old.size;
+  old.size = 0;
+  slot_of.erase(kid);
+  return in_front;
+}
+
+void stack_distance::append(const stack_distance &newer)
+{
+  for (size_t slot = 0; slot < newer.next; ++slot)
+  {
+    const object &o = newer.objects[slot];
+    if (o.size)
+    {
+      assert(!slot_of.find(o.kid));
+      touch(o.kid, o.size, o.frag);
+    }
+  }
+}
+
+stack_distance::sums stack_distance::prefix(size_t slot) const
+{
+  sums sum{};
+  for (size_t i = slot; i > 0; i &= i - 1)
+  {
+    sum.bytes += tree[i].bytes;
+    sum.objects += tree[i].objects;
+  }
+  return sum;
+}
+
+void stack_distance::add(size_t slot, int64_t size)
+{
+  const uint64_t count = size > 0 ? 1 : uint64_t(-1);
+  for (size_t i = slot + 1; i < tree.size(); i += i & (~i + 1))
+  {
+    tree[i].bytes += size;
+    tree[i].objects += count;
+  }
+}
+
+void stack_distance::renumber()
+{
+  size_t live = 0;
+  for (size_t slot = 0; slot < next; ++slot)
+  {
+    if (!objects[slot].size)
+      continue;
+    objects[live] = objects[slot];
+    *slot_of.find(objects[live].kid) = uint32_t(live);
+    ++live;
+  }
+  assert(live <= slot_of.size());
+
+  const size_t slots = std::max(MIN_SLOTS, 2 * live);
+  assert(slots <= UINT32_MAX);
+  objects.resize(slots);
+  std::fill(objects.begin() + live, objects.end(), object{0, 0, 0});
+  next = live;
+
+  // Builds the tree in O(n): each node passes its sum on to its parent.
+  tree.assign(slots + 1, sums{});
+  for (size_t i = 1; i < tree.size(); ++i)
+  {
+    if (objects[i - 1].size)
+    {
+      tree[i].bytes += objects[i - 1].size;
+      ++tree[i].objects;
+    }
+    const size_t parent = i + (i & (~i + 1));
+    if (parent < tree.size())
+    {
+      tree[parent].bytes += tree[i].bytes;
+      tree[parent].objects += tree[i].objects;
+    }
+  }
+}
@@ -0,0 +1,101 @@
+#ifndef STACK_DISTANCE_H
+#define STACK_DISTANCE_H
+
+#include <cinttypes>
+#include <cstddef>
+
+#include "key_map.h"
+#include "mem_usage.h"
+
+// Byte-weighted LRU stack (Mattson's algorithm) in O(log n) per access.
+//
+// Instead of a list in LRU order, every access gets the next slot of a
+// logical clock and the object's size is stored at that slot in a Fenwick
+// tree, which sums the sizes of any range of slots in O(log n). An object's
+// depth in the stack, the bytes of it and of everything accessed since, is
+// then the sum of the slots from its last access on. The tree counts the
+// objects in each range along with their bytes, for distances in objects.
+// A key_map finds that slot by kid; moving an object to the front clears
+// its old slot and takes the next one.
+//
+// Slots are never reused, so once the clock reaches the end of the tree the
+// objects are renumbered into the lowest slots in the same order, and the
+// tree is rebuilt with room for at least as many again, which costs O(1)
+// per access amortized.
+class stack_distance
+{
+public:
+  // Bytes and objects from the front of the stack through an object.
+  struct distance
+  {
+    size_t bytes;
+    size_t objects;
+  };
+
+  // @param key_space - all kids are below this; 0 if kids are not dense.
+  explicit stack_distance(size_t key_space = 0);
+
+  // @return - the distance of \a kid, or {0, 0} if it is not in the stack.
+  distance depth(uint32_t kid) const;
+
+  // Moves \a kid to the front of the stack with a new size, adding it if it
+  // is not in it.
+  //
+  // @return - depth(kid) before the move.
+  distance touch(uint32_t kid, int32_t size, int32_t frag);
+
+  // Removes \a kid from the stack.
+  //
+  // @return - the bytes in front of it, or 0 if it was not in the stack.
+  size_t remove(uint32_t kid);
+
+  // Puts the objects of \a newer, which holds none of the keys of this
+  // stack, in front of them in the same order.
+  void append(const stack_distance &newer);
+
+  // @return - the bytes of all objects in the stack.
+  size_t bytes() const { return total; }
+  size_t size() const { return slot_of.size(); }
+
+  // Calls f(size, frag) for each object from the front to the back.
+  template <typename F>
+  void for_each(F f) const
+  {
+    for (size_t slot = next; slot-- > 0;)
+      if (objects[slot].size)
+        f(objects[slot].size, objects[slot].frag);
+  }
+
+private:
+  struct object
+  {
+    uint32_t kid;
+    int32_t size; // 0 for a slot that holds no object
+    int32_t frag;
+  };
+
+  struct sums
+  {
+    uint64_t bytes = 0;
+    uint64_t objects = 0;
+  };
+
+  // @return - the sums of the slots [0, slot).
+  sums prefix(size_t slot) const;
+  // Adds or, with a negative \a size, takes away an object of \a size bytes
+  // at \a slot.
+  void add(size_t slot, int64_t size);
+  // Renumbers the objects into the lowest slots and rebuilds the tree.
+  void renumber();
+
+  key_map<uint32_t> slot_of;
+  counted_vector<object, mem_tag::queue> objects;
+  // Fenwick tree over the slots, 1-based: tree[i] sums the slots
+  // [i - lowbit(i), i).
+  counted_vector<sums, mem_tag::queue> tree;
+  // The next slot to hand out.
+  size_t next;
+  size_t total;
+};
+
+#endif
@@ -1,6 +1,9 @@
 #include <string>
 #include <set>
 
+#include "checkpoint.h"
+#include "policy_config.h"
+
 #ifndef STATS_H
 #define STATS_H
 
@@ -104,6 +107,15 @@ struct stats
   /// Only for partslab; number of hash partitions to split the slabs across.
   size_t partitions;
 
+  /// For shadowlru, shadowslab and partslab; fraction of the keys to sample
+  /// (see shards.h), and most keys to sample at once, 0 for no bound.
+  double sample_rate;
+  size_t sample_keys;
+
+  /// Only for shadowlru; model the curve from reuse times (see aet.h)
+  /// instead of keeping a stack.
+  bool use_aet;
+
   /// For flash_cache, victim_cache, ripq, ripq_shield; number of #hits that hit from an item in DRAM.
   size_t hits_dram;
 
@@ -128,6 +140,13 @@ struct stats
   // Threshold for the block algorithm
   double threshold;
 
+  /// If non-zero every kid is below this (binary trace converted with
+  /// csv2bin -d) and policies may index per-key state directly by kid.
+  size_t key_space;
+
+  /// Tuning knobs of the policy (see policy_config.h).
+  policy_config config;
+
   stats(const std::string &policy,
         std::set<uint32_t> *apps,
         size_t global_mem)
@@ -135,8 +154,10 @@ struct stats
         hits{}, bytes_cached{}, missed_bytes{}, evicted_bytes{}, evicted_items{},
         segment_size{}, block_size{}, num_sections{}, num_dsections{}, cleaning_width{},
         cleaned_generated_segs{}, cleaned_ext_frag_bytes{}, memcachier_classes{},
-        gfactor{}, partitions{}, hits_dram{}, hits_flash{}, writes_flash{},
-        credit_limit{}, flash_bytes_written{}, dram_size{}, flash_size{}, threshold{}
+        gfactor{}, partitions{}, sample_rate{1}, sample_keys{}, use_aet{},
+        hits_dram{}, hits_flash{}, writes_flash{},
+        credit_limit{}, flash_bytes_written{}, dram_size{}, flash_size{}, threshold{},
+        key_space{}, config{}
   {
   }
 
@@ -208,6 +229,96 @@ struct stats
         << std::endl;
   }
 
+  /// Writes the counters of a run to a checkpoint, and the parameters the
+  /// Policy was built with so restore() can check they match.
+  void save(checkpoint_writer &w) const
+  {
+    w.put(segment_size);
+    w.put(block_size);
+    w.put(num_sections);
+    w.put(num_dsections);
+    w.put(cleaning_width);
+    w.put(memcachier_classes);
+    w.put(gfactor);
+    w.put(partitions);
+    w.put(dram_size);
+    w.put(flash_size);
+    w.put(threshold);
+    w.put(key_space);
+    w.put(config.dram_size);
+    w.put(config.flash_size);
+    w.put(config.k);
+    w.put(config.l_fc);
+    w.put(config.k_lru);
+    w.put(config.klru_queue_size);
+    w.put(config.clock_max_value);
+    w.put(config.clock_max_value_klru);
+    w.put(config.use_tax);
+    w.put(config.tax_rate);
+    w.put(config.svm_threshold);
+
+    w.put(global_mem);
+    w.put(utilization);
+    w.put(accesses);
+    w.put(hits);
+    w.put(bytes_cached);
+    w.put(missed_bytes);
+    w.put(evicted_bytes);
+    w.put(evicted_items);
+    w.put(cleaned_generated_segs);
+    w.put(cleaned_ext_frag_bytes);
+    w.put(hits_dram);
+    w.put(hits_flash);
+    w.put(writes_flash);
+    w.put(credit_limit);
+    w.put(flash_bytes_written);
+  }
+
+  void restore(checkpoint_reader &r)
+  {
+    r.expect(segment_size, "segment size (-S)");
+    r.expect(block_size, "block size (-B)");
+    r.expect(num_sections, "number of sections (-n)");
+    r.expect(num_dsections, "number of DRAM sections (-d)");
+    r.expect(cleaning_width, "cleaning width (-c)");
+    r.expect(memcachier_classes, "slab classes (-M)");
+    r.expect(gfactor, "slab growth factor (-g)");
+    r.expect(partitions, "number of partitions (-P)");
+    r.expect(dram_size, "DRAM size (-D)");
+    r.expect(flash_size, "flash size (-F)");
+    r.expect(threshold, "threshold (-t)");
+    r.expect(key_space, "key space (trace)");
+    r.expect(config.dram_size, "DRAM size (-D)");
+    r.expect(config.flash_size, "flash size (-F)");
+    r.expect(config.k, "flashiness weight (-k)");
+    r.expect(config.l_fc, "hit value (-H)");
+    r.expect(config.k_lru, "number of queues (-K)");
+    r.expect(config.klru_queue_size, "queue size (-L)");
+    r.expect(config.clock_max_value, "clock maximum (-C)");
+    r.expect(config.clock_max_value_klru, "clock maximum (-C)");
+    r.expect(config.use_tax, "memory tax (-T)");
+    r.expect(config.tax_rate, "memory tax (-T)");
+    r.expect(config.svm_threshold, "SVM threshold (-A)");
+
+    r.expect(global_mem, "cache size (-s)");
+    // No option sets utilization (-u scales the cache size checked above),
+    // so it is restored like the counters below.
+    utilization = r.get<double>();
+    accesses = r.get<size_t>();
+    hits = r.get<size_t>();
+    bytes_cached = r.get<size_t>();
+    missed_bytes = r.get<size_t>();
+    evicted_bytes = r.get<size_t>();
+    evicted_items = r.get<size_t>();
+    cleaned_generated_segs = r.get<size_t>();
+    cleaned_ext_frag_bytes = r.get<size_t>();
+    hits_dram = r.get<size_t>();
+    hits_flash = r.get<size_t>();
+    writes_flash = r.get<size_t>();
+    credit_limit = r.get<size_t>();
+    flash_bytes_written = r.get<size_t>();
+  }
+
   stats(const stats &) = default;
   stats &operator=(const stats &) = default;
   stats &operator=(stats &&) = default;
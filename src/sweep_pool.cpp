@@ -0,0 +1,86 @@
+#include <algorithm>
+#include <cassert>
+#include <thread>
+
+#include "sweep_pool.h"
+
+sweep_pool::sweep_pool(size_t threads)
+    : threads{threads}, queues{}
+{
+  assert(threads > 0);
+}
+
+void sweep_pool::run(std::vector<job> jobs)
+{
+  std::stable_sort(jobs.begin(), jobs.end(),
+                   [](const job &a, const job &b) { return a.cost > b.cost; });
+
+  const size_t workers = std::min(threads, jobs.size());
+  queues.clear();
+  for (size_t t = 0; t < workers; ++t)
+    queues.emplace_back(new queue{});
+  for (size_t j = 0; j < jobs.size(); ++j)
+  {
+    queue &q = *queues[j % workers];
+    q.cost += jobs[j].cost;
+    q.jobs.push_back(std::move(jobs[j]));
+  }
+
+  std::vector<std::thread> pool{};
+  for (size_t t = 0; t < workers; ++t)
+  {
+    pool.emplace_back([this, t] {
+      job j{};
+      while (next_job(t, &j))
+        j.run();
+    });
+  }
+  for (std::thread &thread : pool)
+    thread.join();
+  queues.clear();
+}
+
+bool sweep_pool::next_job(size_t self, job *out)
+{
+  {
+    queue &own = *queues[self];
+    std::lock_guard<std::mutex> lock{own.mutex};
+    if (!own.jobs.empty())
+    {
+      *out = std::move(own.jobs.front());
+      own.jobs.pop_front();
+      own.cost -= out->cost;
+      return true;
+    }
+  }
+
+  // Queues only ever shrink once the threads are running, so a victim that
+  // is drained by the time we lock it just means looking again.
+  while (true)
+  {
+    queue *victim = nullptr;
+    double most = 0;
+    for (size_t t = 0; t < queues.size(); ++t)
+    {
+      if (t == self)
+        continue;
+      queue &q = *queues[t];
+      std::lock_guard<std::mutex> lock{q.mutex};
+      if (!q.jobs.empty() && (!victim || q.cost > most))
+      {
+        victim = &q;
+        most = q.cost;
+      }
+    }
+    if (!victim)
+      return false;
+
+    std::lock_guard<std::mutex> lock{victim->mutex};
+    if (victim->jobs.empty())
+      continue;
+    *out = std::move(victim->jobs.back());
+    victim->jobs.pop_back();
+    victim->cost -= out->cost;
+    return true;
+  }
+}
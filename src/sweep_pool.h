@@ -0,0 +1,50 @@
+#ifndef SWEEP_POOL_H
+#define SWEEP_POOL_H
+
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Runs the independent jobs of a parameter sweep on a fixed set of threads.
+//
+// Jobs are sorted by their predicted cost and dealt out round-robin, so
+// every thread starts with one of the longest jobs. A thread works through
+// its own queue from the front (longest first); once it is empty it steals
+// from the back of the queue with the most predicted work left. A long job
+// therefore never holds up shorter jobs queued behind it: the other threads
+// take them over, and a sweep ends shortly after its longest job does.
+class sweep_pool
+{
+public:
+  struct job
+  {
+    double cost;                // predicted cost; only compared
+    std::function<void()> run;
+  };
+
+  explicit sweep_pool(size_t threads);
+
+  // Runs every job in \a jobs and returns once all of them are done.
+  void run(std::vector<job> jobs);
+
+private:
+  struct queue
+  {
+    queue() : mutex{}, jobs{}, cost{} {}
+
+    std::mutex mutex;
+    std::deque<job> jobs;
+    double cost;                // predicted cost of the queued jobs
+  };
+
+  // @return - false once there is nothing left to run or steal.
+  bool next_job(size_t self, job *out);
+
+  size_t threads;
+  std::vector<std::unique_ptr<queue>> queues;
+};
+
+#endif
@@ -0,0 +1,403 @@
+#include <iostream>
+#include <fstream>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <limits>
+#include <map>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "trace_index.h"
+#include "bin_trace.h"
+#include "compressed_trace_reader.h"
+
+namespace {
+
+// Maps \a path read-only; an empty file maps to nullptr.
+void *map_file(const std::string &path, size_t *length)
+{
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+  {
+    std::cerr << "Couldn't open " << path << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) != 0)
+  {
+    std::cerr << "Couldn't stat " << path << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  *length = st.st_size;
+
+  void *base = nullptr;
+  if (*length > 0)
+  {
+    base = mmap(nullptr, *length, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (base == MAP_FAILED)
+    {
+      std::cerr << "Couldn't mmap " << path << std::endl;
+      exit(EXIT_FAILURE);
+    }
+  }
+  close(fd);
+  return base;
+}
+
+struct app_ranges
+{
+  app_ranges() : lines{}, ranges{} {}
+
+  uint64_t lines;
+  std::vector<trace_index_range> ranges;
+};
+
+class index_builder
+{
+public:
+  index_builder() : header{}, chunks{}, apps{} {}
+
+  void add_line(uint64_t offset, uint32_t bytes, const Request &r)
+  {
+    const uint64_t line = header.num_lines++;
+    const bool chunk_start = line % TRACE_INDEX_CHUNK_LINES == 0;
+    if (chunk_start)
+    {
+      chunks.push_back(trace_index_chunk{offset, line, r.time, r.time});
+    }
+    else
+    {
+      trace_index_chunk &c = chunks.back();
+      c.min_time = std::min(c.min_time, r.time);
+      c.max_time = std::max(c.max_time, r.time);
+    }
+
+    app_ranges &a = apps[r.appid];
+    ++a.lines;
+    // Extend the app's last run if the previous line was also its own.
+    if (!chunk_start && !a.ranges.empty() &&
+        a.ranges.back().offset + a.ranges.back().bytes == offset &&
+        a.ranges.back().bytes <= std::numeric_limits<uint32_t>::max() - bytes)
+    {
+      a.ranges.back().bytes += bytes;
+      ++a.ranges.back().lines;
+    }
+    else
+    {
+      a.ranges.push_back(trace_index_range{offset, bytes, 1});
+    }
+  }
+
+  void write(const std::string &index_path, bool binary,
+             const struct stat &st)
+  {
+    memcpy(header.magic, TRACE_INDEX_MAGIC, sizeof(header.magic));
+    header.version = TRACE_INDEX_VERSION;
+    header.binary = binary;
+    header.trace_size = st.st_size;
+    header.trace_mtime = st.st_mtime;
+    header.num_chunks = chunks.size();
+    header.num_apps = apps.size();
+    header.chunks_offset = sizeof(trace_index_header);
+    header.apps_offset =
+        header.chunks_offset + chunks.size() * sizeof(trace_index_chunk);
+
+    std::ofstream out{index_path, std::ios::binary | std::ios::trunc};
+    if (!out.is_open())
+    {
+      std::cerr << "Couldn't open " << index_path << " for writing"
+                << std::endl;
+      exit(EXIT_FAILURE);
+    }
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char *>(chunks.data()),
+              chunks.size() * sizeof(trace_index_chunk));
+
+    uint64_t ranges_offset =
+        header.apps_offset + apps.size() * sizeof(trace_index_app);
+    for (const auto &a : apps)
+    {
+      trace_index_app entry{a.first, 0, a.second.lines,
+                            a.second.ranges.size(), ranges_offset};
+      out.write(reinterpret_cast<const char *>(&entry), sizeof(entry));
+      ranges_offset += a.second.ranges.size() * sizeof(trace_index_range);
+    }
+    for (const auto &a : apps)
+      out.write(reinterpret_cast<const char *>(a.second.ranges.data()),
+                a.second.ranges.size() * sizeof(trace_index_range));
+
+    if (!out)
+    {
+      std::cerr << "Couldn't write " << index_path << std::endl;
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  uint64_t get_num_lines() const { return header.num_lines; }
+
+private:
+  trace_index_header header;
+  std::vector<trace_index_chunk> chunks;
+  std::map<uint32_t, app_ranges> apps;  // ordered by appid for find_app()
+};
+
+} // namespace
+
+uint64_t build_trace_index(const std::string &path,
+                           const std::string &index_path)
+{
+  if (detect_trace_compression(path) != trace_compression::NONE)
+  {
+    std::cerr << "Compressed trace " << path << " can't be indexed; "
+              << "convert it with csv2bin first" << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  struct stat st;
+  if (stat(path.c_str(), &st) != 0)
+  {
+    std::cerr << "Couldn't stat " << path << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  index_builder builder{};
+  const bool binary = is_bin_trace(path);
+  if (binary)
+  {
+    bin_trace_file file{path};
+    Request r{};
+    for (uint64_t i = 0; i < file.get_num_records(); ++i)
+    {
+      bin_trace_file::to_request(file.record(i), &r);
+      builder.add_line(sizeof(bin_trace_header) + i * sizeof(bin_trace_record),
+                       sizeof(bin_trace_record), r);
+    }
+  }
+  else
+  {
+    size_t length = 0;
+    void *base = map_file(path, &length);
+    if (base)
+      madvise(base, length, MADV_SEQUENTIAL);
+    const char *bytes = static_cast<const char *>(base);
+    const char *pos = bytes;
+    const char *const end = bytes + length;
+    while (pos < end)
+    {
+      const char *nl = static_cast<const char *>(memchr(pos, '\n', end - pos));
+      const char *line_end = nl ? nl : end;
+      const char *next = nl ? nl + 1 : end;
+
+      Request r{};
+      r.parse(pos, line_end);
+      builder.add_line(pos - bytes, next - pos, r);
+      pos = next;
+    }
+    if (base)
+      munmap(base, length);
+  }
+
+  builder.write(index_path, binary, st);
+  return builder.get_num_lines();
+}
+
+trace_index::trace_index(const std::string &index_path)
+    : base{nullptr}, length{}, header{nullptr}, chunks{nullptr}, apps{nullptr}
+{
+  base = map_file(index_path, &length);
+
+  const char *bytes = static_cast<const char *>(base);
+  header = reinterpret_cast<const trace_index_header *>(bytes);
+  if (length < sizeof(trace_index_header) ||
+      memcmp(header->magic, TRACE_INDEX_MAGIC, sizeof(header->magic)) != 0 ||
+      header->version != TRACE_INDEX_VERSION ||
+      header->apps_offset + header->num_apps * sizeof(trace_index_app) >
+          length)
+  {
+    std::cerr << "Trace index " << index_path << " is corrupt or from an "
+              << "incompatible version; rebuild it with trace-index"
+              << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  chunks = reinterpret_cast<const trace_index_chunk *>(
+      bytes + header->chunks_offset);
+  apps = reinterpret_cast<const trace_index_app *>(bytes + header->apps_offset);
+}
+
+trace_index::~trace_index()
+{
+  if (base)
+    munmap(base, length);
+}
+
+bool trace_index::matches(const std::string &path) const
+{
+  struct stat st;
+  if (stat(path.c_str(), &st) != 0)
+    return false;
+  return header->trace_size == uint64_t(st.st_size) &&
+         header->trace_mtime == int64_t(st.st_mtime);
+}
+
+const trace_index_app *trace_index::find_app(uint32_t appid) const
+{
+  const trace_index_app *end = apps + header->num_apps;
+  const trace_index_app *it = std::lower_bound(
+      apps, end, appid,
+      [](const trace_index_app &a, uint32_t id) { return a.appid < id; });
+  return it != end && it->appid == appid ? it : nullptr;
+}
+
+const trace_index_range *trace_index::ranges(const trace_index_app &app) const
+{
+  return reinterpret_cast<const trace_index_range *>(
+      static_cast<const char *>(base) + app.ranges_offset);
+}
+
+indexed_trace_reader::indexed_trace_reader(const std::string &path,
+                                           std::unique_ptr<trace_index> idx,
+                                           const std::set<uint32_t> &apps,
+                                           double begin_time, double end_time)
+    : index{std::move(idx)}, base{nullptr}, length{}, binary{false},
+      key_space{}, cursors{}, window_begin{}, window_end{}, whole_window{apps.empty()},
+      pos{}, end{}, bytes_read{}
+{
+  base = map_file(path, &length);
+  const trace_index_header &header = index->get_header();
+  binary = header.binary;
+  if (binary && length >= sizeof(bin_trace_header))
+    key_space = static_cast<const bin_trace_header *>(base)->num_keys;
+
+  // Chunks before the first one reaching begin_time and after the last one
+  // starting before end_time can't hold a request in the window.
+  const trace_index_chunk *first = index->chunks_begin();
+  const trace_index_chunk *last = index->chunks_end();
+  while (first != last && first->max_time < begin_time)
+    ++first;
+  while (last != first && (last - 1)->min_time >= end_time)
+    --last;
+
+  const uint64_t lines_end =
+      binary ? sizeof(bin_trace_header) +
+                   header.num_lines * sizeof(bin_trace_record)
+             : length;
+  window_begin = first != last ? first->offset : lines_end;
+  window_end = last != index->chunks_end() ? last->offset : lines_end;
+  if (window_end < window_begin)
+    window_end = window_begin;
+
+  if (whole_window)
+  {
+    pos = window_begin;
+    end = window_end;
+  }
+  else
+  {
+    auto before = [](const trace_index_range &r, uint64_t offset) {
+      return r.offset < offset;
+    };
+    for (uint32_t appid : apps)
+    {
+      const trace_index_app *app = index->find_app(appid);
+      if (!app)
+        continue;
+      const trace_index_range *r = index->ranges(*app);
+      const trace_index_range *r_end = r + app->num_ranges;
+      cursor c{std::lower_bound(r, r_end, window_begin, before),
+               std::lower_bound(r, r_end, window_end, before)};
+      if (c.next != c.end)
+        cursors.push_back(c);
+    }
+  }
+
+  if (base)
+    madvise(base, length, whole_window ? MADV_SEQUENTIAL : MADV_NORMAL);
+}
+
+indexed_trace_reader::~indexed_trace_reader()
+{
+  if (base)
+    munmap(base, length);
+}
+
+bool indexed_trace_reader::next_range()
+{
+  cursor *min = nullptr;
+  for (cursor &c : cursors)
+  {
+    if (c.next != c.end && (!min || c.next->offset < min->next->offset))
+      min = &c;
+  }
+  if (!min)
+    return false;
+
+  pos = min->next->offset;
+  end = pos + min->next->bytes;
+  ++min->next;
+  return true;
+}
+
+size_t indexed_trace_reader::read(Request *out, size_t n)
+{
+  const char *bytes = static_cast<const char *>(base);
+  size_t filled = 0;
+  while (filled < n)
+  {
+    if (pos == end && !next_range())
+      break;
+
+    const char *line = bytes + pos;
+    if (binary)
+    {
+      bin_trace_file::to_request(
+          *reinterpret_cast<const bin_trace_record *>(line), &out[filled]);
+      pos += sizeof(bin_trace_record);
+      bytes_read += sizeof(bin_trace_record);
+    }
+    else
+    {
+      const char *stop = bytes + end;
+      const char *nl =
+          static_cast<const char *>(memchr(line, '\n', stop - line));
+      const char *line_end = nl ? nl : stop;
+
+      out[filled] = Request{};
+      out[filled].parse(line, line_end);
+      bytes_read += line_end - line;
+      pos = (nl ? nl + 1 : stop) - bytes;
+    }
+    ++filled;
+  }
+  return filled;
+}
+
+std::unique_ptr<trace_reader> open_indexed_trace(
+    const std::string &path, const std::set<uint32_t> &apps,
+    double begin_time, double end_time)
+{
+  const bool windowed = begin_time > std::numeric_limits<double>::lowest() ||
+                        end_time < std::numeric_limits<double>::max();
+  if (apps.empty() && !windowed)
+    return nullptr;
+
+  const std::string index_path = path + ".idx";
+  if (access(index_path.c_str(), R_OK) != 0)
+    return nullptr;
+
+  std::unique_ptr<trace_index> index{new trace_index{index_path}};
+  if (!index->matches(path))
+  {
+    std::cerr << "Ignoring stale trace index " << index_path
+              << "; rebuild it with trace-index" << std::endl;
+    return nullptr;
+  }
+
+  return std::unique_ptr<trace_reader>{new indexed_trace_reader{
+      path, std::move(index), apps, begin_time, end_time}};
+}
@@ -0,0 +1,183 @@
+#ifndef TRACE_INDEX_H
+#define TRACE_INDEX_H
+
+#include <cinttypes>
+#include <cstddef>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "trace_reader.h"
+
+// Sidecar seek index for a CSV or binary trace, stored next to it as
+// <trace>.idx and built once with bin/trace-index. It records
+//
+//  - one checkpoint per TRACE_INDEX_CHUNK_LINES lines with the chunk's byte
+//    offset and time range, so a time window maps to a run of chunks, and
+//  - for every appid, the byte ranges of the maximal runs of consecutive
+//    lines belonging to that app (runs never cross a chunk boundary),
+//
+// so a run restricted to a few apps or a time window reads only the lines it
+// will simulate. How much is skipped depends on how the apps are laid out:
+// an app whose requests are spread evenly through the trace still costs one
+// range per request, but only its own lines are ever parsed.
+//
+//   +-----------------------+ 0
+//   | trace_index_header    |
+//   +-----------------------+ chunks_offset
+//   | trace_index_chunk     |
+//   | ...  num_chunks       |
+//   +-----------------------+ apps_offset
+//   | trace_index_app       |
+//   | ...  num_apps         |
+//   +-----------------------+
+//   | trace_index_range     |  ranges of each app, in trace order
+//   | ...                   |
+//   +-----------------------+
+
+static const char TRACE_INDEX_MAGIC[8] = {'L', 'S', 'M', 'I', 'N', 'D', 'E', 'X'};
+static const uint32_t TRACE_INDEX_VERSION = 1;
+static const uint64_t TRACE_INDEX_CHUNK_LINES = 64 * 1024;
+
+struct trace_index_header
+{
+  char magic[8];
+  uint32_t version;
+  uint32_t binary;        // 1 if the trace is a binary trace (bin_trace.h)
+  uint64_t trace_size;    // size and mtime of the indexed trace, to detect
+  int64_t trace_mtime;    // an index that has gone stale
+  uint64_t num_lines;
+  uint64_t num_chunks;
+  uint64_t num_apps;
+  uint64_t chunks_offset;
+  uint64_t apps_offset;
+};
+
+struct trace_index_chunk
+{
+  uint64_t offset;        // byte offset of the chunk's first line
+  uint64_t first_line;
+  double min_time;
+  double max_time;
+};
+
+struct trace_index_app
+{
+  uint32_t appid;
+  uint32_t pad;
+  uint64_t num_lines;
+  uint64_t num_ranges;
+  uint64_t ranges_offset; // byte offset of the app's first trace_index_range
+};
+
+// Lines [offset, offset + bytes) of the trace, newlines included.
+struct trace_index_range
+{
+  uint64_t offset;
+  uint32_t bytes;
+  uint32_t lines;
+};
+
+static_assert(sizeof(trace_index_header) == 72, "trace_index_header layout");
+static_assert(sizeof(trace_index_chunk) == 32, "trace_index_chunk layout");
+static_assert(sizeof(trace_index_app) == 32, "trace_index_app layout");
+static_assert(sizeof(trace_index_range) == 16, "trace_index_range layout");
+
+// Scans the trace at \a path and writes its index to \a index_path.
+//
+// @return - number of lines indexed.
+uint64_t build_trace_index(const std::string &path,
+                           const std::string &index_path);
+
+// Read-only view of a mapped index.
+class trace_index
+{
+public:
+  explicit trace_index(const std::string &index_path);
+  ~trace_index();
+
+  // False if the index does not describe the trace at \a path as it is now.
+  bool matches(const std::string &path) const;
+
+  const trace_index_header &get_header() const { return *header; }
+  const trace_index_chunk *chunks_begin() const { return chunks; }
+  const trace_index_chunk *chunks_end() const
+  {
+    return chunks + header->num_chunks;
+  }
+
+  // @return - the app's entry, or nullptr if it never appears in the trace.
+  const trace_index_app *find_app(uint32_t appid) const;
+  const trace_index_range *ranges(const trace_index_app &app) const;
+
+private:
+  void *base;
+  size_t length;
+  const trace_index_header *header;
+  const trace_index_chunk *chunks;
+  const trace_index_app *apps;
+
+  trace_index(const trace_index &) = delete;
+  trace_index &operator=(const trace_index &) = delete;
+};
+
+// Reads only the lines of a trace that an index says belong to the selected
+// apps and time window, in trace order.
+class indexed_trace_reader : public trace_reader
+{
+public:
+  // @param apps - apps to read; empty reads every app.
+  // @param begin_time, end_time - only chunks that may hold a request with
+  //   begin_time <= time < end_time are read. The caller still has to drop
+  //   the requests outside the window from the boundary chunks.
+  indexed_trace_reader(const std::string &path,
+                       std::unique_ptr<trace_index> index,
+                       const std::set<uint32_t> &apps,
+                       double begin_time, double end_time);
+  ~indexed_trace_reader();
+
+  size_t read(Request *out, size_t n);
+  size_t get_bytes_read() const { return bytes_read; }
+  uint64_t get_key_space() const { return key_space; }
+
+private:
+  struct cursor
+  {
+    const trace_index_range *next;
+    const trace_index_range *end;
+  };
+
+  // Moves to the next range (lowest offset across apps).
+  //
+  // @return - false once every range in the window has been read.
+  bool next_range();
+
+  std::unique_ptr<trace_index> index;
+  void *base;
+  size_t length;
+  bool binary;
+  uint64_t key_space;
+
+  std::vector<cursor> cursors;
+  uint64_t window_begin;  // byte offsets covered by the time window
+  uint64_t window_end;
+  bool whole_window;      // no app filter: the window is a single range
+  uint64_t pos;           // current range [pos, end)
+  uint64_t end;
+  size_t bytes_read;
+
+  indexed_trace_reader(const indexed_trace_reader &) = delete;
+  indexed_trace_reader &operator=(const indexed_trace_reader &) = delete;
+};
+
+// Opens \a path through its sidecar index (<path>.idx) restricted to
+// \a apps (empty: all apps) and [begin_time, end_time).
+//
+// @return - nullptr if there is no usable index or it would not skip
+//   anything, in which case the trace should be opened with open_trace().
+std::unique_ptr<trace_reader> open_indexed_trace(
+    const std::string &path, const std::set<uint32_t> &apps,
+    double begin_time, double end_time);
+
+#endif
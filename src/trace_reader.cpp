@@ -0,0 +1,176 @@
+#include <iostream>
+#include <cstdlib>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "trace_reader.h"
+#include "parallel_trace_reader.h"
+#include "compressed_trace_reader.h"
+
+uint64_t trace_reader::skip(uint64_t n)
+{
+  std::vector<Request> batch(4096);
+  uint64_t skipped = 0;
+  while (skipped < n)
+  {
+    const size_t got =
+        read(batch.data(), size_t(std::min<uint64_t>(batch.size(), n - skipped)));
+    if (got == 0)
+      break;
+    skipped += got;
+  }
+  return skipped;
+}
+
+csv_trace_reader::csv_trace_reader(const std::string &path)
+    : fd{open(path.c_str(), O_RDONLY)}, buf(CHUNK_SIZE), pos{}, len{},
+      eof{false}, bytes_read{}
+{
+  if (fd < 0)
+  {
+    std::cerr << "Couldn't open trace " << path << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+}
+
+csv_trace_reader::~csv_trace_reader()
+{
+  close(fd);
+}
+
+bool csv_trace_reader::refill()
+{
+  if (eof)
+    return false;
+
+  // Slide the partial line to the front; grow if a single line fills buf.
+  memmove(buf.data(), buf.data() + pos, len - pos);
+  len -= pos;
+  pos = 0;
+  if (len == buf.size())
+    buf.resize(buf.size() * 2);
+
+  size_t got = fill(buf.data() + len, buf.size() - len);
+  if (got == 0)
+  {
+    eof = true;
+    return false;
+  }
+  len += got;
+  return true;
+}
+
+size_t csv_trace_reader::fill(char *dst, size_t n)
+{
+  ssize_t got = 0;
+  do
+  {
+    got = ::read(fd, dst, n);
+  } while (got < 0 && errno == EINTR);
+
+  return got > 0 ? got : 0;
+}
+
+size_t csv_trace_reader::read(Request *out, size_t n)
+{
+  size_t filled = 0;
+  while (filled < n)
+  {
+    const char *begin = buf.data() + pos;
+    const char *nl = static_cast<const char *>(memchr(begin, '\n', len - pos));
+    const char *end = nl;
+    if (!nl)
+    {
+      if (refill())
+        continue;
+      // Final line without a trailing newline; refill() may have moved it.
+      if (pos == len)
+        break;
+      begin = buf.data() + pos;
+      end = buf.data() + len;
+    }
+
+    out[filled] = Request{};
+    out[filled].parse(begin, end);
+    ++filled;
+
+    bytes_read += end - begin;
+    pos = (nl ? nl + 1 : end) - buf.data();
+  }
+  return filled;
+}
+
+uint64_t csv_trace_reader::skip(uint64_t n)
+{
+  uint64_t skipped = 0;
+  while (skipped < n)
+  {
+    const char *begin = buf.data() + pos;
+    const char *nl = static_cast<const char *>(memchr(begin, '\n', len - pos));
+    if (!nl)
+    {
+      if (refill())
+        continue;
+      // Final line without a trailing newline.
+      if (pos == len)
+        break;
+      nl = buf.data() + len;
+    }
+    ++skipped;
+    bytes_read += nl - begin;
+    pos = std::min<size_t>(nl + 1 - buf.data(), len);
+  }
+  return skipped;
+}
+
+bin_trace_reader::bin_trace_reader(const std::string &path)
+    : file{path}, next{}
+{
+}
+
+size_t bin_trace_reader::read(Request *out, size_t n)
+{
+  const uint64_t total = file.get_num_records();
+  if (next >= total)
+    return 0;
+  if (n > total - next)
+    n = total - next;
+
+  for (size_t i = 0; i < n; ++i)
+    bin_trace_file::to_request(file.record(next + i), &out[i]);
+  next += n;
+
+  // Keep the kernel a batch ahead of us.
+  if (next < total)
+    file.will_need(next, std::min<uint64_t>(n, total - next));
+
+  return n;
+}
+
+uint64_t bin_trace_reader::skip(uint64_t n)
+{
+  const uint64_t total = file.get_num_records();
+  n = std::min(n, total - std::min(next, total));
+  next += n;
+  return n;
+}
+
+std::unique_ptr<trace_reader> open_trace(const std::string &path,
+                                         size_t parser_threads)
+{
+  if (is_bin_trace(path))
+    return std::unique_ptr<trace_reader>{new bin_trace_reader{path}};
+  trace_compression kind = detect_trace_compression(path);
+  if (kind != trace_compression::NONE)
+    return std::unique_ptr<trace_reader>{
+        new compressed_trace_reader{path, kind}};
+  if (parser_threads > 0)
+    return std::unique_ptr<trace_reader>{
+        new parallel_trace_reader{path, parser_threads}};
+  return std::unique_ptr<trace_reader>{new csv_trace_reader{path}};
+}
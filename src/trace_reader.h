@@ -0,0 +1,108 @@
+#ifndef TRACE_READER_H
+#define TRACE_READER_H
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "bin_trace.h"
+#include "request.h"
+
+// Source of Requests for the simulator. Readers hand out Requests in trace
+// order, a batch at a time, so the driver does not care whether the trace is
+// CSV text or a converted binary trace.
+class trace_reader
+{
+public:
+  virtual ~trace_reader() {}
+
+  // Fills \a out with up to \a n Requests.
+  //
+  // @return - number of Requests filled; 0 once the trace is exhausted.
+  virtual size_t read(Request *out, size_t n) = 0;
+
+  // Number of input bytes consumed so far; used for progress reporting.
+  virtual size_t get_bytes_read() const = 0;
+
+  // Skips the next \a n Requests, e.g. those a checkpoint (see
+  // checkpoint.h) has simulated already. Reads and drops them unless the
+  // reader can do better.
+  //
+  // @return - number of Requests skipped; less than \a n only at the end
+  //           of the trace.
+  virtual uint64_t skip(uint64_t n);
+
+  // If non-zero every kid in the trace is below this (see csv2bin -d), so
+  // per-key state can live in a table of this many entries.
+  virtual uint64_t get_key_space() const { return 0; }
+};
+
+// Reads the CSV trace format. The file is read in large chunks and each line
+// is parsed in place with Request::parse(const char *, const char *); no
+// memory is allocated per line.
+class csv_trace_reader : public trace_reader
+{
+public:
+  explicit csv_trace_reader(const std::string &path);
+  ~csv_trace_reader();
+
+  size_t read(Request *out, size_t n);
+  size_t get_bytes_read() const { return bytes_read; }
+
+  // Skips whole lines without parsing them.
+  uint64_t skip(uint64_t n);
+
+protected:
+  // Copies up to \a n bytes of trace text into \a dst. Reads the file
+  // directly; compressed_trace_reader overrides it to hand out decompressed
+  // text instead.
+  //
+  // @return - number of bytes copied; 0 at the end of the trace.
+  virtual size_t fill(char *dst, size_t n);
+
+  int fd;
+
+private:
+  static constexpr size_t CHUNK_SIZE = 4 * 1024 * 1024;
+
+  // Pulls more of the trace into buf, keeping the unconsumed tail.
+  //
+  // @return - false once the end of the trace has been reached.
+  bool refill();
+
+  std::vector<char> buf;
+  size_t pos;  // start of the first unconsumed line in buf
+  size_t len;  // bytes of valid data in buf
+  bool eof;
+  size_t bytes_read;
+
+  csv_trace_reader(const csv_trace_reader &) = delete;
+  csv_trace_reader &operator=(const csv_trace_reader &) = delete;
+};
+
+// Reads a binary trace (see bin_trace.h) through a memory mapping.
+class bin_trace_reader : public trace_reader
+{
+public:
+  explicit bin_trace_reader(const std::string &path);
+
+  size_t read(Request *out, size_t n);
+  size_t get_bytes_read() const { return next * sizeof(bin_trace_record); }
+  uint64_t skip(uint64_t n);
+  uint64_t get_key_space() const { return file.get_num_keys(); }
+
+private:
+  bin_trace_file file;
+  uint64_t next;
+};
+
+// Opens \a path with the reader matching its format. gzip and zstd
+// compressed CSV traces are decompressed on the fly (see
+// compressed_trace_reader.h). Plain CSV traces are parsed on
+// \a parser_threads background threads (see parallel_trace_reader.h) when it
+// is non-zero, and on the calling thread otherwise.
+std::unique_ptr<trace_reader> open_trace(const std::string &path,
+                                         size_t parser_threads = 0);
+
+#endif
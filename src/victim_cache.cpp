@@ -1,15 +1,13 @@
 #include "victim_cache.h"
 
-static bool file_defined = false;
-static double lastRequest = 0;
-
 VictimCache::VictimCache(stats stat) : Policy(stat),
 									   dram(),
 									   flash(),
-									   allObjects(),
+									   allObjects(stat.key_space),
 									   dramSize(0),
 									   flashSize(0),
 									   missed_bytes(0),
+									   lastRequest(0),
 									   out()
 {
 }
@@ -28,9 +26,9 @@ size_t VictimCache::process_request(const Request *r, bool warmup)
 
 	auto searchRKId = allObjects.find(r->kid);
 	bool hitFlash = false;
-	if (searchRKId != allObjects.end()) // 找到了
+	if (searchRKId) // 找到了
 	{
-		FlashCache::Item &item = searchRKId->second;
+		FlashCache::Item &item = *searchRKId;
 		if (item.isInDram) // 在dram中
 		{
 			dram.erase(item.dramLruIt);
@@ -57,7 +55,11 @@ size_t VictimCache::process_request(const Request *r, bool warmup)
 				}
 			}
 			// 将item重新插入到dram lru头部
-			insertToDram(item, warmup);
+			// insertToDram() may evict other items from allObjects and so
+			// move this one; it works on a copy that is written back.
+			FlashCache::Item hit = item;
+			insertToDram(hit, warmup);
+			*allObjects.find(hit.kId) = hit;
 			return 1;
 		}
 		else // 请求的大小与item的大小不同，即有更新，则先删除
@@ -71,7 +73,7 @@ size_t VictimCache::process_request(const Request *r, bool warmup)
 	newItem.kId = r->kid;
 	newItem.size = r->size();
 	newItem.isInDram = true;
-	assert(((unsigned int)newItem.size) <= DRAM_SIZE);
+	assert(((unsigned int)newItem.size) <= stat.config.dram_size);
 	insertToDram(newItem, warmup);
 	allObjects[newItem.kId] = newItem;
 	if (!warmup)
@@ -84,16 +86,16 @@ size_t VictimCache::process_request(const Request *r, bool warmup)
 void VictimCache::insertToDram(FlashCache::Item &item, bool warmup)
 {
 	// 若dram容量不足，则将dram中的最久未使用的item移动到flash中
-	while (item.size + dramSize > DRAM_SIZE)
+	while (item.size + dramSize > stat.config.dram_size)
 	{
 		// dram队尾的item
 		uint32_t lruDramItemKey = dram.back();
-		FlashCache::Item &lruDramItem = allObjects[lruDramItemKey];
+		const int32_t lruDramItemSize = allObjects[lruDramItemKey].size;
 		// 从dram中移除
-		dram.erase(lruDramItem.dramLruIt);
-		dramSize -= lruDramItem.size;
+		dram.erase(allObjects[lruDramItemKey].dramLruIt);
+		dramSize -= lruDramItemSize;
 		// 若flash容量不够，则进行驱逐
-		while (lruDramItem.size + flashSize > FLASH_SIZE)
+		while (lruDramItemSize + flashSize > stat.config.flash_size)
 		{
 			// flash队尾的item
 			uint32_t flashDramItemKey = flash.back();
@@ -103,6 +105,8 @@ void VictimCache::insertToDram(FlashCache::Item &item, bool warmup)
 			allObjects.erase(lruFlashItem.kId);
 		}
 		// 将lruDramItem移动到flash中
+		// (only looked up now: erasing from allObjects may move its values)
+		FlashCache::Item &lruDramItem = allObjects[lruDramItemKey];
 		flash.emplace_front(lruDramItemKey);
 		lruDramItem.flashIt = flash.begin();
 		lruDramItem.isInDram = false;
@@ -133,15 +137,14 @@ void VictimCache::dump_stats(void)
 			appids += std::to_string(app) + ",";
 	}
 	appids = appids.substr(0, appids.length() - 1);
-	std::string filename{stat.policy + "-app" + appids + "-flash_mem" + std::to_string(FLASH_SIZE) + "-dram_mem" + std::to_string(DRAM_SIZE)};
-	if (!file_defined)
+	std::string filename{stat.policy + "-app" + appids + "-flash_mem" + std::to_string(stat.config.flash_size) + "-dram_mem" + std::to_string(stat.config.dram_size)};
+	if (!out.is_open())
 	{
 		out.open(filename);
-		file_defined = true;
 	}
 	out << "Last Request was at :" << lastRequest << std::endl;
-	out << "dram size " << DRAM_SIZE << std::endl;
-	out << "flash size " << FLASH_SIZE << std::endl;
+	out << "dram size " << stat.config.dram_size << std::endl;
+	out << "flash size " << stat.config.flash_size << std::endl;
 	out << "#accesses " << stat.accesses << std::endl;
 	out << "#global hits " << stat.hits << std::endl;
 	out << "#dram hits " << stat.hits_dram << std::endl;
@@ -7,23 +7,26 @@
 #include <cassert>
 #include "policy.h"
 #include "flash_cache.h"
+#include "key_map.h"
 
 // VictimCache直接维护一个dram lru和一个flash list，dram中从lru尾部驱逐的对象全部插入flash
 // dram和flash中被重复访问的对象会被重新插入到dram lru头部
 class VictimCache : public Policy
 {
 private:
-	typedef std::list<uint32_t>::iterator keyIt;
+	typedef counted_list<uint32_t, mem_tag::queue> key_list;
+	typedef key_list::iterator keyIt;
 
-	std::list<uint32_t> dram;
-	std::list<uint32_t> flash;
+	key_list dram;
+	key_list flash;
 
-	std::unordered_map<uint32_t, FlashCache::Item> allObjects;
+	key_map<FlashCache::Item> allObjects;
 
 	size_t dramSize;
 	size_t flashSize;
 
 	size_t missed_bytes;
+	double lastRequest;
 
 	std::ofstream out;
 	void insertToDram(FlashCache::Item &item, bool warmup);
@@ -0,0 +1,424 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <set>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <fcntl.h>
+#include <malloc.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "../src/common.h"
+#include "../src/lsm-sim.h"
+#include "../src/request.h"
+#include "../src/trace_reader.h"
+
+// Measures the speed and memory use of the simulator itself, so changes to
+// it can be checked for regressions (make bench).
+//
+// Every selected policy runs on every request stream at every cache size;
+// each run is a child process of its own, so runs don't share allocator
+// state or the globals some policies keep, and their peak RSS is their own.
+// Streams are synthetic (uniform and Zipf popularity over dense kids) or the
+// Requests lsm-sim would simulate from a trace given with -f. Cache sizes
+// are fractions of a stream's working set, the bytes of all its keys.
+//
+// Results go to stdout as JSON, one object per run:
+//
+//   policy, stream, cache_bytes, requests, seconds, requests_per_second,
+//   ns_per_request, hit_rate, peak_rss_bytes, metadata_bytes,
+//   metadata_bytes_per_object
+//
+// seconds only covers Policy::process_batch(), in runs of
+// policy_batch_size Requests like lsm-sim. metadata_bytes is the heap the
+// Policy holds after the stream, and metadata_bytes_per_object divides it
+// by the objects the cache holds when full (cache_bytes over the stream's
+// mean Request size). peak_rss_bytes includes the stream itself, about 40
+// bytes per Request. A run that fails gets an "error" instead.
+
+namespace {
+
+const char *usage =
+    "usage: lsm-bench [-n requests] [-k keys] [-f trace]... [-p policy]...\n"
+    "                 [-s fraction,...]\n"
+    "  -n  Requests per stream (default 1000000)\n"
+    "  -k  keys of the synthetic streams (default 100000)\n"
+    "  -f  also run on the first -n Requests lsm-sim simulates from a trace\n"
+    "  -S  only run the recorded streams\n"
+    "  -p  policy to run (default: every cache policy lsm-sim has)\n"
+    "  -s  cache sizes as fractions of the working set "
+    "(default 0.01,0.05,0.25)\n";
+
+// Options the policies need beyond -p and -s, for a cache of \a size bytes
+// and Requests of up to \a largest bytes.
+std::vector<std::string> policy_options(const std::string &name, size_t size,
+                                        size_t largest)
+{
+  const std::string dram = std::to_string(size / 4);
+  const std::string flash = std::to_string(size - size / 4);
+  // Segments and blocks have to hold the largest Request.
+  const std::string unit = std::to_string(std::max(size / 64, largest + 1));
+
+  if (name == "lsm" || name == "multi")
+    return {"-S", unit, "-c", "2"};
+  if (name == "ripq")
+    return {"-F", std::to_string(size), "-B", unit, "-n", "4"};
+  if (name == "ripq_shield")
+    return {"-D", dram, "-d", "2", "-F", flash, "-B", unit, "-n", "4"};
+  if (name == "ramshield" || name == "ramshield_fifo" ||
+      name == "ramshield_sel")
+    return {"-D", dram, "-F", flash, "-B", unit};
+  if (name == "lruk")
+    return {"-K", "4", "-L", std::to_string(size / 4)};
+  if (name == "partitioned_LRU")
+    return {"-Y", "4"};
+  // Flash policies take -s from -D and -F, which have to come first.
+  if (find_policy(name)->flash)
+    return {"-D", dram, "-F", flash};
+  return {};
+}
+
+struct stream
+{
+  std::string name;
+  std::vector<Request> requests;
+  std::set<uint32_t> apps;
+  size_t key_space;      // kids are dense below this; 0 if they aren't
+  size_t working_set;    // bytes of all keys, at their last size
+  double mean_size;      // of the Requests
+  size_t largest;        // Request
+};
+
+void describe(stream &s)
+{
+  std::unordered_map<uint32_t, int32_t> sizes{};
+  double total = 0;
+  s.largest = 0;
+  for (const Request &r : s.requests)
+  {
+    sizes[r.kid] = r.size();
+    total += r.size();
+    s.largest = std::max(s.largest, size_t(r.size()));
+    s.apps.insert(r.appid);
+  }
+  s.working_set = 0;
+  for (const auto &key : sizes)
+    s.working_set += key.second;
+  s.mean_size = s.requests.empty() ? 0 : total / s.requests.size();
+}
+
+// Requests for \a keys dense kids of random sizes, app 19 (which multi and
+// multislab know), one per millisecond. \a skew 0 is uniform popularity;
+// anything else is Zipf with that exponent, with popular keys spread over
+// the kids.
+stream synthetic_stream(const std::string &name, size_t n, size_t keys,
+                        double skew)
+{
+  std::mt19937_64 rng{42};
+  std::vector<int32_t> value_sizes(keys);
+  for (int32_t &size : value_sizes)
+    size = 64 + int32_t(rng() % 1985);
+  std::vector<uint32_t> kids(keys);
+  for (size_t i = 0; i < keys; ++i)
+    kids[i] = uint32_t(i);
+  std::shuffle(kids.begin(), kids.end(), rng);
+
+  std::vector<double> cdf(keys);
+  double sum = 0;
+  for (size_t i = 0; i < keys; ++i)
+  {
+    sum += skew == 0 ? 1 : 1 / std::pow(double(i + 1), skew);
+    cdf[i] = sum;
+  }
+
+  stream s{};
+  s.name = name;
+  s.key_space = keys;
+  s.requests.resize(n);
+  std::uniform_real_distribution<double> uniform{0, sum};
+  for (size_t i = 0; i < n; ++i)
+  {
+    const size_t rank =
+        std::lower_bound(cdf.begin(), cdf.end(), uniform(rng)) - cdf.begin();
+    Request &r = s.requests[i];
+    r.time = i / 1000.;
+    r.appid = 19;
+    r.type = Request::GET;
+    r.kid = kids[std::min(rank, keys - 1)];
+    r.key_sz = 32;
+    r.val_sz = value_sizes[r.kid];
+    r.frag_sz = 0;
+    r.hit = 0;
+  }
+  describe(s);
+  return s;
+}
+
+// The first \a n Requests of \a path that lsm-sim simulates.
+stream recorded_stream(const std::string &path, size_t n)
+{
+  std::unique_ptr<trace_reader> reader = open_trace(path);
+  stream s{};
+  s.name = path.substr(path.find_last_of('/') + 1);
+  s.key_space = reader->get_key_space();
+  const size_t max_size = Args{}.max_overall_request_size;
+  std::vector<Request> batch(4096);
+  size_t read = 0;
+  while (s.requests.size() < n &&
+         (read = reader->read(batch.data(), batch.size())) > 0)
+  {
+    for (size_t i = 0; i < read && s.requests.size() < n; ++i)
+    {
+      const Request &r = batch[i];
+      if (r.type != Request::GET || r.val_sz <= 0 ||
+          size_t(r.key_sz + r.val_sz) > max_size)
+        continue;
+      s.requests.push_back(r);
+    }
+  }
+  if (s.requests.empty())
+  {
+    std::cerr << "No Requests to simulate in " << path << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  describe(s);
+  return s;
+}
+
+// JSON has no NaN or infinity (e.g. the hit rate of policies that don't
+// count hits).
+std::string json_number(double x)
+{
+  if (!std::isfinite(x))
+    return "null";
+  std::ostringstream ss{};
+  ss << x;
+  return ss.str();
+}
+
+// What a run's child hands back through a pipe.
+struct run_result
+{
+  double seconds;
+  double hit_rate;
+  uint64_t metadata_bytes;
+};
+
+uint64_t heap_in_use()
+{
+  const struct mallinfo2 info = mallinfo2();
+  return info.uordblks + info.hblkhd;
+}
+
+// Runs \a policy on \a s with a cache of \a size bytes; called in the child.
+run_result run(const std::string &policy, const stream &s, size_t size)
+{
+  Args args{};
+  calculate_global_memory(args);
+  std::vector<std::string> tokens = policy_options(policy, size, s.largest);
+  for (const std::string &t : {std::string{"-p"}, policy, std::string{"-s"},
+                               std::to_string(size)})
+    tokens.push_back(t);
+  parse_tokens(args, tokens);
+  args.apps = s.apps;
+  args.all_apps = false;
+  args.key_space = s.key_space;
+  args.hit_start_time = 0;
+
+  const uint64_t heap = heap_in_use();
+  std::unique_ptr<Policy> p = create_Policy(args);
+  const auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < s.requests.size(); i += policy_batch_size)
+  {
+    p->process_batch(&s.requests[i],
+                     std::min(policy_batch_size, s.requests.size() - i),
+                     false);
+  }
+  const auto stop = std::chrono::steady_clock::now();
+
+  run_result result{};
+  result.seconds = std::chrono::duration<double>(stop - start).count();
+  result.hit_rate = p->get_stats()->get_hit_rate();
+  const uint64_t held = heap_in_use();
+  result.metadata_bytes = held > heap ? held - heap : 0;
+  return result;
+}
+
+// Runs \a policy in a child process and writes its JSON object to stdout.
+void bench(const std::string &policy, const stream &s, size_t size,
+           bool first)
+{
+  int fds[2];
+  if (pipe(fds) != 0)
+  {
+    perror("pipe");
+    exit(EXIT_FAILURE);
+  }
+  std::cout.flush();
+  const pid_t pid = fork();
+  if (pid < 0)
+  {
+    perror("fork");
+    exit(EXIT_FAILURE);
+  }
+  if (pid == 0)
+  {
+    // Policies print as they go; stdout is ours.
+    close(fds[0]);
+    const int null = open("/dev/null", O_WRONLY);
+    dup2(null, STDOUT_FILENO);
+    const run_result result = run(policy, s, size);
+    if (write(fds[1], &result, sizeof(result)) != sizeof(result))
+      _exit(EXIT_FAILURE);
+    _exit(EXIT_SUCCESS);
+  }
+
+  close(fds[1]);
+  run_result result{};
+  const bool got = read(fds[0], &result, sizeof(result)) == sizeof(result);
+  close(fds[0]);
+  int status = 0;
+  struct rusage usage{};
+  wait4(pid, &status, 0, &usage);
+
+  std::ostringstream json{};
+  json << (first ? "\n" : ",\n") << "    {\"policy\": \"" << policy
+       << "\", \"stream\": \"" << s.name << "\", \"cache_bytes\": " << size
+       << ", \"requests\": " << s.requests.size();
+  if (got && WIFEXITED(status) && WEXITSTATUS(status) == EXIT_SUCCESS)
+  {
+    const double objects = s.mean_size > 0 ? size / s.mean_size : 0;
+    json << ", \"seconds\": " << json_number(result.seconds)
+         << ", \"requests_per_second\": "
+         << json_number(s.requests.size() / result.seconds)
+         << ", \"ns_per_request\": "
+         << json_number(result.seconds * 1e9 / s.requests.size())
+         << ", \"hit_rate\": " << json_number(result.hit_rate)
+         << ", \"peak_rss_bytes\": " << uint64_t(usage.ru_maxrss) * 1024
+         << ", \"metadata_bytes\": " << result.metadata_bytes
+         << ", \"metadata_bytes_per_object\": "
+         << json_number(objects > 0 ? result.metadata_bytes / objects : 0)
+         << "}";
+    std::cerr << policy << " " << s.name << " " << size << ": "
+              << result.seconds * 1e9 / s.requests.size() << " ns/request"
+              << std::endl;
+  }
+  else
+  {
+    const std::string error =
+        WIFSIGNALED(status)
+            ? "killed by signal " + std::to_string(WTERMSIG(status))
+            : "exit status " + std::to_string(WEXITSTATUS(status));
+    json << ", \"error\": \"" << error << "\"}";
+    std::cerr << policy << " " << s.name << " " << size << ": " << error
+              << std::endl;
+  }
+  std::cout << json.str();
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+  size_t n = 1000000;
+  size_t keys = 100000;
+  bool synthetic = true;
+  std::vector<std::string> traces{};
+  std::vector<std::string> policies{};
+  std::vector<double> fractions{0.01, 0.05, 0.25};
+
+  int c;
+  while ((c = getopt(argc, argv, "n:k:f:Sp:s:")) != -1)
+  {
+    switch (c)
+    {
+    case 'n':
+      n = atol(optarg);
+      break;
+    case 'k':
+      keys = atol(optarg);
+      break;
+    case 'f':
+      traces.push_back(optarg);
+      break;
+    case 'S':
+      synthetic = false;
+      break;
+    case 'p':
+      if (!find_policy(optarg) || !find_policy(optarg)->create)
+      {
+        std::cerr << "Invalid Policy " << optarg << std::endl;
+        return EXIT_FAILURE;
+      }
+      policies.push_back(optarg);
+      break;
+    case 's':
+    {
+      string_vec v;
+      csv_tokenize(std::string(optarg), &v);
+      fractions.clear();
+      for (const std::string &f : v)
+        fractions.push_back(atof(f.c_str()));
+      break;
+    }
+    default:
+      std::cerr << usage;
+      return EXIT_FAILURE;
+    }
+  }
+  if (optind != argc || n == 0 || keys == 0 ||
+      (!synthetic && traces.empty()))
+  {
+    std::cerr << usage;
+    return EXIT_FAILURE;
+  }
+
+  // By default every policy that caches: not the stack distance analyses
+  // (which log curves) or the ones that need an SVM model.
+  if (policies.empty())
+  {
+    for (const policy_entry &entry : policy_registry)
+    {
+      if (entry.create && !entry.curves && !entry.single_instance)
+        policies.push_back(entry.name);
+    }
+  }
+
+  std::vector<stream> streams{};
+  if (synthetic)
+  {
+    streams.push_back(synthetic_stream("uniform", n, keys, 0));
+    streams.push_back(synthetic_stream("zipf", n, keys, 0.99));
+  }
+  for (const std::string &trace : traces)
+    streams.push_back(recorded_stream(trace, n));
+
+  std::cout << "{\n  \"results\": [";
+  bool first = true;
+  for (const stream &s : streams)
+  {
+    for (const double fraction : fractions)
+    {
+      const size_t size = size_t(s.working_set * fraction);
+      for (const std::string &policy : policies)
+      {
+        bench(policy, s, size, first);
+        first = false;
+      }
+    }
+  }
+  std::cout << "\n  ]\n}" << std::endl;
+  return EXIT_SUCCESS;
+}
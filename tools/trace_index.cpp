@@ -0,0 +1,27 @@
+#include <iostream>
+#include <string>
+#include <cstdlib>
+
+#include "../src/trace_index.h"
+
+// Builds the sidecar seek index (<trace>.idx, see src/trace_index.h) that
+// lets lsm-sim read only the lines of the apps selected with -a and of the
+// time window selected with -b/-e.
+int main(int argc, char *argv[])
+{
+  if (argc != 2 && argc != 3)
+  {
+    std::cerr << "usage: " << argv[0] << " <trace> [<index>]" << std::endl
+              << "  the index defaults to <trace>.idx, where lsm-sim looks "
+              << "for it" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  const std::string trace{argv[1]};
+  const std::string index = argc == 3 ? argv[2] : trace + ".idx";
+  uint64_t lines = build_trace_index(trace, index);
+
+  std::cerr << "indexed " << lines << " lines into " << index << std::endl;
+
+  return EXIT_SUCCESS;
+}